@@ -0,0 +1,147 @@
+#include <server.h>
+#include <commandstats.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Нагрузочный клиент для режима solver --serve: каждое соединение шлёт команды solve,
+// держа не больше window неотвеченных, и замеряет время до ответа на каждую
+// Использование: loadgen [-c clients] [-n requests] [-w window] address
+
+typedef std::chrono::steady_clock Clock;
+
+struct ClientResult {
+    LatencyHistogram latency;
+    std::size_t answered = 0;
+    std::string error;
+};
+
+static bool sendAll(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t size = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (size <= 0) {
+            return false;
+        }
+        sent += size;
+    }
+    return true;
+}
+
+static void runClient(const std::string& address, std::size_t requests, std::size_t window, unsigned seed,
+                      ClientResult* result) {
+    int fd = Server::connect(address, &result->error);
+    if (fd < 0) {
+        return;
+    }
+    // Без подсказок и сообщений каждая команда solve отвечает ровно одной строкой
+    if (!sendAll(fd, "set verbosity ERROR\n")) {
+        result->error = "Connection closed";
+        close(fd);
+        return;
+    }
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> coefficient(-1000, 1000);
+    std::deque<Clock::time_point> inFlight;
+    std::size_t sent = 0;
+    std::string input;
+    char buffer[65536];
+    while (result->answered < requests) {
+        std::string batch;
+        while (sent < requests && inFlight.size() < window) {
+            batch += "solve 1 " + std::to_string(coefficient(gen)) + ' ' + std::to_string(coefficient(gen)) + '\n';
+            inFlight.push_back(Clock::now());
+            ++sent;
+        }
+        if (!batch.empty() && !sendAll(fd, batch)) {
+            result->error = "Connection closed";
+            break;
+        }
+
+        ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        if (size <= 0) {
+            result->error = "Connection closed";
+            break;
+        }
+        input.append(buffer, size);
+        std::size_t begin = 0;
+        std::size_t end;
+        Clock::time_point now = Clock::now();
+        while ((end = input.find('\n', begin)) != std::string::npos) {
+            result->latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - inFlight.front()).count());
+            inFlight.pop_front();
+            ++result->answered;
+            begin = end + 1;
+        }
+        input.erase(0, begin);
+    }
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t clients = 8;
+    std::size_t requests = 100000;
+    std::size_t window = 32;
+    const char* address = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            clients = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            requests = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            window = std::strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-' && address == nullptr) {
+            address = argv[i];
+        } else {
+            address = nullptr;
+            break;
+        }
+    }
+    if (address == nullptr) {
+        std::fprintf(stderr, "Usage: %s [-c clients] [-n requests] [-w window] unix:<path> | tcp:<port>\n", argv[0]);
+        return 1;
+    }
+    if (clients == 0 || requests == 0 || window == 0) {
+        std::fprintf(stderr, "Number of clients, requests and window should be positive\n");
+        return 1;
+    }
+
+    // requests --- общее число команд, они делятся между соединениями поровну
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < clients; ++i) {
+        std::size_t share = requests / clients + (i < requests % clients ? 1 : 0);
+        threads.emplace_back(runClient, std::string(address), share, window, unsigned(2018 + i), &results[i]);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    LatencyHistogram latency;
+    std::size_t answered = 0;
+    for (const auto& result : results) {
+        if (!result.error.empty()) {
+            std::fprintf(stderr, "%s\n", result.error.c_str());
+            return 1;
+        }
+        answered += result.answered;
+        latency.merge(result.latency);
+    }
+
+    std::printf("clients: %zu, requests: %zu, window: %zu\n", clients, answered, window);
+    std::printf("%.0f req/s, latency us: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", answered / seconds,
+                latency.percentile(0.5) / 1000.0, latency.percentile(0.9) / 1000.0,
+                latency.percentile(0.99) / 1000.0, latency.max() / 1000.0);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <numparse.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// Сравнивает скорость parseDouble и strtod на случайных токенах
+// Использование: parse_bench [number-of-tokens]
+
+template <class Parse>
+static double measure(const std::vector<std::string>& tokens, Parse parse, double* checksum) {
+    auto start = std::chrono::steady_clock::now();
+    double sum = 0;
+    for (const auto& token : tokens) {
+        sum += parse(token);
+    }
+    auto finish = std::chrono::steady_clock::now();
+    *checksum = sum;
+    return std::chrono::duration<double, std::nano>(finish - start).count() / tokens.size();
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    std::mt19937 gen(2018);
+    std::uniform_real_distribution<double> dist(-1000, 1000);
+    std::uniform_int_distribution<int> precision(1, 17);
+    std::vector<std::string> tokens;
+    tokens.reserve(count);
+    char buffer[64];
+    for (std::size_t i = 0; i < count; ++i) {
+        std::snprintf(buffer, sizeof(buffer), "%.*g", precision(gen), dist(gen));
+        tokens.push_back(buffer);
+    }
+
+    double strtodSum, parseSum;
+    double strtodNs = measure(tokens, [](const std::string& token) {
+        return std::strtod(token.c_str(), nullptr);
+    }, &strtodSum);
+    double parseNs = measure(tokens, [](const std::string& token) {
+        bool ok;
+        return parseDouble(token, &ok);
+    }, &parseSum);
+
+    std::printf("tokens:      %zu\n", count);
+    std::printf("strtod:      %.1f ns/op\n", strtodNs);
+    std::printf("parseDouble: %.1f ns/op\n", parseNs);
+    std::printf("speedup:     %.2fx\n", strtodNs / parseNs);
+    if (strtodSum != parseSum) {
+        std::printf("checksums differ!\n");
+        return 1;
+    }
+    return 0;
+}
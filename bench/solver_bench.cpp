@@ -0,0 +1,384 @@
+#include <console.h>
+#include <solverapp.h>
+#include <batchsolverapp.h>
+#include <numparse.h>
+#include <resultwriter.h>
+#include <solver.h>
+#include <tokenizer.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Микробенчмарки этапов конвейера (разбиение на токены, разбор, решение, вывод,
+// диспетчеризация команды) и сквозные прогоны на синтетических нагрузках
+// Использование: solver_bench [-n equations] [-r repeats] [-o result.json] [-b baseline.json] [filter]
+
+#ifndef BENCH_BUILD_TYPE
+#define BENCH_BUILD_TYPE "unknown"
+#endif
+
+static std::atomic<std::size_t> allocationCount(0);
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// Не даёт компилятору выбросить вычисления, результат которых не используется
+static volatile double sink;
+
+struct Result {
+    std::string name;
+    std::size_t ops;
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+// Поток, отбрасывающий всё записанное
+class NullBuffer : public std::streambuf {
+    protected:
+        std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+        int overflow(int c) override { return c; }
+};
+
+// Команда, которая ничего не делает: измеряет только диспетчеризацию
+class NoopApp : public IApp {
+    public:
+        static constexpr const char* COMMAND = "noop";
+        NoopApp(Console*) {}
+        using IApp::exec;
+        virtual int exec(ArgList) { return STATUS_OK; }
+        virtual const char* getStatusCodeDescription(int) { return "OK"; }
+        virtual const char* getHelp() { return ""; }
+};
+
+class Bench {
+    public:
+        Bench(int repeats, const std::string& filter) : repeats_(repeats), filter_(filter) {}
+
+        // Выполняет body() repeats_ раз и запоминает лучшее время; body обрабатывает ops операций
+        void run(const std::string& name, std::size_t ops, const std::function<void()>& body) {
+            if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+                return;
+            }
+            double best = 0;
+            std::size_t allocations = 0;
+            for (int r = 0; r < repeats_; ++r) {
+                std::size_t before = allocationCount.load();
+                auto start = std::chrono::steady_clock::now();
+                body();
+                auto finish = std::chrono::steady_clock::now();
+                double ns = std::chrono::duration<double, std::nano>(finish - start).count();
+                if (r == 0 || ns < best) {
+                    best = ns;
+                    allocations = allocationCount.load() - before;
+                }
+            }
+            Result result = {name, ops, best / ops, double(allocations) / ops};
+            std::printf("%-28s %12.1f ns/op %14.0f op/s %10.3f allocs/op\n",
+                        name.c_str(), result.nsPerOp, 1e9 / result.nsPerOp, result.allocsPerOp);
+            results_.push_back(result);
+        }
+
+        const std::vector<Result>& results() const { return results_; }
+
+    private:
+        int repeats_;
+        std::string filter_;
+        std::vector<Result> results_;
+};
+
+// Коэффициенты синтетических уравнений в виде токенов
+static std::vector<std::string> makeTokens(std::size_t count, bool complex, bool degenerate, std::mt19937& gen) {
+    std::uniform_real_distribution<double> dist(-1000, 1000);
+    std::uniform_int_distribution<int> precision(1, 17);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<std::string> tokens;
+    tokens.reserve(count);
+    char buffer[128];
+    for (std::size_t i = 0; i < count; ++i) {
+        // В вырожденной нагрузке большинство коэффициентов --- нули
+        if (degenerate && percent(gen) < 70) {
+            tokens.push_back("0");
+        } else if (complex) {
+            double im = dist(gen);
+            std::snprintf(buffer, sizeof(buffer), "%.*g%+.*gj", precision(gen), dist(gen), precision(gen), im);
+            tokens.push_back(buffer);
+        } else {
+            std::snprintf(buffer, sizeof(buffer), "%.*g", precision(gen), dist(gen));
+            tokens.push_back(buffer);
+        }
+    }
+    return tokens;
+}
+
+static std::string makeScript(const std::vector<std::string>& tokens, const char* command) {
+    std::string script;
+    for (std::size_t i = 0; i + 2 < tokens.size(); i += 3) {
+        script += command;
+        for (int k = 0; k < 3; ++k) {
+            script += ' ';
+            script += tokens[i + k];
+        }
+        script += '\n';
+    }
+    return script;
+}
+
+// Прогоняет сценарий через Console::exec так же, как это делает solver с отображённым файлом
+static void runScript(const std::string& script, const char* field, const char* stats = "on") {
+    NullBuffer buffer;
+    std::ostream out(&buffer);
+    std::istringstream in;
+    Console console(in, out);
+    console.setVariable("verbosity", "ERROR");
+    console.setVariable("field", field);
+    console.setVariable("stats", stats);
+    console.installApps<SolverApp, BatchSolverApp>();
+    console.setInputBuffer(script.data(), script.size());
+    console.exec(0, nullptr);
+}
+
+static void writeJson(const std::string& fileName, std::size_t equations, const std::vector<Result>& results) {
+    std::ofstream out(fileName);
+    out.precision(6);
+    out << "{\n";
+    out << "  \"build_type\": \"" << BENCH_BUILD_TYPE << "\",\n";
+    out << "  \"equations\": " << equations << ",\n";
+    out << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+            << ", \"ns_per_op\": " << r.nsPerOp << ", \"ops_per_sec\": " << 1e9 / r.nsPerOp
+            << ", \"allocs_per_op\": " << r.allocsPerOp << "}" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n}\n";
+}
+
+// Читает результаты, записанные writeJson (по одному результату в строке)
+static bool readJson(const std::string& fileName, std::map<std::string, double>* nsPerOp) {
+    std::ifstream in(fileName);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::size_t name = line.find("\"name\": \"");
+        std::size_t ns = line.find("\"ns_per_op\": ");
+        if (name == std::string::npos || ns == std::string::npos) {
+            continue;
+        }
+        name += std::strlen("\"name\": \"");
+        std::string key = line.substr(name, line.find('"', name) - name);
+        (*nsPerOp)[key] = std::strtod(line.c_str() + ns + std::strlen("\"ns_per_op\": "), nullptr);
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t equations = 200000;
+    int repeats = 3;
+    const char* outFName = nullptr;
+    const char* baselineFName = nullptr;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            equations = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeats = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outFName = argv[++i];
+        } else if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            baselineFName = argv[++i];
+        } else if (argv[i][0] != '-') {
+            filter = argv[i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [-n equations] [-r repeats] [-o result.json] [-b baseline.json] [filter]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (equations == 0 || repeats <= 0) {
+        std::fprintf(stderr, "Number of equations and repeats should be positive\n");
+        return 1;
+    }
+
+    std::printf("build type: %s, equations: %zu, repeats: %d\n", BENCH_BUILD_TYPE, equations, repeats);
+    std::mt19937 gen(2018);
+    std::vector<std::string> realTokens = makeTokens(equations * 3, false, false, gen);
+    std::vector<std::string> complexTokens = makeTokens(equations * 3, true, false, gen);
+    std::vector<std::string> degenerateTokens = makeTokens(equations * 3, false, true, gen);
+
+    Bench bench(repeats, filter);
+
+    // Этапы по отдельности
+    std::string realScript = makeScript(realTokens, "solve");
+    bench.run("tokenize/solve_line", equations, [&] {
+        std::vector<std::string_view> tokens;
+        std::string_view rest(realScript);
+        std::size_t count = 0;
+        while (!rest.empty()) {
+            std::size_t length = rest.find('\n');
+            tokenize(rest.substr(0, length), &tokens);
+            count += tokens.size();
+            rest.remove_prefix(length + 1);
+        }
+        sink = count;
+    });
+
+    bench.run("parse/real", realTokens.size(), [&] {
+        double sum = 0;
+        for (const auto& token : realTokens) {
+            bool ok;
+            sum += parseReal<double>(token, &ok);
+        }
+        sink = sum;
+    });
+
+    bench.run("parse/complex", complexTokens.size(), [&] {
+        double sum = 0;
+        for (const auto& token : complexTokens) {
+            bool ok;
+            sum += parseComplex<double>(token, &ok).real();
+        }
+        sink = sum;
+    });
+
+    std::vector<std::array<double, 3>> realEquations(equations);
+    std::vector<std::array<std::complex<double>, 3>> complexEquations(equations);
+    std::vector<std::array<double, 3>> degenerateEquations(equations);
+    for (std::size_t i = 0; i < equations; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            bool ok;
+            realEquations[i][k] = parseReal<double>(realTokens[3 * i + k], &ok);
+            complexEquations[i][k] = parseComplex<double>(complexTokens[3 * i + k], &ok);
+            degenerateEquations[i][k] = parseReal<double>(degenerateTokens[3 * i + k], &ok);
+        }
+    }
+
+    bench.run("solve/real", equations, [&] {
+        double sum = 0;
+        for (const auto& eq : realEquations) {
+            sum += solveSquare(eq).size();
+        }
+        sink = sum;
+    });
+
+    bench.run("solve/complex", equations, [&] {
+        double sum = 0;
+        for (const auto& eq : complexEquations) {
+            sum += solveSquare(eq).size();
+        }
+        sink = sum;
+    });
+
+    bench.run("solve/degenerate", equations, [&] {
+        double sum = 0;
+        for (const auto& eq : degenerateEquations) {
+            sum += solveSquare(eq).size();
+        }
+        sink = sum;
+    });
+
+    std::string text;
+    text.reserve(1 << 20);
+    bench.run("format/real", equations, [&] {
+        for (const auto& eq : realEquations) {
+            text.clear();
+            ResultWriter out(text);
+            out << eq[0] << ' ' << eq[1] << '\n';
+        }
+    });
+
+    bench.run("format/complex", equations, [&] {
+        for (const auto& eq : complexEquations) {
+            text.clear();
+            ResultWriter out(text);
+            out << eq[0] << ' ' << eq[1] << '\n';
+        }
+    });
+
+    {
+        std::istringstream in;
+        NullBuffer buffer;
+        std::ostream out(&buffer);
+        Console console(in, out);
+        console.installApps<NoopApp>();
+        std::vector<std::string_view> args = {"noop", "1", "2", "3"};
+        bench.run("dispatch/noop", equations, [&] {
+            for (std::size_t i = 0; i < equations; ++i) {
+                console.execApp(console.findApp(args[0]), ArgList(args));
+            }
+        });
+    }
+
+    // Сквозные прогоны: сценарий из команд solve и большой файл для solvebatch
+    std::string complexScript = makeScript(complexTokens, "solve");
+    std::string degenerateScript = makeScript(degenerateTokens, "solve");
+    bench.run("e2e/solve_real", equations, [&] { runScript(realScript, "R"); });
+    bench.run("e2e/solve_real_stats_off", equations, [&] { runScript(realScript, "R", "off"); });
+    bench.run("e2e/solve_complex", equations, [&] { runScript(complexScript, "C"); });
+    bench.run("e2e/solve_degenerate", equations, [&] { runScript(degenerateScript, "R"); });
+
+    const char* batchFName = "solver_bench_batch.txt";
+    for (const auto* set : {&realTokens, &complexTokens}) {
+        bool complex = (set == &complexTokens);
+        {
+            std::ofstream file(batchFName);
+            for (std::size_t i = 0; i + 2 < set->size(); i += 3) {
+                file << (*set)[i] << ' ' << (*set)[i + 1] << ' ' << (*set)[i + 2] << '\n';
+            }
+        }
+        std::string script = std::string("solvebatch ") + batchFName + '\n';
+        bench.run(complex ? "e2e/solvebatch_complex" : "e2e/solvebatch_real", equations, [&] {
+            runScript(script, complex ? "C" : "R");
+        });
+    }
+    std::remove(batchFName);
+
+    if (outFName != nullptr) {
+        writeJson(outFName, equations, bench.results());
+    }
+
+    if (baselineFName != nullptr) {
+        std::map<std::string, double> baseline;
+        if (!readJson(baselineFName, &baseline)) {
+            std::fprintf(stderr, "Cannot read baseline: %s\n", baselineFName);
+            return 1;
+        }
+        std::printf("\ncompared to %s:\n", baselineFName);
+        for (const auto& result : bench.results()) {
+            auto it = baseline.find(result.name);
+            if (it == baseline.end()) {
+                std::printf("%-28s %12s\n", result.name.c_str(), "new");
+            } else {
+                double speedup = it->second / result.nsPerOp;
+                std::printf("%-28s %11.2fx %s\n", result.name.c_str(), speedup, speedup >= 1 ? "faster" : "slower");
+            }
+        }
+    }
+    return 0;
+}
@@ -1,13 +1,45 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 #include <string>
+#include <string_view>
+
+/// Аргументы команды
+/**
+ * Непрерывный массив строк, не владеющий ни самими строками, ни массивом.
+ * Командный интерпретатор передаёт в приложения токены, ссылающиеся прямо
+ * на прочитанную строку, поэтому аргументы действительны только во время
+ * вызова \ref IApp::exec.
+ * */
+class ArgList {
+    public:
+        typedef const std::string_view* iterator;
+
+        ArgList(const std::string_view* data, std::size_t size) : data_(data), size_(size) {}
+
+        ArgList(const std::vector<std::string_view>& args) : data_(args.data()), size_(args.size()) {}
+
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const std::string_view& operator [](std::size_t i) const { return data_[i]; }
+        iterator begin() const { return data_; }
+        iterator end() const { return data_ + size_; }
+
+    private:
+        const std::string_view* data_;
+        std::size_t size_;
+};
 
 /// Интерфейс приложения
 /**
  * Проект представляет собой командный интерпретатор, который читает из
  * входного потока команды. За реализацию команд отвечают приложения ---
  * объекты классов, унаследованных от ```IApp```.
+ *
+ * Приложение переопределяет перегрузку ```exec``` с \ref ArgList: командный
+ * интерпретатор вызывает именно её, поэтому аргументы не копируются. Приложения,
+ * написанные для аргументов в ```std::vector<std::string>```, наследуются от \ref LegacyApp.
  * \see Console
  * */
 class IApp {
@@ -25,7 +57,15 @@ class IApp {
          * ошибка, приложение возвращает иной код. Подробнее см. описания
          * конкретных приложений.
          * */
-        virtual int exec(const std::vector<std::string>& args) = 0;
+        virtual int exec(ArgList args) = 0;
+
+        /** Запуск приложения с аргументами-строками (например, из тестов):
+         * преобразует их и вызывает перегрузку с \ref ArgList
+         * */
+        int exec(const std::vector<std::string>& args) {
+            std::vector<std::string_view> views(args.begin(), args.end());
+            return exec(ArgList(views));
+        }
 
         /** По коду ошибки возвращает текстовое описание.
          * \param [in] statusCode код, который вернуло приложение
@@ -36,3 +76,21 @@ class IApp {
          * */
         virtual const char* getHelp() = 0;
 };
+
+/// Приложение со старой сигнатурой ```exec```
+/**
+ * Переходник для приложений, принимающих аргументы в ```std::vector<std::string>```:
+ * при каждом вызове аргументы копируются в строки.
+ * */
+class LegacyApp : public IApp {
+    public:
+        /** \brief Запуск приложения
+         * \param [in] args копии аргументов команды
+         * \return Статус (см. \ref IApp::exec)
+         * */
+        virtual int exec(const std::vector<std::string>& args) = 0;
+
+        int exec(ArgList args) final {
+            return exec(std::vector<std::string>(args.begin(), args.end()));
+        }
+};
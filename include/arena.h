@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/// Монотонный распределитель памяти на время одной команды
+/**
+ * Память выделяется сдвигом указателя внутри блока, освобождение отдельных
+ * объектов ничего не делает, а \ref reset освобождает всё сразу, оставляя блоки
+ * за собой. Если за команду понадобилось несколько блоков, при сбросе они
+ * заменяются одним блоком суммарного размера, поэтому после нескольких команд
+ * всё помещается в один блок и память больше не запрашивается у системы.
+ *
+ * Используется через интерфейс ```std::pmr::memory_resource```, например
+ * ```std::pmr::vector<double> values(&arena)```. Распределитель не потокобезопасен:
+ * выделять из него память может только поток, выполняющий команду.
+ * */
+class Arena : public std::pmr::memory_resource {
+    public:
+        /** Размер первого блока по умолчанию */
+        static constexpr std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        explicit Arena(std::size_t blockSize = DEFAULT_BLOCK_SIZE) : blockSize_(blockSize) {}
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator =(const Arena&) = delete;
+
+        /** Освобождает всю выделенную память; объекты в ней должны быть уже не нужны */
+        void reset();
+
+        /** Возвращает число байт, занятых с последнего \ref reset (с выравниванием
+         * и неиспользованными концами блоков) */
+        std::size_t getUsed() const;
+
+        /** Возвращает суммарный размер блоков */
+        std::size_t getCapacity() const;
+
+        /** Возвращает, сколько раз распределитель запрашивал память у системы */
+        std::size_t getBlockAllocations() const { return blockAllocations_; }
+
+    private:
+        struct Block {
+            char* data;
+            std::size_t size;
+        };
+
+        virtual void* do_allocate(std::size_t bytes, std::size_t alignment);
+        virtual void do_deallocate(void*, std::size_t, std::size_t) {}
+        virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept { return this == &other; }
+
+        void addBlock(std::size_t size);
+
+        std::size_t blockSize_;
+        std::vector<Block> blocks_;
+        std::size_t current_ = 0;
+        std::size_t offset_ = 0;
+        std::size_t blockAllocations_ = 0;
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// Количество корней уравнения, решённого пакетно
+/**
+ * Неотрицательные значения --- число найденных корней (0, 1 или 2).
+ * Вырожденное уравнение (любое число является решением) помечается
+ * значением \ref BATCH_DEGENERATE.
+ * */
+enum BatchRootCount : signed char {
+    BATCH_DEGENERATE = -1
+};
+
+/// Реализация вычислительного ядра
+enum BatchKernel {
+    /** Выбрать лучшую доступную реализацию во время исполнения */
+    KERNEL_AUTO,
+    /** Скалярная реализация, доступна всегда */
+    KERNEL_SCALAR,
+    /** Векторная реализация на AVX2 */
+    KERNEL_AVX2
+};
+
+/** Возвращает реализацию, которая будет использована для ```KERNEL_AUTO``` */
+BatchKernel detectBatchKernel();
+
+/** Разбирает значение переменной ```kernel```: ```auto```, ```scalar``` или ```avx2```
+ * \return ```false```, если значение некорректно
+ * */
+bool parseBatchKernel(std::string_view name, BatchKernel* kernel);
+
+/** \brief Решает уравнения a[i]*x^2 + b[i]*x + c[i] = 0 для i из [begin, end)
+ *
+ * Коэффициенты и результаты хранятся в отдельных массивах (structure of arrays).
+ * Результаты совпадают побитово с ```solveSquare<double>```: первый
+ * корень соответствует положительному значению квадратного корня из дискриминанта,
+ * второй --- отрицательному.
+ * \param [in] a, b, c массивы коэффициентов
+ * \param [out] x1, x2 массивы корней; значения без соответствующего корня не определены
+ * \param [out] count количество корней (см. \ref BatchRootCount)
+ * \param [in] kernel реализация вычислительного ядра
+ * */
+void solveRealBatch(const double* a, const double* b, const double* c,
+                    double* x1, double* x2, signed char* count,
+                    std::size_t begin, std::size_t end,
+                    BatchKernel kernel = KERNEL_AUTO);
+
+/// Число уравнений с каждым количеством корней
+struct BatchRootHistogram {
+    /** Вырожденные уравнения (\ref BATCH_DEGENERATE) */
+    std::uint64_t degenerate = 0;
+    /** ```roots[n]``` --- уравнения, у которых n корней */
+    std::uint64_t roots[3] = {0, 0, 0};
+};
+
+/** \brief Считает, сколько корней у уравнений a[i]*x^2 + b[i]*x + c[i] = 0 для i из [begin, end)
+ *
+ * Количество корней каждого уравнения совпадает с найденным \ref solveRealBatch, но
+ * определяется только по знаку дискриминанта и нулевым коэффициентам, без вычисления
+ * корней. Результат прибавляется к ```histogram```.
+ * */
+void countRealRoots(const double* a, const double* b, const double* c,
+                    std::size_t begin, std::size_t end, BatchRootHistogram* histogram,
+                    BatchKernel kernel = KERNEL_AUTO);
+
+/// Пакет уравнений над полем комплексных чисел
+/**
+ * Действительные и мнимые части коэффициентов и корней хранятся в отдельных
+ * массивах.
+ * */
+struct ComplexBatchView {
+    const double* aRe;
+    const double* aIm;
+    const double* bRe;
+    const double* bIm;
+    const double* cRe;
+    const double* cIm;
+    double* x1Re;
+    double* x1Im;
+    double* x2Re;
+    double* x2Im;
+    signed char* count;
+};
+
+/** \brief Решает комплексные уравнения с номерами из [begin, end)
+ *
+ * Семантика совпадает с ```solveSquare<std::complex<double>>```:
+ * коэффициент считается нулевым, если обе его компоненты неотличимы от нуля,
+ * квадратный корень из дискриминанта --- главное значение. Корень и деление (по
+ * алгоритму Смита) вычисляются векторно, поэтому младшие разряды корней могут
+ * отличаться от результата операторов ```std::complex```; скалярное и векторное
+ * ядра между собой совпадают до бита.
+ * */
+void solveComplexBatch(const ComplexBatchView& batch, std::size_t begin, std::size_t end,
+                       BatchKernel kernel = KERNEL_AUTO);
+
+/// Точность, с которой найдены корни в адаптивном режиме
+enum BatchPrecision : unsigned char {
+    BATCH_FLOAT,
+    BATCH_DOUBLE,
+    BATCH_LONG_DOUBLE
+};
+
+/// Счётчики адаптивного режима: сколько уравнений решено с каждой точностью
+struct BatchAdaptiveCounters {
+    std::size_t solvedFloat = 0;
+    std::size_t solvedDouble = 0;
+    std::size_t solvedLongDouble = 0;
+};
+
+/** \brief Решает уравнения a[i]*x^2 + b[i]*x + c[i] = 0 для i из [begin, end), начиная с ```float```
+ *
+ * Используется устойчивая формулировка: дискриминант вычисляется через FMA с
+ * компенсацией ошибки произведения (метод Кэхэна), больший по модулю корень ---
+ * как q / a, где q = -(b + sign(b) * sqrt(D)) / 2, а второй --- по теореме Виета
+ * как c / q. Поэтому при b^2 >> 4ac не происходит катастрофического сокращения.
+ *
+ * Сначала уравнения решаются в ```float``` (векторно, если доступны AVX2 и FMA).
+ * Для каждого корня оценивается относительная погрешность через число обусловленности
+ * корня; уравнения, у которых оценка превышает ```tolerance```, а также уравнения,
+ * близкие к вырожденным или выходящие за диапазон ```float```, решаются заново в
+ * ```double``` и, если и этого недостаточно, в ```long double```.
+ *
+ * Линейные и вырожденные уравнения определяются так же, как в \ref solveRealBatch.
+ * Дискриминант вычисляется точнее, поэтому уравнения с дискриминантом на границе
+ * погрешности могут получить другое число корней; в остальном корни совпадают
+ * с точностью до ```tolerance```, но не побитово.
+ * \param [out] precision точность, с которой найдены корни уравнения (см. \ref BatchPrecision)
+ * \param [in] tolerance допустимая относительная погрешность корней
+ * \param [in,out] counters счётчики, к которым прибавляется число решённых уравнений
+ * */
+void solveRealBatchAdaptive(const double* a, const double* b, const double* c,
+                            double* x1, double* x2, signed char* count, unsigned char* precision,
+                            std::size_t begin, std::size_t end, double tolerance,
+                            BatchAdaptiveCounters* counters, BatchKernel kernel = KERNEL_AUTO);
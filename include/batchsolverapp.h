@@ -0,0 +1,89 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include <app.h>
+#include <console.h>
+#include <batchkernel.h>
+#include <resultwriter.h>
+
+/** Приложение, решающее пакет квадратных уравнений из файла
+ *
+ * Коэффициенты загружаются в отдельные массивы и решаются векторным ядром
+ * (см. \ref solveRealBatch). Разбор, решение и форматирование выполняются
+ * блоками на пуле потоков консоли (см. \ref Console::getThreadPool), а результаты
+ * выводятся в порядке следования уравнений. Вывод совпадает с выводом
+ * последовательных вызовов ```solve``` для тех же коэффициентов.
+ * */
+class BatchSolverApp : public IApp {
+    public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "solvebatch";
+        /** Аргументы не соответствуют требуемуемому формату */
+        static constexpr int STATUS_BAD_ARGUMENTS = 1;
+        /** Значение переменной ```field``` некорректно (см. \ref Console) */
+        static constexpr int STATUS_BAD_FIELD = 2;
+        /** Не удалось обработать входные данные */
+        static constexpr int STATUS_PARSE_ERROR = 3;
+        /** Не удалось открыть файл */
+        static constexpr int STATUS_FILE_ERROR = 4;
+        /** Значение переменной ```kernel``` некорректно */
+        static constexpr int STATUS_BAD_KERNEL = 5;
+        /** Значение переменной ```batch_chunk``` некорректно */
+        static constexpr int STATUS_BAD_CHUNK = 6;
+        /** Значение переменной ```mode``` некорректно или режим не поддерживается для поля */
+        static constexpr int STATUS_BAD_MODE = 7;
+        /** Значение переменной ```tolerance``` некорректно */
+        static constexpr int STATUS_BAD_TOLERANCE = 8;
+        BatchSolverApp(Console* parent) : parent_(parent) {}
+        using IApp::exec;
+        virtual int exec(ArgList args);
+        virtual const char* getStatusCodeDescription(int statusCode);
+        virtual const char* getHelp();
+    private:
+        /// Пакет уравнений над полем вещественных чисел
+        struct RealBatch {
+            typedef double Field;
+            std::vector<double> a, b, c;
+            std::vector<double> x1, x2;
+            std::vector<signed char> count;
+            /** Точность корней в адаптивном режиме (см. \ref BatchPrecision) */
+            std::vector<unsigned char> precision;
+            bool adaptive = false;
+            double tolerance = 0;
+
+            void resize(std::size_t size);
+            void set(std::size_t index, int column, double value);
+            void solve(BatchKernel kernel, std::size_t begin, std::size_t end, BatchAdaptiveCounters* counters);
+            void writeRoot(ResultWriter& out, std::size_t i, int index) const;
+        };
+
+        /// Пакет уравнений над полем комплексных чисел
+        struct ComplexBatch {
+            typedef std::complex<double> Field;
+            std::vector<double> aRe, aIm, bRe, bIm, cRe, cIm;
+            std::vector<double> x1Re, x1Im, x2Re, x2Im;
+            std::vector<signed char> count;
+
+            void resize(std::size_t size);
+            void set(std::size_t index, int column, const std::complex<double>& value);
+            void solve(BatchKernel kernel, std::size_t begin, std::size_t end, BatchAdaptiveCounters* counters);
+            void writeRoot(ResultWriter& out, std::size_t i, int index) const;
+        };
+
+        template <class Batch>
+        int load(const std::string& fileName, Batch* batch) const;
+
+        template <class Batch>
+        void print(const Batch& batch, std::size_t begin, std::size_t end, std::string& text) const;
+
+        template <class Batch>
+        int loadSolveAndPrint(const std::string& fileName, BatchKernel kernel, Batch* batch,
+                              BatchAdaptiveCounters* counters) const;
+
+        int solveAdaptive(const std::string& fileName, BatchKernel kernel);
+
+        std::size_t getChunkSize(std::size_t size) const;
+        Console* parent_;
+        BatchAdaptiveCounters totals_;
+};
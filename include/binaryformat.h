@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/// Содержимое двоичного файла
+enum BinaryKind {
+    /** Коэффициенты уравнений (сигнатура ```SQEQ```) */
+    BINARY_EQUATIONS,
+    /** Результаты решения (сигнатура ```SQRS```) */
+    BINARY_RESULTS
+};
+
+/// Блок уравнений или результатов в памяти
+/**
+ * Каждый столбец --- \ref size значений одной величины. У уравнений над полем R
+ * столбцы a, b, c, над полем C --- aRe, aIm, bRe, bIm, cRe, cIm. У результатов над
+ * полем R столбцы x1, x2, над полем C --- x1Re, x1Im, x2Re, x2Im.
+ * */
+struct BinaryBlock {
+    /** Число уравнений в блоке */
+    std::size_t size = 0;
+    std::vector<std::vector<double>> columns;
+    /** Только у результатов: число корней (см. \ref BatchRootCount) */
+    std::vector<signed char> count;
+
+    /** Задаёт число уравнений и столбцов, сохраняя выделенную память */
+    void resize(std::size_t size, std::size_t columnCount, bool withCount);
+};
+
+/// Двоичный формат пакетов уравнений и результатов
+/**
+ * Файл начинается с 32-байтного заголовка:
+ *
+ * | Смещение | Размер | Поле |
+ * |---|---|---|
+ * | 0  | 4 | сигнатура ```SQEQ``` или ```SQRS``` (см. \ref BinaryKind) |
+ * | 4  | 4 | версия формата (\ref VERSION) |
+ * | 8  | 4 | поле: 0 --- R, 1 --- C |
+ * | 12 | 4 | число уравнений в блоке |
+ * | 16 | 8 | число уравнений в файле |
+ * | 24 | 8 | зарезервировано (0) |
+ *
+ * За ним идут блоки; все блоки, кроме последнего, полные. Блок хранится по столбцам
+ * (см. \ref BinaryBlock): сначала весь первый столбец, затем второй и т. д. У результатов
+ * перед столбцами корней идут столбец числа корней и столбец флагов вырожденности
+ * (по байту на уравнение), дополненные нулями до границы 8 байт. Отсутствующие
+ * корни записываются нулями. Все числа --- little-endian, вещественные --- IEEE 754 double.
+ *
+ * Файл читается и пишется по блоку, поэтому память не зависит от его размера.
+ * */
+class BinaryFormat {
+    public:
+        static constexpr std::uint32_t VERSION = 1;
+        static constexpr std::size_t HEADER_SIZE = 32;
+        /** Число уравнений в блоке по умолчанию */
+        static constexpr std::uint32_t DEFAULT_BLOCK_SIZE = 1 << 16;
+
+        /** Возвращает число столбцов чисел в блоке */
+        static std::size_t columnCount(BinaryKind kind, bool complex);
+
+        /** Проверяет, начинается ли файл с сигнатуры двоичного формата */
+        static bool isBinaryFile(const std::string& fileName);
+};
+
+/// Чтение двоичного файла по блокам
+class BinaryReader {
+    public:
+        /** Открывает файл и читает заголовок
+         * \return ```false```, если файл не открывается или заголовок некорректен (см. \ref getError)
+         * */
+        bool open(const std::string& fileName);
+
+        /** Читает следующий блок
+         * \return ```false```, если блоков больше нет, файл обрезан или повреждён (см. \ref getError)
+         * */
+        bool readBlock(BinaryBlock* block);
+
+        BinaryKind getKind() const { return kind_; }
+        bool isComplex() const { return complex_; }
+        std::uint32_t getBlockSize() const { return blockSize_; }
+        std::uint64_t getCount() const { return count_; }
+
+        /** Возвращает описание ошибки или пустую строку */
+        const std::string& getError() const { return error_; }
+
+    private:
+        std::ifstream in_;
+        BinaryKind kind_ = BINARY_EQUATIONS;
+        bool complex_ = false;
+        std::uint32_t blockSize_ = 0;
+        std::uint64_t count_ = 0;
+        std::uint64_t read_ = 0;
+        std::string error_;
+        std::vector<unsigned char> bytes_;
+};
+
+/// Запись двоичного файла по блокам
+class BinaryWriter {
+    public:
+        /** Создаёт файл и записывает заголовок; число уравнений дописывается в \ref close */
+        bool open(const std::string& fileName, BinaryKind kind, bool complex,
+                  std::uint32_t blockSize = BinaryFormat::DEFAULT_BLOCK_SIZE);
+
+        /** Записывает блок. Все блоки, кроме последнего, должны содержать ровно
+         * ```blockSize``` уравнений
+         * */
+        bool writeBlock(const BinaryBlock& block);
+
+        /** Дописывает заголовок и закрывает файл
+         * \return ```true```, если все данные записаны
+         * */
+        bool close();
+
+        std::uint32_t getBlockSize() const { return blockSize_; }
+
+        /** Возвращает описание ошибки или пустую строку */
+        const std::string& getError() const { return error_; }
+
+    private:
+        std::ofstream out_;
+        BinaryKind kind_ = BINARY_EQUATIONS;
+        bool complex_ = false;
+        std::uint32_t blockSize_ = 0;
+        std::uint64_t count_ = 0;
+        bool lastBlock_ = false;
+        std::string error_;
+        std::vector<unsigned char> bytes_;
+};
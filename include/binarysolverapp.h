@@ -0,0 +1,35 @@
+#pragma once
+
+#include <app.h>
+#include <console.h>
+
+/** Приложение, решающее пакет квадратных уравнений из двоичного файла
+ *
+ * Уравнения читаются блоками из файла в двоичном формате (см. \ref BinaryFormat),
+ * каждый блок решается векторным ядром на пуле потоков консоли, а результаты
+ * записываются в двоичный файл результатов с тем же размером блока. Разбора
+ * и форматирования текста нет, а в памяти одновременно находится один блок,
+ * поэтому размер файлов не ограничен объёмом памяти.
+ * */
+class BinarySolverApp : public IApp {
+    public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "solvebin";
+        /** Аргументы не соответствуют требуемуемому формату */
+        static constexpr int STATUS_BAD_ARGUMENTS = 1;
+        /** Не удалось открыть или создать файл */
+        static constexpr int STATUS_FILE_ERROR = 2;
+        /** Входной файл повреждён или не содержит уравнений */
+        static constexpr int STATUS_FORMAT_ERROR = 3;
+        /** Не удалось записать результаты */
+        static constexpr int STATUS_WRITE_ERROR = 4;
+        /** Значение переменной ```kernel``` некорректно */
+        static constexpr int STATUS_BAD_KERNEL = 5;
+        BinarySolverApp(Console* parent) : parent_(parent) {}
+        using IApp::exec;
+        virtual int exec(ArgList args);
+        virtual const char* getStatusCodeDescription(int statusCode);
+        virtual const char* getHelp();
+    private:
+        Console* parent_;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <app.h>
+#include <console.h>
+
+/**
+ * Приложение, показывающее состояние кэша решений приложения ```solve```
+ * (см. \ref SolverApp и \ref SolveCache)
+ * */
+class CacheApp : public IApp {
+    public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "cache";
+        /** Аргументы не соответствуют требуемуемому формату */
+        static constexpr int STATUS_BAD_ARGUMENTS = 1;
+        /** Приложение ```solve``` не установлено */
+        static constexpr int STATUS_NO_SOLVER = 2;
+        CacheApp(const Console* parent) : parent_(parent) {}
+        using IApp::exec;
+        virtual int exec(ArgList args);
+        virtual const char* getStatusCodeDescription(int statusCode);
+        virtual const char* getHelp();
+    private:
+        const Console* parent_;
+};
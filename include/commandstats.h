@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+/// Гистограмма задержек с логарифмически-линейными корзинами (как в HdrHistogram)
+/**
+ * Каждый интервал [2^e, 2^(e+1)) делится на 2^\ref SUB_BUCKET_BITS равных корзин,
+ * поэтому относительная погрешность квантилей не превышает 2^-SUB_BUCKET_BITS при
+ * любом порядке величины. Запись значения --- несколько целочисленных операций
+ * без ветвлений по диапазону и без обращений к куче.
+ * */
+class LatencyHistogram {
+    public:
+        /** Число бит, задающих корзину внутри интервала [2^e, 2^(e+1)) */
+        static constexpr int SUB_BUCKET_BITS = 4;
+        /** Значения от 2^MAX_EXPONENT попадают в последнюю корзину */
+        static constexpr int MAX_EXPONENT = 48;
+        /** Число корзин */
+        static constexpr std::size_t BUCKETS = std::size_t(MAX_EXPONENT - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+        /** Добавляет значение */
+        void record(std::uint64_t value) {
+            ++counts_[bucketOf(value)];
+            ++count_;
+            sum_ += value;
+            min_ = (value < min_) ? value : min_;
+            max_ = (value > max_) ? value : max_;
+        }
+
+        /** Добавляет все значения другой гистограммы */
+        void merge(const LatencyHistogram& other) {
+            for (std::size_t i = 0; i < BUCKETS; ++i) {
+                counts_[i] += other.counts_[i];
+            }
+            count_ += other.count_;
+            sum_ += other.sum_;
+            min_ = (other.min_ < min_) ? other.min_ : min_;
+            max_ = (other.max_ > max_) ? other.max_ : max_;
+        }
+
+        /** Удаляет все значения */
+        void reset() {
+            *this = LatencyHistogram();
+        }
+
+        std::uint64_t count() const { return count_; }
+        std::uint64_t sum() const { return sum_; }
+        std::uint64_t min() const { return count_ == 0 ? 0 : min_; }
+        std::uint64_t max() const { return max_; }
+        double mean() const { return count_ == 0 ? 0 : double(sum_) / count_; }
+
+        /** Возвращает значение, не меньшее доли ```quantile``` из [0, 1] записанных значений
+         * (верхнюю границу корзины, но не больше \ref max) */
+        std::uint64_t percentile(double quantile) const {
+            if (count_ == 0) {
+                return 0;
+            }
+            std::uint64_t rank = static_cast<std::uint64_t>(quantile * count_ + 0.5);
+            rank = (rank == 0) ? 1 : (rank > count_ ? count_ : rank);
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < BUCKETS; ++i) {
+                seen += counts_[i];
+                if (seen >= rank) {
+                    std::uint64_t upper = upperBound(i);
+                    return upper < max_ ? upper : max_;
+                }
+            }
+            return max_;
+        }
+
+        /** Возвращает число значений в корзине */
+        std::uint64_t bucketCount(std::size_t bucket) const { return counts_[bucket]; }
+
+        /** Возвращает наименьшее значение, попадающее в корзину */
+        static std::uint64_t lowerBound(std::size_t bucket) {
+            std::size_t group = bucket >> SUB_BUCKET_BITS;
+            std::uint64_t sub = bucket & ((std::size_t(1) << SUB_BUCKET_BITS) - 1);
+            return (group == 0) ? sub : ((std::uint64_t(1) << SUB_BUCKET_BITS) + sub) << (group - 1);
+        }
+
+        /** Возвращает наибольшее значение, попадающее в корзину */
+        static std::uint64_t upperBound(std::size_t bucket) {
+            std::size_t group = bucket >> SUB_BUCKET_BITS;
+            return lowerBound(bucket) + ((group == 0) ? 0 : (std::uint64_t(1) << (group - 1)) - 1);
+        }
+
+        /** Возвращает номер корзины, в которую попадает значение */
+        static std::size_t bucketOf(std::uint64_t value) {
+            if (value < (std::uint64_t(1) << SUB_BUCKET_BITS)) {
+                return value;
+            }
+            if (value >= (std::uint64_t(1) << MAX_EXPONENT)) {
+                return BUCKETS - 1;
+            }
+            int exponent = 63 - __builtin_clzll(value);
+            int shift = exponent - SUB_BUCKET_BITS;
+            return (std::size_t(shift + 1) << SUB_BUCKET_BITS) +
+                   ((value >> shift) & ((std::uint64_t(1) << SUB_BUCKET_BITS) - 1));
+        }
+
+    private:
+        std::uint64_t counts_[BUCKETS] = {};
+        std::uint64_t count_ = 0;
+        std::uint64_t sum_ = 0;
+        std::uint64_t min_ = UINT64_MAX;
+        std::uint64_t max_ = 0;
+};
+
+/// Статистика вызовов команды
+struct CommandStats {
+    /** Число вызовов */
+    std::uint64_t calls = 0;
+    /** Число вызовов, завершившихся ошибкой, по статусам */
+    std::map<int, std::uint64_t> errors;
+    /** Время выполнения ```IApp::exec``` в наносекундах */
+    LatencyHistogram latency;
+
+    void record(int statusCode, std::uint64_t nanoseconds) {
+        ++calls;
+        if (statusCode != 0) {
+            ++errors[statusCode];
+        }
+        latency.record(nanoseconds);
+    }
+
+    void reset() {
+        calls = 0;
+        errors.clear();
+        latency.reset();
+    }
+};
@@ -1,9 +1,34 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <map>
+#include <memory>
+#include <functional>
+#include <tuple>
 #include <type_traits>
 #include "app.h"
+#include "commandstats.h"
+#include "arena.h"
+
+class ThreadPool;
+class Program;
+class ScriptCompiler;
+class LogSink;
+
+/// Сообщение уровня ```verbosity``` с заголовком ```prompt``` в лог интерпретатора ```console```
+/**
+ * Используется как поток: ```CONSOLE_LOG(console, VERB_INFO, "") << x```. Если уровень
+ * выключен, выражение после макроса не вычисляется вовсе (см. \ref Console::isLogEnabled).
+ * */
+#define CONSOLE_LOG(console, verbosity, prompt) \
+    if (!(console)->isLogEnabled(verbosity)) { } else (console)->log(verbosity, prompt)
+
+#define LOG_DEBUG(console) CONSOLE_LOG(console, VERB_DEBUG, Console::PROMPT_DEBUG)
+#define LOG_INFO(console) CONSOLE_LOG(console, VERB_INFO, Console::PROMPT_INFO)
+#define LOG_ERROR(console) CONSOLE_LOG(console, VERB_ERROR, Console::PROMPT_ERROR)
 
 /// Уровень вывода
 /**
@@ -17,30 +42,104 @@ enum Verbosity {
     VERB_ERROR
 };
 
+/// Поле, над которым решаются уравнения
+/**
+ * Соответствует значению переменной ```field``` (см. \ref Console::getField())
+ * */
+enum FieldType {
+    /** ```R``` --- вещественные числа (```double```, по умолчанию) */
+    FIELD_REAL,
+    /** ```C``` --- комплексные числа (```std::complex<double>```) */
+    FIELD_COMPLEX,
+    /** ```F``` --- вещественные числа одинарной точности (```float```) */
+    FIELD_FLOAT,
+    /** ```CF``` --- комплексные числа одинарной точности */
+    FIELD_COMPLEX_FLOAT,
+    /** ```LD``` --- вещественные числа расширенной точности (```long double```) */
+    FIELD_LONG_DOUBLE,
+    /** ```CLD``` --- комплексные числа расширенной точности */
+    FIELD_COMPLEX_LONG_DOUBLE,
+    /** ```Q128``` --- вещественные числа четверной точности (```__float128```; доступны,
+     * если программа собрана с libquadmath) */
+    FIELD_FLOAT128,
+    /** ```CQ128``` --- комплексные числа четверной точности */
+    FIELD_COMPLEX_FLOAT128,
+    /** Значение переменной некорректно */
+    FIELD_INVALID
+};
+
 /// Командный интерпретатор
 /**
  * Главный класс командного интерпретатора, содержащий указатели на приложения (см. \ref IApp),
  * переменные, потоки ввода-вывода.
+ *
+ * Встроенные приложения устанавливаются списком типов (см. \ref installApps): интерпретатор
+ * хранит их по значению и вызывает без виртуальной диспетчеризации. Команда ищется
+ * в таблице с совершенной хеш-функцией, которая перестраивается при добавлении команды.
+ *
+ * Переменные хранятся как строки, но значения, которые нужны на каждой команде
+ * (```verbosity```, ```field```, ```threads```, ```precision```, ```cache_size```, ```stats```, ```PS1```), разбираются
+ * только при изменении переменной и хранятся в готовом виде. Для этого интерпретатор
+ * подписывается на изменения переменных (см. \ref watchVariable).
+ *
+ * Для каждой команды ведётся статистика: число вызовов, число ошибок по статусам
+ * и гистограмма времени выполнения (см. \ref getCommandStats). Её сбор выключается
+ * переменной ```stats``` (```on``` по умолчанию, ```off```).
+ *
+ * Временные данные команды размещаются в распределителе \ref getArena, который
+ * сбрасывается после каждой команды; строка ввода и токены хранятся в буферах
+ * интерпретатора. Поэтому в установившемся режиме команды ```solve```, ```solvepoly```,
+ * ```set```, ```get``` не обращаются к системному распределителю памяти.
+ *
+ * Сообщения пишутся макросами \ref LOG_DEBUG, \ref LOG_INFO, \ref LOG_ERROR, которые не
+ * вычисляют аргументы выключенного уровня. По умолчанию сообщения идут в поток вывода
+ * вперемешку с результатами в порядке выполнения; \ref setLogSink перенаправляет их
+ * в отдельный поток, запись в который выполняет фоновый поток.
  * */
 class Console {
     public:
-        Console(std::istream& in, std::ostream& out) : out_(out), in_(in) {}
+        /** Заголовок отладочных сообщений */
+        static constexpr const char* PROMPT_DEBUG = "# [DEBUG] ";
+        /** Заголовок информационных сообщений */
+        static constexpr const char* PROMPT_INFO = "# [INFO ] ";
+        /** Заголовок сообщений об ошибках */
+        static constexpr const char* PROMPT_ERROR = "# [ERROR] ";
+
+        Console(std::istream& in, std::ostream& out);
         ~Console();
 
         /**
-         * Создаёт приложение класса ```App```
+         * Создаёт встроенные приложения классов ```Apps...```. Каждое приложение
+         * связывается с командой ```App::COMMAND``` и вызывается напрямую, без
+         * виртуальной диспетчеризации. Приложения хранятся в интерпретаторе по
+         * значению и создаются конструктором, принимающим указатель на интерпретатор.
+         * \return ```true```, если все команды добавлены, и ```false```, если
+         * какая-то из команд уже занята (такие приложения не вызываются)
+         * */
+        template<class... Apps>
+        bool installApps() {
+            AppStorage<Apps...>* storage = new AppStorage<Apps...>(this);
+            builtinApps_.emplace_back(storage);
+            bool ok = true;
+            ((ok = registerApp(Apps::COMMAND, &std::get<Apps>(storage->apps), &execDirect<Apps>) && ok), ...);
+            return ok;
+        }
+
+        /**
+         * Создаёт приложение класса ```App``` (например, подключаемое во время работы).
+         * Такие приложения вызываются через виртуальный метод \ref IApp::exec.
          * \param [in] appName команда, связанная с приложением
          * \param [in] ...args аргументы конструктора
          * \return ```true```, если приложение успешно добавлено, и ```false```,
-         * если
+         * если команда ```appName``` уже занята
          * */
         template<class App, class... Args>
         bool emplaceApp(const std::string& appName, Args&& ...args) {
-            if (apps_.find(appName) != apps_.end()) {
+            if (findApp(appName) >= 0) {
                 return false;
             }
-            apps_.emplace(std::make_pair(appName, new App(this, std::forward<Args>(args)...)));
-            return true;
+            pluginApps_.emplace_back(new App(this, std::forward<Args>(args)...));
+            return registerApp(appName, pluginApps_.back().get(), &execVirtual);
         }
 
         /**
@@ -55,33 +154,127 @@ class Console {
          * */
         std::ostream& log(Verbosity verbosity, const char* prompt = "") const;
 
-        /** Эквивалентно ```log(VERB_DEBUG, "# [DEBUG] ")``` (см. \ref log) */
+        /** Проверяет, выводятся ли сообщения уровня ```verbosity``` */
+        bool isLogEnabled(Verbosity verbosity) const { return verbosity >= verbosity_; }
+
+        /** Направляет сообщения (\ref log) в ```sink``` вместо потока вывода; ```nullptr```
+         * возвращает их в поток вывода. Неполные сообщения передаются ```sink``` после
+         * каждой команды. ```sink``` должен существовать, пока он установлен.
+         * */
+        void setLogSink(LogSink* sink);
+
+        /** Возвращает приёмник сообщений или ```nullptr```, если сообщения идут в поток вывода */
+        LogSink* getLogSink() const { return logSink_; }
+
+        /** Эквивалентно ```log(VERB_DEBUG, PROMPT_DEBUG)``` (см. \ref log) */
         std::ostream& debug() const;
 
-        /** Эквивалентно ```log(VERB_INFO, "# [INFO ] ")``` (см. \ref log) */
+        /** Эквивалентно ```log(VERB_INFO, PROMPT_INFO)``` (см. \ref log) */
         std::ostream& info() const;
 
-        /** Эквивалентно ```log(VERB_ERROR, "# [ERROR] ")``` (см. \ref log) */
+        /** Эквивалентно ```log(VERB_ERROR, PROMPT_ERROR)``` (см. \ref log) */
         std::ostream& error() const;
 
         /** Возвращает поток ввода */
         std::istream& input() const;
 
+        /** Задаёт буфер, из которого \ref exec будет читать команды вместо потока ввода.
+         * Строки и токены ссылаются прямо на буфер без копирования, поэтому он должен
+         * существовать до конца работы \ref exec (например, см. \ref MappedFile).
+         * */
+        void setInputBuffer(const char* data, std::size_t size);
+
         /** Возвращает уровень важности, исходя из значения переменной ```verbosity``` (см. \ref getVariable) */
         Verbosity getVerbosity() const;
 
-        /** Исполняет основной цикл командного интерпретатора */
+        /** Возвращает поле, исходя из значения переменной ```field``` */
+        FieldType getField() const;
+
+        /** Возвращает приглашение командной строки (переменная ```PS1```) */
+        const std::string& getPrompt() const;
+
+        /** Возвращает число потоков для параллельных вычислений, исходя из значения
+         * переменной ```threads``` (целое число или ```auto```; по умолчанию ```auto``` ---
+         * число аппаратных потоков) */
+        unsigned getThreads() const;
+
+        /** Возвращает пул потоков размера \ref getThreads. Пул создаётся при первом
+         * обращении и пересоздаётся при изменении переменной ```threads``` */
+        ThreadPool& getThreadPool() const;
+
+        /** Возвращает распределитель памяти текущей команды. Память освобождается
+         * после завершения каждой команды, поэтому в нём можно размещать только
+         * временные данные; выделять память может только поток команды (см. \ref Arena) */
+        Arena& getArena() const;
+
+        /** Возвращает точность вывода вещественных чисел, исходя из значения переменной
+         * ```precision```: число значащих цифр или ```shortest``` (по умолчанию) ---
+         * кратчайшая запись, однозначно задающая число (см. \ref ResultWriter) */
+        int getPrecision() const;
+
+        /** Возвращает число записей в кэше решений (см. \ref SolveCache), исходя из значения
+         * переменной ```cache_size```; по умолчанию 0 --- кэш выключен */
+        std::size_t getCacheSize() const;
+
+        /** Включает сброс потока вывода после каждой команды. Полезно, когда вывод
+         * читает человек (например, вывод идёт на терминал); в остальных случаях поток
+         * сбрасывается только при выходе. */
+        void setAutoFlush(bool autoFlush);
+
+        /** Включает конвейерный режим \ref exec: строки читает и разбивает на токены
+         * отдельный поток, вывод команд пишет в поток вывода другой поток, а команды
+         * выполняются в вызывающем потоке по порядку. Потоки связаны ограниченными
+         * очередями (см. \ref SpscRing), поэтому ожидание ввода-вывода не задерживает
+         * вычисления, а вывод попадает в поток вывода в том же порядке.
+         * Прочитав строку ```exit```, поток чтения не читает дальше, пока команды до неё
+         * не выполнены, поэтому после ```exit``` интерпретатор завершается сразу, не дожидаясь
+         * следующей строки ввода.
+         * */
+        void setPipelined(bool pipelined);
+
+        /** Исполняет основной цикл командного интерпретатора. Строка, начинающая цикл
+         * (```for``` или ```repeat```, см. \ref Program), дочитывается до парной команды
+         * ```end```, компилируется и выполняется целиком. Аргументы ```$name``` заменяются
+         * значениями переменных и вне циклов, так же как в скомпилированном сценарии.
+         * */
         int exec(int argc, char* argv[]);
 
+        /** Выполняет одну строку ввода так же, как основной цикл \ref exec. Строки,
+         * начиная со строки ```for``` или ```repeat```, накапливаются и выполняются
+         * целиком после парной команды ```end```.
+         * \return ```false```, если выполнена команда ```exit```
+         * */
+        bool execLine(std::string_view line);
+
+        /** Выполняет заранее скомпилированный сценарий вместо чтения команд из потока ввода
+         * (см. \ref ScriptCompiler)
+         * */
+        int exec(int argc, char* argv[], const Program& program);
+
+        /** Выполняет скомпилированный сценарий в текущем состоянии интерпретатора.
+         * Команды разрешаются один раз на весь запуск, аргументы ```$name``` подставляются
+         * перед каждым вызовом.
+         * \return ```false```, если сценарий выполнил команду ```exit```
+         * */
+        bool run(const Program& program);
+
         /** Возвращает значение переменной
          * \param [in] name название переменной
          * \param [in] defaultValue если переменная с именем ```name``` не установлена, вызов вернёт ```defaultValue``` */
         std::string getVariable(const std::string& name, const std::string& defaultValue = "") const;
 
         /** Устанавливает значение переменной ```name``` равным ```value```
+         * и оповещает подписчиков (см. \ref watchVariable)
          * */
         void setVariable(const std::string& name, const std::string& value);
 
+        /** Подписывается на изменения переменной
+         * \param [in] name название переменной
+         * \param [in] observer функция, которая будет вызываться с новым значением
+         * после каждого вызова \ref setVariable для этой переменной
+         * */
+        void watchVariable(const std::string& name, std::function<void(const std::string&)> observer);
+
         /** Возвращает все установленные приложения в виде отображения "команда" -> "приложение"
          * */
         const std::map<std::string, IApp*>& getApps() const;
@@ -94,9 +287,100 @@ class Console {
          * */
         void addAlias(const std::string& newName, const std::string& oldName);
 
+        /** Возвращает номер команды в таблице или -1, если такой команды нет */
+        int findApp(std::string_view name) const;
+
+        /** Возвращает число команд в таблице; номера команд --- от 0 до этого числа */
+        int getAppCount() const;
+
+        /** Возвращает название команды с номером ```index``` */
+        const std::string& getAppName(int index) const;
+
+        /** Возвращает статистику вызовов команды с номером ```index``` из основного цикла
+         * и сценариев (прямые вызовы \ref execApp не учитываются) */
+        const CommandStats& getCommandStats(int index) const;
+
+        /** Обнуляет статистику всех команд */
+        void resetStats();
+
+        /** Возвращает ```true```, если статистика собирается (переменная ```stats```) */
+        bool isStatsEnabled() const;
+
+        /** Выполняет команду с номером ```index``` (см. \ref findApp) */
+        int execApp(int index, ArgList args);
+
     private:
-        std::ostream& out_;
+        typedef int (*ExecFunction)(IApp* app, ArgList args);
+
+        /// Запись таблицы команд
+        struct AppEntry {
+            std::string name;
+            IApp* app;
+            ExecFunction exec;
+        };
+
+        struct AppStorageBase {
+            virtual ~AppStorageBase() {}
+        };
+
+        template <class... Apps>
+        struct AppStorage : AppStorageBase {
+            explicit AppStorage(Console* parent) : apps(((void)sizeof(Apps), parent)...) {}
+            std::tuple<Apps...> apps;
+        };
+
+        template <class App>
+        static int execDirect(IApp* app, ArgList args) {
+            return static_cast<App*>(app)->App::exec(args);
+        }
+
+        static int execVirtual(IApp* app, ArgList args);
+
+        bool registerApp(const std::string& name, IApp* app, ExecFunction exec);
+        void rebuildHashTable();
+
+        bool readLine(std::string_view* line);
+        void start(int argc, char* argv[]);
+        void stop();
+        void execCommand(int appIndex, ArgList args);
+        bool execTokens(ArgList args);
+        /** Подставляет значения переменных вместо аргументов ```$name```; возвращает ```args```,
+         * если подставлять нечего, иначе аргументы в \ref substituted_ */
+        ArgList substituteVariables(ArgList args);
+        bool compileLine(std::string_view line);
+        void execPipelined();
+        void printPrompt();
+
+        std::ostream* out_;
         std::istream& in_;
         std::map<std::string, IApp*> apps_;
+        std::vector<std::unique_ptr<AppStorageBase>> builtinApps_;
+        std::vector<std::unique_ptr<IApp>> pluginApps_;
+        std::vector<AppEntry> appTable_;
+        std::vector<CommandStats> stats_;
+        std::vector<int> hashTable_;
+        std::uint64_t hashSeed_ = 0;
         std::map<std::string, std::string> variables_;
+        std::map<std::string, std::vector<std::function<void(const std::string&)>>> observers_;
+
+        Verbosity verbosity_ = VERB_DEBUG;
+        FieldType field_ = FIELD_REAL;
+        unsigned threads_;
+        int precision_;
+        std::size_t cacheSize_ = 0;
+        bool statsEnabled_ = true;
+        std::string prompt_ = "> ";
+        mutable std::unique_ptr<ThreadPool> threadPool_;
+        mutable Arena arena_;
+        bool autoFlush_ = false;
+        bool pipelined_ = false;
+        LogSink* logSink_ = nullptr;
+
+        const char* inputPos_ = nullptr;
+        const char* inputEnd_ = nullptr;
+        std::string lineBuffer_;
+        std::vector<std::string_view> tokens_;
+        std::vector<std::string_view> substituted_;
+        std::string variableName_;
+        std::unique_ptr<ScriptCompiler> compiler_;
 };
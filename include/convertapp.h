@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <app.h>
+#include <console.h>
+
+/** Приложение, преобразующее уравнения и результаты между текстовым и двоичным форматами
+ *
+ * Текстовый файл с коэффициентами (как для ```solvebatch``` или строки сценария
+ * ```solve a b c```) преобразуется в двоичный файл уравнений (см. \ref BinaryFormat).
+ * Двоичный файл уравнений преобразуется обратно в тройки коэффициентов, двоичный файл
+ * результатов --- в тот же текст, что выводит ```solvebatch```.
+ * */
+class ConvertApp : public IApp {
+    public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "convert";
+        /** Аргументы не соответствуют требуемуемому формату */
+        static constexpr int STATUS_BAD_ARGUMENTS = 1;
+        /** Значение переменной ```field``` некорректно */
+        static constexpr int STATUS_BAD_FIELD = 2;
+        /** Не удалось обработать текстовый файл */
+        static constexpr int STATUS_PARSE_ERROR = 3;
+        /** Не удалось открыть или создать файл */
+        static constexpr int STATUS_FILE_ERROR = 4;
+        /** Двоичный файл повреждён */
+        static constexpr int STATUS_FORMAT_ERROR = 5;
+        /** Не удалось записать выходной файл */
+        static constexpr int STATUS_WRITE_ERROR = 6;
+        ConvertApp(Console* parent) : parent_(parent) {}
+        using IApp::exec;
+        virtual int exec(ArgList args);
+        virtual const char* getStatusCodeDescription(int statusCode);
+        virtual const char* getHelp();
+    private:
+        int textToBinary(const std::string& inFileName, const std::string& outFileName) const;
+        int binaryToText(const std::string& inFileName, const std::string& outFileName) const;
+        Console* parent_;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <limits>
+
+#ifdef HAVE_QUADMATH
+#include <quadmath.h>
+
+/** Вещественное число четверной точности (```__float128```, библиотека libquadmath) */
+typedef __float128 Float128;
+#endif
+
+/// Свойства поля, над которым решаются уравнения
+/**
+ * ```Real``` --- вещественный тип компонент, ```epsilon()``` --- погрешность, с которой
+ * значения сравниваются с нулём, ```sqrt()``` --- главное значение квадратного корня.
+ * Общий шаблон подходит для ```float```, ```double``` и ```long double```.
+ * */
+template <class Field>
+struct FieldTraits {
+    typedef Field Real;
+
+    static constexpr Real epsilon() {
+        return std::numeric_limits<Real>::epsilon();
+    }
+
+    static Field sqrt(const Field& x) {
+        return std::sqrt(x);
+    }
+};
+
+template <class Real_>
+struct FieldTraits<std::complex<Real_>> {
+    typedef Real_ Real;
+
+    static constexpr Real epsilon() {
+        return FieldTraits<Real>::epsilon();
+    }
+
+    static std::complex<Real> sqrt(const std::complex<Real>& x) {
+        return std::sqrt(x);
+    }
+};
+
+#ifdef HAVE_QUADMATH
+template <>
+struct FieldTraits<Float128> {
+    typedef Float128 Real;
+
+    /** 2^-112; ```std::numeric_limits``` для ```__float128``` есть только в режиме gnu++ */
+    static constexpr Real epsilon() {
+        return Real(1) / (Real(1ULL << 56) * Real(1ULL << 56));
+    }
+
+    static Float128 sqrt(const Float128& x) {
+        return sqrtq(x);
+    }
+};
+
+template <>
+struct FieldTraits<std::complex<Float128>> {
+    typedef Float128 Real;
+
+    static constexpr Real epsilon() {
+        return FieldTraits<Float128>::epsilon();
+    }
+
+    /** Главное значение корня: sqrt((|x| + Re x) / 2) + i * sign(Im x) * sqrt((|x| - Re x) / 2) */
+    static std::complex<Float128> sqrt(const std::complex<Float128>& x) {
+        Float128 abs = hypotq(x.real(), x.imag());
+        Float128 re = sqrtq((abs + x.real()) / 2);
+        Float128 im = sqrtq((abs - x.real()) / 2);
+        return std::complex<Float128>(re, signbitq(x.imag()) ? -im : im);
+    }
+};
+#endif
+
+/** Проверяет, что число неотличимо от нуля
+ * */
+template <class Real>
+constexpr bool isZero(const Real& x) {
+    return x < FieldTraits<Real>::epsilon() && -x < FieldTraits<Real>::epsilon();
+}
+
+/** Проверяет, что обе компоненты комплексного числа неотличимы от нуля
+ * */
+template <class Real>
+constexpr bool isZero(const std::complex<Real>& x) {
+    return isZero(x.real()) && isZero(x.imag());
+}
+
+/** Проверяет, что значение является числом (например, не является NaN)
+ * */
+template <class Field>
+constexpr bool isValid(const Field& x) {
+    return x == x; // check if x is NaN
+}
+
+template <class Real>
+constexpr bool isValid(const std::complex<Real>&) {
+    return true;
+}
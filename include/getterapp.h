@@ -8,10 +8,13 @@
  * */
 class GetterApp : public IApp {
     public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "get";
         /** Аргументы не соответствуют требуемуемому формату */
         static constexpr int STATUS_BAD_ARGUMENTS = 1;
         GetterApp(const Console* parent) : parent_(parent) {}
-        virtual int exec(const std::vector<std::string>& args);
+        using IApp::exec;
+        virtual int exec(ArgList args);
         virtual const char* getStatusCodeDescription(int statusCode);
         virtual const char* getHelp();
     private:
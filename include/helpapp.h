@@ -7,9 +7,12 @@
  * */
 class HelpApp : public IApp {
     public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "help";
         explicit HelpApp(const Console* parent) : parent_(parent) {}
         ~HelpApp();
-        int exec(const std::vector<std::string>& args);
+        using IApp::exec;
+        int exec(ArgList args);
         const char* getStatusCodeDescription(int statusCode);
         const char* getHelp();
     private:
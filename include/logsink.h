@@ -0,0 +1,74 @@
+#pragma once
+
+#include <spscring.h>
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+
+/// Асинхронный вывод сообщений интерпретатора
+/**
+ * Текст, записанный в \ref stream, копируется в записи фиксированного размера и
+ * передаётся через \ref SpscRing фоновому потоку, который пишет их в поток
+ * ```out```. Поэтому запись сообщения не ждёт ввода-вывода и не выделяет память;
+ * если фоновый поток не успевает, пишущий поток ждёт свободного места, и сообщения
+ * не теряются. Фоновый поток сбрасывает ```out```, когда очередь опустела.
+ *
+ * Писать в \ref stream может только один поток (поток команд интерпретатора).
+ * Неполная запись передаётся фоновому потоку при \ref flush и в деструкторе;
+ * деструктор дожидается, пока все сообщения будут записаны.
+ *
+ * Сообщения идут в отдельный поток (файл, ```std::cerr```), поэтому их порядок
+ * относительно результатов не определён. Если сообщения должны идти вперемешку с
+ * результатами в порядке выполнения, интерпретатор используется без LogSink
+ * (см. \ref Console::setLogSink).
+ * */
+class LogSink {
+    public:
+        /** Размер записи очереди в байтах */
+        static constexpr std::size_t RECORD_SIZE = 256;
+        /** Число записей в очереди */
+        static constexpr std::size_t CAPACITY = 1024;
+
+        explicit LogSink(std::ostream& out);
+        ~LogSink();
+
+        LogSink(const LogSink&) = delete;
+        LogSink& operator =(const LogSink&) = delete;
+
+        /** Возвращает поток для записи сообщений */
+        std::ostream& stream() { return stream_; }
+
+        /** Передаёт накопленный текст фоновому потоку */
+        void flush();
+
+    private:
+        struct Record {
+            std::size_t size = 0;
+            char text[RECORD_SIZE];
+        };
+
+        class Buffer : public std::streambuf {
+            public:
+                explicit Buffer(LogSink* sink);
+
+                /** Передаёт заполненную часть записи в очередь */
+                void push();
+
+            protected:
+                virtual int overflow(int c);
+                virtual int sync();
+
+            private:
+                LogSink* sink_;
+                Record record_;
+        };
+
+        void writerLoop();
+
+        std::ostream& out_;
+        SpscRing<Record> ring_;
+        Buffer buffer_;
+        std::ostream stream_;
+        std::thread writer_;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+/// Файл, отображённый в память только для чтения
+/**
+ * Используется для чтения больших сценариев без копирования: строки и токены
+ * ссылаются прямо на отображённые страницы. Отображение возможно только для
+ * обычных файлов; для каналов, терминалов и т. п. \ref open вернёт ```false```,
+ * и вызывающий код должен читать файл через поток.
+ * */
+class MappedFile {
+    public:
+        MappedFile() {}
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator =(const MappedFile&) = delete;
+
+        /** Отображает файл в память и сообщает ядру, что он будет читаться последовательно.
+         * \return ```true```, если отображение удалось
+         * */
+        bool open(const char* fileName);
+
+        /** Возвращает указатель на начало содержимого файла */
+        const char* data() const { return data_; }
+
+        /** Возвращает размер файла в байтах */
+        std::size_t size() const { return size_; }
+
+    private:
+        void close();
+
+        const char* data_ = nullptr;
+        std::size_t size_ = 0;
+        bool mapped_ = false;
+};
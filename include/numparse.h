@@ -0,0 +1,33 @@
+#pragma once
+
+#include <complex>
+#include <string_view>
+#include <field.h>
+
+/** Разбирает вещественное число в начале токена; символы после числа игнорируются.
+ *
+ * Разбор не зависит от текущей локали и даёт тот же результат, что и ```strtod```
+ * (```strtof```, ```strtold```) в локали "C": десятичная запись разбирается точно
+ * (с правильным округлением) функцией ```std::from_chars```, а шестнадцатеричная
+ * запись и числа вне диапазона типа --- медленным путём через ```strtod_l```.
+ * Числа типа ```Float128``` всегда разбираются функцией ```strtoflt128```.
+ * \tparam Real ```float```, ```double```, ```long double``` или ```Float128```
+ * \param [in] token токен (не обязан завершаться нулевым символом)
+ * \param [out] ok ```true```, если удалось разобрать хотя бы один символ
+ * \return Разобранное число
+ * */
+template <class Real>
+Real parseReal(std::string_view token, bool* ok);
+
+/** Эквивалентно ```parseReal<double>``` (см. \ref parseReal) */
+inline double parseDouble(std::string_view token, bool* ok) {
+    return parseReal<double>(token, ok);
+}
+
+/** Разбирает комплексное число, записанное в виде ```a```, ```bj``` или ```a+bj```.
+ * \param [in] token токен (не обязан завершаться нулевым символом)
+ * \param [out] ok ```true```, если токен является корректной записью числа
+ * \return Разобранное число или 0 в случае ошибки
+ * */
+template <class Real = double>
+std::complex<Real> parseComplex(std::string_view token, bool* ok);
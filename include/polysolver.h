@@ -0,0 +1,485 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+/// Пакет многочленов одной степени
+/**
+ * Коэффициенты и корни хранятся структурой массивов: k-е коэффициенты всех
+ * многочленов лежат подряд, вещественные и мнимые части --- в разных массивах.
+ * Итерации выполняются одновременно для всех многочленов блока, а внутренние
+ * циклы идут по многочленам, поэтому компилятор может их векторизовать.
+ *
+ * Начальные приближения для многочленов третьей и четвёртой степени находятся
+ * по формулам Кардано и Феррари, для больших степеней --- на окружности, содержащей
+ * все корни. Затем корни уточняются методом Эрлиха---Аберта; для формул
+ * обычно хватает одной-двух итераций. Для каждого найденного корня вычисляется
+ * радиус круга, в котором лежит точный корень (см. \ref getRadius): по нему
+ * \ref mergeRoots объединяет приближения кратного корня.
+ * */
+template <class Real>
+class PolynomialBatch {
+    public:
+        typedef std::complex<Real> Complex;
+
+        /** Наибольшее число итераций метода Эрлиха---Аберта */
+        static constexpr int MAX_ITERATIONS = 200;
+
+        /** Создаёт пакет из ```size``` многочленов степени ```degree``` (не меньше 1).
+         * Вся память пакета, включая рабочие массивы \ref solve, выделяется здесь из ```resource``` */
+        PolynomialBatch(int degree, std::size_t size,
+                        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                : degree_(degree), size_(size),
+                  coeffRe_((degree + 1) * size, resource), coeffIm_((degree + 1) * size, resource),
+                  rootRe_(degree * size, resource), rootIm_(degree * size, resource),
+                  radius_(degree * size, resource), scratch_(SCRATCH_ARRAYS * size, resource),
+                  active_(size, resource), moving_(size, resource) {}
+
+        int degree() const { return degree_; }
+        std::size_t size() const { return size_; }
+
+        /** Задаёт коэффициент при x^power многочлена ```equation```. Старший коэффициент
+         * должен быть ненулевым */
+        void setCoefficient(std::size_t equation, int power, const Complex& value) {
+            coeffRe_[power * size_ + equation] = value.real();
+            coeffIm_[power * size_ + equation] = value.imag();
+        }
+
+        /** Возвращает корень многочлена ```equation``` с номером ```index``` < \ref degree */
+        Complex getRoot(std::size_t equation, int index) const {
+            return Complex(rootRe_[index * size_ + equation], rootIm_[index * size_ + equation]);
+        }
+
+        /** Возвращает радиус круга с центром в корне \ref getRoot, который содержит точный
+         * корень многочлена. Кратный корень кратности m находится с погрешностью порядка
+         * eps^(1/m), и радиус растёт вместе с ней */
+        Real getRadius(std::size_t equation, int index) const {
+            return radius_[index * size_ + equation];
+        }
+
+        /** Уточняет решение ```root``` многочлена ```equation```, объединяющее ```multiplicity```
+         * корней (см. \ref mergeRoots). Кратный корень --- простой корень производной порядка
+         * multiplicity - 1, и метод Ньютона для неё находит его с точностью порядка eps, а не
+         * eps^(1/m). Если уточнённое решение вышло из круга ```radius```, в котором лежит корень,
+         * решение не меняется; иначе радиус увеличивается на сдвиг решения */
+        void refineMultiple(std::size_t equation, int multiplicity, Complex* root, Real* radius) const {
+            if (multiplicity < 2) {
+                return;
+            }
+            const Real eps = std::numeric_limits<Real>::epsilon();
+            Complex z = *root;
+            for (int iteration = 0; iteration < REFINE_ITERATIONS; ++iteration) {
+                // D = P^(m-1)(z) и D' = P^(m)(z) по схеме Горнера; коэффициент при x^k
+                // умножается на k * (k-1) * ... * (k-m+2)
+                Complex value = 0, derivative = 0;
+                for (int k = degree_; k >= multiplicity - 1; --k) {
+                    Real weight = 1;
+                    for (int t = 0; t < multiplicity - 1; ++t) {
+                        weight *= Real(k - t);
+                    }
+                    if (k >= multiplicity) {
+                        derivative = derivative * z + coefficient(equation, k) * (weight * Real(k - multiplicity + 1));
+                    }
+                    value = value * z + coefficient(equation, k) * weight;
+                }
+                Complex step = value / derivative;
+                if (!std::isfinite(step.real()) || !std::isfinite(step.imag())) {
+                    break;
+                }
+                z -= step;
+                if (std::abs(step) <= eps * std::abs(z)) {
+                    break;
+                }
+            }
+            Real shift = std::abs(z - *root);
+            if (shift <= *radius) {
+                *root = z;
+                *radius += shift;
+            }
+        }
+
+        /** Находит все корни (с учётом кратности) многочленов с номерами из [begin, end).
+         * Разные диапазоны можно решать одновременно из разных потоков */
+        void solve(std::size_t begin, std::size_t end) {
+            normalize(begin, end);
+            for (std::size_t i = begin; i < end; ++i) {
+                initialGuess(i);
+            }
+            iterate(begin, end);
+            estimateRadii(begin, end);
+        }
+
+    private:
+        static void divide(Real aRe, Real aIm, Real bRe, Real bIm, Real* re, Real* im) {
+            Real norm = bRe * bRe + bIm * bIm;
+            *re = (aRe * bRe + aIm * bIm) / norm;
+            *im = (aIm * bRe - aRe * bIm) / norm;
+        }
+
+        Complex coefficient(std::size_t i, int power) const {
+            return Complex(coeffRe_[power * size_ + i], coeffIm_[power * size_ + i]);
+        }
+
+        void setRoot(std::size_t i, int index, const Complex& root) {
+            rootRe_[index * size_ + i] = root.real();
+            rootIm_[index * size_ + i] = root.imag();
+        }
+
+        /// Делит коэффициенты на старший, после чего он равен 1
+        void normalize(std::size_t begin, std::size_t end) {
+            const Real* leadRe = &coeffRe_[degree_ * size_];
+            const Real* leadIm = &coeffIm_[degree_ * size_];
+            for (int k = 0; k < degree_; ++k) {
+                Real* re = &coeffRe_[k * size_];
+                Real* im = &coeffIm_[k * size_];
+                for (std::size_t i = begin; i < end; ++i) {
+                    divide(re[i], im[i], leadRe[i], leadIm[i], &re[i], &im[i]);
+                }
+            }
+            for (std::size_t i = begin; i < end; ++i) {
+                coeffRe_[degree_ * size_ + i] = 1;
+                coeffIm_[degree_ * size_ + i] = 0;
+            }
+        }
+
+        static Complex cubeRoot(const Complex& x) {
+            return std::polar(std::cbrt(std::abs(x)), std::arg(x) / 3);
+        }
+
+        /// Корни x^2 + b*x + c без катастрофического сокращения
+        static void solveQuadratic(const Complex& b, const Complex& c, Complex* x1, Complex* x2) {
+            Complex s = std::sqrt(b * b - Real(4) * c);
+            // Из двух значений -b +- s выбираем большее по модулю
+            Complex q = (std::real(std::conj(b) * s) >= 0) ? -(b + s) / Real(2) : -(b - s) / Real(2);
+            *x1 = q;
+            *x2 = (q == Real(0)) ? Complex(0) : c / q;
+        }
+
+        /// Корни x^3 + a*x^2 + b*x + c по формуле Кардано
+        static void solveCubic(const Complex& a, const Complex& b, const Complex& c, Complex* roots) {
+            Complex shift = a / Real(3);
+            Complex p = b - a * shift;
+            Complex q = Real(2) * shift * shift * shift - b * shift + c;
+            Complex s = std::sqrt(q * q / Real(4) + p * p * p / Real(27));
+            Complex w = -q / Real(2);
+            Complex u = cubeRoot((std::real(std::conj(w) * s) >= 0) ? w + s : w - s);
+            Complex v = (u == Real(0)) ? Complex(0) : -p / (Real(3) * u);
+            const Complex omega(Real(-0.5), std::sqrt(Real(3)) / Real(2));
+            roots[0] = u + v - shift;
+            roots[1] = omega * u + std::conj(omega) * v - shift;
+            roots[2] = std::conj(omega) * u + omega * v - shift;
+        }
+
+        /// Корни x^4 + a*x^3 + b*x^2 + c*x + d по методу Феррари
+        static void solveQuartic(const Complex& a, const Complex& b, const Complex& c, const Complex& d,
+                                 Complex* roots) {
+            // После замены x = y - a/4: y^4 + p*y^2 + q*y + r
+            Complex shift = a / Real(4);
+            Complex shift2 = shift * shift;
+            Complex p = b - Real(6) * shift2;
+            Complex q = c - Real(2) * b * shift + Real(8) * shift2 * shift;
+            Complex r = d - c * shift + b * shift2 - Real(3) * shift2 * shift2;
+
+            // Резольвента m^3 + p*m^2 + (p^2/4 - r)*m - q^2/8; берём наибольший по модулю корень
+            Complex resolvent[3];
+            solveCubic(p, p * p / Real(4) - r, -q * q / Real(8), resolvent);
+            Complex m = resolvent[0];
+            for (const Complex& root : resolvent) {
+                if (std::abs(root) > std::abs(m)) {
+                    m = root;
+                }
+            }
+
+            Complex s = std::sqrt(Real(2) * m);
+            if (s == Real(0)) {
+                // q = 0: биквадратное уравнение
+                Complex z1, z2;
+                solveQuadratic(p, r, &z1, &z2);
+                roots[0] = std::sqrt(z1);
+                roots[1] = -roots[0];
+                roots[2] = std::sqrt(z2);
+                roots[3] = -roots[2];
+            } else {
+                // (y^2 + p/2 + m)^2 = 2m * (y - q/(4m))^2
+                Complex t = q / (Real(2) * s);
+                solveQuadratic(-s, p / Real(2) + m + t, &roots[0], &roots[1]);
+                solveQuadratic(s, p / Real(2) + m - t, &roots[2], &roots[3]);
+            }
+            for (int j = 0; j < 4; ++j) {
+                roots[j] -= shift;
+            }
+        }
+
+        void initialGuess(std::size_t i) {
+            Complex roots[4];
+            switch (degree_) {
+                case 1:
+                    setRoot(i, 0, -coefficient(i, 0));
+                    return;
+                case 2:
+                    solveQuadratic(coefficient(i, 1), coefficient(i, 0), &roots[0], &roots[1]);
+                    break;
+                case 3:
+                    solveCubic(coefficient(i, 2), coefficient(i, 1), coefficient(i, 0), roots);
+                    break;
+                case 4:
+                    solveQuartic(coefficient(i, 3), coefficient(i, 2), coefficient(i, 1), coefficient(i, 0), roots);
+                    break;
+                default: {
+                    // Все корни лежат в круге радиуса 2 * max |a_k|^(1/(n-k)) (граница Фудзивары).
+                    // Точки сдвинуты относительно вещественной оси, чтобы не попасть
+                    // в симметричную неподвижную точку для вещественных многочленов
+                    Real radius = 0;
+                    for (int k = 0; k < degree_; ++k) {
+                        radius = std::max(radius, Real(std::pow(std::abs(coefficient(i, k)), Real(1) / (degree_ - k))));
+                    }
+                    Complex center = -coefficient(i, degree_ - 1) / Real(degree_);
+                    const Real pi = std::acos(Real(-1));
+                    for (int j = 0; j < degree_; ++j) {
+                        setRoot(i, j, center + std::polar(radius, 2 * pi * j / degree_ + Real(0.4)));
+                    }
+                    return;
+                }
+            }
+            for (int j = 0; j < degree_; ++j) {
+                setRoot(i, j, roots[j]);
+            }
+        }
+
+        /// Уточняет корни методом Эрлиха---Аберта:
+        /// z_j -= w_j, w_j = N_j / (1 - N_j * sum_{k != j} 1 / (z_j - z_k)), N_j = P(z_j) / P'(z_j)
+        void iterate(std::size_t begin, std::size_t end) {
+            std::size_t count = end - begin;
+            // Рабочие массивы диапазона --- свои части общих массивов пакета
+            Real* pRe = &scratch_[begin];
+            Real* pIm = pRe + size_;
+            Real* dRe = pIm + size_;
+            Real* dIm = dRe + size_;
+            Real* sRe = dIm + size_;
+            Real* sIm = sRe + size_;
+            // Многочлен считается решённым, когда все поправки стали пренебрежимо малы
+            unsigned char* active = &active_[begin];
+            unsigned char* moving = &moving_[begin];
+            std::fill(active, active + count, 1);
+            const Real eps = std::numeric_limits<Real>::epsilon();
+            for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
+                std::fill(moving, moving + count, 0);
+                for (int j = 0; j < degree_; ++j) {
+                    Real* zRe = &rootRe_[j * size_ + begin];
+                    Real* zIm = &rootIm_[j * size_ + begin];
+
+                    // Схема Горнера для P и P' одновременно
+                    std::fill(pRe, pRe + count, Real(1));
+                    std::fill(pIm, pIm + count, Real(0));
+                    std::fill(dRe, dRe + count, Real(0));
+                    std::fill(dIm, dIm + count, Real(0));
+                    for (int k = degree_ - 1; k >= 0; --k) {
+                        const Real* cRe = &coeffRe_[k * size_ + begin];
+                        const Real* cIm = &coeffIm_[k * size_ + begin];
+                        for (std::size_t i = 0; i < count; ++i) {
+                            Real re = dRe[i] * zRe[i] - dIm[i] * zIm[i] + pRe[i];
+                            Real im = dRe[i] * zIm[i] + dIm[i] * zRe[i] + pIm[i];
+                            dRe[i] = re;
+                            dIm[i] = im;
+                            re = pRe[i] * zRe[i] - pIm[i] * zIm[i] + cRe[i];
+                            im = pRe[i] * zIm[i] + pIm[i] * zRe[i] + cIm[i];
+                            pRe[i] = re;
+                            pIm[i] = im;
+                        }
+                    }
+
+                    std::fill(sRe, sRe + count, Real(0));
+                    std::fill(sIm, sIm + count, Real(0));
+                    for (int k = 0; k < degree_; ++k) {
+                        if (k == j) {
+                            continue;
+                        }
+                        const Real* yRe = &rootRe_[k * size_ + begin];
+                        const Real* yIm = &rootIm_[k * size_ + begin];
+                        for (std::size_t i = 0; i < count; ++i) {
+                            Real re, im;
+                            divide(1, 0, zRe[i] - yRe[i], zIm[i] - yIm[i], &re, &im);
+                            sRe[i] += re;
+                            sIm[i] += im;
+                        }
+                    }
+
+                    for (std::size_t i = 0; i < count; ++i) {
+                        Real nRe, nIm, wRe, wIm;
+                        divide(pRe[i], pIm[i], dRe[i], dIm[i], &nRe, &nIm);
+                        divide(nRe, nIm, 1 - (nRe * sRe[i] - nIm * sIm[i]), -(nRe * sIm[i] + nIm * sRe[i]), &wRe, &wIm);
+                        bool update = active[i] && pRe[i] * pRe[i] + pIm[i] * pIm[i] != 0 &&
+                                      std::isfinite(wRe) && std::isfinite(wIm);
+                        if (update) {
+                            zRe[i] -= wRe;
+                            zIm[i] -= wIm;
+                            Real step = wRe * wRe + wIm * wIm;
+                            Real size = zRe[i] * zRe[i] + zIm[i] * zIm[i];
+                            moving[i] |= step > eps * eps * size;
+                        }
+                    }
+                }
+
+                bool done = true;
+                for (std::size_t i = 0; i < count; ++i) {
+                    active[i] &= moving[i];
+                    done = done && !active[i];
+                }
+                if (done) {
+                    break;
+                }
+            }
+        }
+
+        /// Радиусы включения по поправкам Вейерштрасса W_j = P(z_j) / prod_{k != j} (z_j - z_k):
+        /// объединение кругов радиуса n * |W_j| содержит все корни, а каждая связная компонента
+        /// из m кругов --- ровно m корней. К |P(z_j)| добавляется порядок ошибки округления
+        /// схемы Горнера eps * sum |a_k| |z_j|^k: приближения кратного корня, на которых P
+        /// неотличим от нуля, разбросаны на eps^(1/m), и их круги пересекаются
+        void estimateRadii(std::size_t begin, std::size_t end) {
+            std::size_t count = end - begin;
+            Real* pRe = &scratch_[begin];
+            Real* pIm = pRe + size_;
+            Real* prodRe = pIm + size_;
+            Real* prodIm = prodRe + size_;
+            Real* bound = prodIm + size_;
+            const Real eps = std::numeric_limits<Real>::epsilon();
+            // Если приближения совпали, поправка не определена; берётся погрешность корня
+            // наибольшей возможной кратности n
+            const Real worst = std::pow(eps, Real(1) / degree_);
+            for (int j = 0; j < degree_; ++j) {
+                const Real* zRe = &rootRe_[j * size_ + begin];
+                const Real* zIm = &rootIm_[j * size_ + begin];
+                Real* radius = &radius_[j * size_ + begin];
+                std::fill(pRe, pRe + count, Real(1));
+                std::fill(pIm, pIm + count, Real(0));
+                std::fill(bound, bound + count, Real(1));
+                for (int k = degree_ - 1; k >= 0; --k) {
+                    const Real* cRe = &coeffRe_[k * size_ + begin];
+                    const Real* cIm = &coeffIm_[k * size_ + begin];
+                    for (std::size_t i = 0; i < count; ++i) {
+                        Real re = pRe[i] * zRe[i] - pIm[i] * zIm[i] + cRe[i];
+                        Real im = pRe[i] * zIm[i] + pIm[i] * zRe[i] + cIm[i];
+                        pRe[i] = re;
+                        pIm[i] = im;
+                        bound[i] = bound[i] * std::hypot(zRe[i], zIm[i]) + std::hypot(cRe[i], cIm[i]);
+                    }
+                }
+                std::fill(prodRe, prodRe + count, Real(1));
+                std::fill(prodIm, prodIm + count, Real(0));
+                for (int k = 0; k < degree_; ++k) {
+                    if (k == j) {
+                        continue;
+                    }
+                    const Real* wRe = &rootRe_[k * size_ + begin];
+                    const Real* wIm = &rootIm_[k * size_ + begin];
+                    for (std::size_t i = 0; i < count; ++i) {
+                        Real dRe = zRe[i] - wRe[i];
+                        Real dIm = zIm[i] - wIm[i];
+                        Real re = prodRe[i] * dRe - prodIm[i] * dIm;
+                        Real im = prodRe[i] * dIm + prodIm[i] * dRe;
+                        prodRe[i] = re;
+                        prodIm[i] = im;
+                    }
+                }
+                for (std::size_t i = 0; i < count; ++i) {
+                    Real value = std::hypot(pRe[i], pIm[i]) + eps * bound[i];
+                    Real r = degree_ * value / std::hypot(prodRe[i], prodIm[i]);
+                    Real size = std::hypot(zRe[i], zIm[i]);
+                    radius[i] = std::isfinite(r) ? std::max(r, eps * size) : worst * std::max(Real(1), size);
+                }
+            }
+        }
+
+        /** Число рабочих массивов метода Эрлиха---Аберта: P, P' и сумма, по две части */
+        static constexpr std::size_t SCRATCH_ARRAYS = 6;
+        /** Наибольшее число шагов Ньютона в \ref refineMultiple */
+        static constexpr int REFINE_ITERATIONS = 20;
+
+        int degree_;
+        std::size_t size_;
+        std::pmr::vector<Real> coeffRe_, coeffIm_;
+        std::pmr::vector<Real> rootRe_, rootIm_;
+        std::pmr::vector<Real> radius_;
+        std::pmr::vector<Real> scratch_;
+        std::pmr::vector<unsigned char> active_, moving_;
+};
+
+/** Объединяет приближения одного корня многочлена в одно решение
+ *
+ * ```radii``` --- радиусы кругов вокруг корней, содержащих точные корни (см.
+ * \ref PolynomialBatch::getRadius). Корни, круги которых пересекаются (в том числе
+ * через цепочку других кругов), считаются приближениями одного кратного корня;
+ * решение --- среднее группы, оно точнее отдельных корней, а радиус решения ---
+ * наибольшее удаление круга группы от среднего. Решения и их радиусы записываются
+ * на место первых элементов ```roots``` и ```radii``` и упорядочиваются по
+ * вещественной, затем по мнимой части. Перед упорядочиванием для каждого решения
+ * вызывается ```refine(&root, &radius, multiplicity)```, где multiplicity --- число
+ * объединённых корней (см. \ref PolynomialBatch::refineMultiple). Память не выделяется.
+ * \return число решений
+ * */
+template <class Real, class Refine>
+std::size_t mergeRoots(std::complex<Real>* roots, Real* radii, std::size_t count, Refine refine) {
+    // [0, merged) --- решения, [next, count) --- ещё не объединённые корни
+    std::size_t merged = 0;
+    for (std::size_t next = 0; next < count;) {
+        // Группа [next, groupEnd) растёт, пока к ней добавляются пересекающиеся круги
+        std::size_t groupEnd = next + 1;
+        for (std::size_t g = next; g < groupEnd; ++g) {
+            for (std::size_t k = groupEnd; k < count; ++k) {
+                if (std::abs(roots[k] - roots[g]) < radii[k] + radii[g]) {
+                    std::swap(roots[k], roots[groupEnd]);
+                    std::swap(radii[k], radii[groupEnd]);
+                    ++groupEnd;
+                }
+            }
+        }
+        std::complex<Real> sum = 0;
+        for (std::size_t g = next; g < groupEnd; ++g) {
+            sum += roots[g];
+        }
+        std::complex<Real> mean = sum / Real(groupEnd - next);
+        Real radius = 0;
+        for (std::size_t g = next; g < groupEnd; ++g) {
+            radius = std::max(radius, std::abs(roots[g] - mean) + radii[g]);
+        }
+        roots[merged] = mean;
+        radii[merged] = radius;
+        refine(&roots[merged], &radii[merged], static_cast<int>(groupEnd - next));
+        ++merged;
+        next = groupEnd;
+    }
+    // Сортировка вставками: решений не больше степени, и радиусы переставляются вместе с ними
+    for (std::size_t k = 1; k < merged; ++k) {
+        std::complex<Real> root = roots[k];
+        Real radius = radii[k];
+        std::size_t j = k;
+        for (; j > 0 && (roots[j - 1].real() > root.real() ||
+                         (roots[j - 1].real() == root.real() && roots[j - 1].imag() > root.imag())); --j) {
+            roots[j] = roots[j - 1];
+            radii[j] = radii[j - 1];
+        }
+        roots[j] = root;
+        radii[j] = radius;
+    }
+    return merged;
+}
+
+/** Объединяет корни без уточнения решений */
+template <class Real>
+std::size_t mergeRoots(std::complex<Real>* roots, Real* radii, std::size_t count) {
+    return mergeRoots(roots, radii, count, [](std::complex<Real>*, Real*, int) {});
+}
+
+/** Проверяет, что решение многочлена с вещественными коэффициентами вещественное:
+ * мнимая часть не больше радиуса решения (см. \ref mergeRoots)
+ * */
+template <class Real>
+bool isRealRoot(const std::complex<Real>& root, Real radius) {
+    return std::abs(root.imag()) <= radius;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <app.h>
+#include <console.h>
+
+/// Приложение, решающее алгебраические уравнения произвольной степени
+/**
+ * Уравнения степени не выше второй решаются так же, как в \ref SolverApp, поэтому
+ * вывод совпадает с выводом ```solve```. Уравнения большей степени группируются
+ * по степени и решаются пакетами (см. \ref PolynomialBatch) на пуле потоков консоли.
+ * Временные массивы размещаются в распределителе команды (см. \ref Console::getArena).
+ * */
+class PolySolverApp : public IApp {
+    public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "solvepoly";
+        /** Аргументы не соответствуют требуемуемому формату */
+        static constexpr int STATUS_BAD_ARGUMENTS = 1;
+        /** Значение переменной ```field``` некорректно (см. \ref Console) */
+        static constexpr int STATUS_BAD_FIELD = 2;
+        /** Не удалось обработать входные данные */
+        static constexpr int STATUS_PARSE_ERROR = 3;
+        /** Не удалось открыть файл */
+        static constexpr int STATUS_FILE_ERROR = 4;
+        /** Число многочленов одной степени, решаемых одной задачей пула потоков */
+        static constexpr std::size_t CHUNK_SIZE = 256;
+        PolySolverApp(const Console* parent) : parent_(parent) {}
+        using IApp::exec;
+        virtual int exec(ArgList args);
+        virtual const char* getStatusCodeDescription(int statusCode);
+        virtual const char* getHelp();
+    private:
+        template <class Field>
+        int parseSolveAndPrint(const ArgList* equations, std::size_t count) const;
+
+        int solveAll(const ArgList* equations, std::size_t count) const;
+        const Console* parent_;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <field.h>
+
+/// Буферизованный вывод результатов
+/**
+ * Форматирует числа в собственный буфер и передаёт его в поток или строку
+ * целыми блоками: при заполнении буфера, при вызове \ref flush и при
+ * уничтожении объекта. Поток при этом не сбрасывается (```std::ostream::flush```
+ * не вызывается), это остаётся на усмотрение командного интерпретатора.
+ *
+ * Вещественные числа по умолчанию выводятся в кратчайшей записи, которая при
+ * обратном разборе даёт то же самое число. Если задана точность, вывод совпадает
+ * с выводом ```std::ostream``` с такой точностью (формат ```%g```).
+ * */
+class ResultWriter {
+    public:
+        /** Точность, соответствующая кратчайшей однозначной записи */
+        static constexpr int PRECISION_SHORTEST = 0;
+
+        /** Создаёт объект, который пишет в поток ```out``` */
+        ResultWriter(std::ostream& out, int precision = PRECISION_SHORTEST);
+
+        /** Создаёт объект, который дописывает результат в конец строки ```out``` */
+        ResultWriter(std::string& out, int precision = PRECISION_SHORTEST);
+
+        ~ResultWriter();
+
+        ResultWriter(const ResultWriter&) = delete;
+        ResultWriter& operator =(const ResultWriter&) = delete;
+
+        ResultWriter& operator <<(float x) { return writeReal(x); }
+        ResultWriter& operator <<(double x) { return writeReal(x); }
+        ResultWriter& operator <<(long double x) { return writeReal(x); }
+#ifdef HAVE_QUADMATH
+        ResultWriter& operator <<(Float128 x);
+#endif
+
+        /** Выводит комплексное число в формате ```a+bj```, опуская нулевые компоненты */
+        template <class Real>
+        ResultWriter& operator <<(const std::complex<Real>& x);
+
+        ResultWriter& operator <<(long x);
+        ResultWriter& operator <<(int x) { return *this << static_cast<long>(x); }
+        ResultWriter& operator <<(char c);
+        ResultWriter& operator <<(std::string_view str);
+        ResultWriter& operator <<(const char* str) { return *this << std::string_view(str); }
+
+        /** Передаёт содержимое буфера в поток или строку */
+        void flush();
+
+    private:
+        static constexpr std::size_t BUFFER_SIZE = 4096;
+        /** Максимальная длина одного отформатированного числа */
+        static constexpr std::size_t MAX_NUMBER_LENGTH = 64;
+
+        void reserve(std::size_t size);
+
+        template <class Real>
+        ResultWriter& writeReal(Real x);
+
+        std::ostream* stream_ = nullptr;
+        std::string* string_ = nullptr;
+        int precision_;
+        std::size_t size_ = 0;
+        char buffer_[BUFFER_SIZE];
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+/// Множество решений уравнения
+/**
+ * Хранит не более \ref MAX_ROOTS корней прямо в объекте, без обращения к куче.
+ * Кроме корней хранится вид множества решений: решений нет, решений конечное
+ * число или решением является любое значение (вырожденное уравнение).
+ * */
+template <class Field>
+class Roots {
+    public:
+        /** Наибольшее число корней */
+        static constexpr std::size_t MAX_ROOTS = 2;
+
+        enum Kind : unsigned char {
+            /** Решений нет */
+            ROOTS_NONE,
+            /** Решения перечислены в объекте */
+            ROOTS_FINITE,
+            /** Любое значение является решением */
+            ROOTS_ALL
+        };
+
+        constexpr Roots() : roots_{}, size_(0), kind_(ROOTS_NONE) {}
+
+        /** Возвращает множество решений вырожденного уравнения */
+        static constexpr Roots all() {
+            Roots roots;
+            roots.kind_ = ROOTS_ALL;
+            return roots;
+        }
+
+        /** Добавляет корень */
+        constexpr void push_back(const Field& root) {
+            roots_[size_++] = root;
+            kind_ = ROOTS_FINITE;
+        }
+
+        constexpr Kind kind() const { return kind_; }
+        constexpr bool isDegenerate() const { return kind_ == ROOTS_ALL; }
+
+        /** Возвращает число корней (для вырожденного уравнения --- 0) */
+        constexpr std::size_t size() const { return size_; }
+        constexpr bool empty() const { return size_ == 0; }
+
+        constexpr Field& operator [](std::size_t i) { return roots_[i]; }
+        constexpr const Field& operator [](std::size_t i) const { return roots_[i]; }
+
+        constexpr Field* begin() { return roots_; }
+        constexpr Field* end() { return roots_ + size_; }
+        constexpr const Field* begin() const { return roots_; }
+        constexpr const Field* end() const { return roots_ + size_; }
+
+    private:
+        Field roots_[MAX_ROOTS];
+        unsigned char size_;
+        Kind kind_;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Скомпилированный сценарий
+/**
+ * Сценарий --- последовательность команд интерпретатора (см. \ref Console), в которой
+ * дополнительно разрешены циклы и подстановка переменных:
+ *
+ *     for <var> <from> <to> [<step>]   # целочисленный цикл, границы включительно
+ *         ...
+ *     end
+ *     repeat <n>
+ *         ...
+ *     end
+ *
+ * Аргумент вида ```$name``` заменяется значением переменной ```name``` в момент
+ * выполнения команды. Компиляция (см. \ref ScriptCompiler) превращает текст в плотный
+ * массив инструкций: токены уже выделены, числовые границы циклов уже разобраны,
+ * а переменные помечены как слоты для подстановки. Программу можно сохранить на диск
+ * и загрузить обратно, минуя разбор текста.
+ * */
+class Program {
+    public:
+        enum OpCode : std::uint32_t {
+            /** Вызов приложения; первый аргумент --- имя команды */
+            OP_CALL,
+            /** Начало цикла ```for```; ```target``` --- номер парной инструкции ```OP_END``` */
+            OP_FOR,
+            /** Начало цикла ```repeat```; ```target``` --- номер парной инструкции ```OP_END``` */
+            OP_REPEAT,
+            /** Конец цикла; ```target``` --- номер инструкции начала цикла */
+            OP_END,
+            /** Завершение работы интерпретатора */
+            OP_EXIT
+        };
+
+        enum ArgKind : std::uint32_t {
+            /** Аргумент задан текстом */
+            ARG_LITERAL,
+            /** Аргумент --- значение переменной, имя которой задано текстом */
+            ARG_VARIABLE
+        };
+
+        struct Instruction {
+            std::uint32_t op;
+            std::uint32_t target;
+            std::uint32_t firstArg;
+            std::uint32_t argCount;
+        };
+
+        struct Argument {
+            std::uint32_t kind;
+            std::uint32_t offset;
+            std::uint32_t length;
+            /** Не 0, если текст аргумента --- целое число, разобранное в ```number``` */
+            std::uint32_t hasNumber;
+            std::int64_t number;
+        };
+
+        std::vector<Instruction> code;
+        std::vector<Argument> args;
+        /** Тексты аргументов, на которые ссылаются ```Argument::offset``` и ```Argument::length``` */
+        std::string pool;
+
+        /** Возвращает текст аргумента (для ```ARG_VARIABLE``` --- имя переменной) */
+        std::string_view text(const Argument& arg) const {
+            return std::string_view(pool.data() + arg.offset, arg.length);
+        }
+
+        /** Возвращает хеш текста сценария, по которому проверяется кэш */
+        static std::uint64_t hash(std::string_view script);
+
+        /** Сохраняет программу в файл вместе с хешем исходного текста */
+        bool save(const std::string& fileName, std::uint64_t scriptHash) const;
+
+        /** Загружает программу из файла.
+         * \return ```false```, если файла нет, он повреждён, записан другой версией
+         * программы или хеш не совпадает с ```scriptHash```
+         * */
+        bool load(const std::string& fileName, std::uint64_t scriptHash);
+};
+
+/// Компилятор сценариев
+/**
+ * Принимает сценарий построчно и строит \ref Program.
+ * */
+class ScriptCompiler {
+    public:
+        /** Добавляет строку сценария
+         * \return ```false``` в случае синтаксической ошибки (см. \ref getError)
+         * */
+        bool addLine(std::string_view line);
+
+        /** Возвращает число незакрытых циклов */
+        std::size_t getDepth() const { return loops_.size(); }
+
+        /** Завершает компиляцию и передаёт программу в ```program```
+         * \return ```false```, если остались незакрытые циклы
+         * */
+        bool finish(Program* program);
+
+        /** Возвращает описание последней ошибки */
+        const std::string& getError() const { return error_; }
+
+    private:
+        bool fail(const std::string& message);
+        std::uint32_t addArgument(std::string_view token);
+
+        Program program_;
+        std::vector<std::uint32_t> loops_;
+        std::vector<std::string_view> tokens_;
+        std::size_t lineNumber_ = 0;
+        std::string error_;
+};
+
+/** Возвращает ```true```, если строка начинает цикл и, следовательно, должна
+ * выполняться через \ref ScriptCompiler
+ * */
+bool startsLoop(std::string_view line);
+
+/** Возвращает ```true```, если строка --- команда ```exit``` (в том числе в теле цикла)
+ * */
+bool isExit(std::string_view line);
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <console.h>
+
+/// Сервер, выполняющий команды многих клиентов в одном процессе
+/**
+ * Принимает соединения на Unix-сокете (адрес ```unix:<путь>```) или на TCP-порту
+ * localhost (адрес ```tcp:<порт>```). Клиент пишет команды построчно, как в
+ * интерактивном режиме, и получает тот же вывод, что и от ```solver```.
+ *
+ * Сокеты обслуживает один поток с циклом epoll. Каждому соединению выделяется
+ * свой интерпретатор (\ref Console) со своими переменными и приложениями, которые
+ * создаёт функция настройки. Команды выполняются на пуле рабочих потоков;
+ * у соединения одновременно выполняется не больше одной порции команд, поэтому
+ * команды, присланные подряд без ожидания ответа, выполняются и отвечаются по порядку.
+ *
+ * По умолчанию переменная ```threads``` соединения равна 1: параллельность
+ * обеспечивается между соединениями, а не внутри одной команды.
+ * */
+class Server {
+    public:
+        /** Функция настройки интерпретатора нового соединения (например, установка приложений) */
+        typedef std::function<void(Console&)> Setup;
+
+        /** Наибольший объём неотправленного вывода соединения; пока он превышен,
+         * команды соединения не читаются */
+        static constexpr std::size_t OUTPUT_LIMIT = 1 << 20;
+
+        /** \param [in] workers число рабочих потоков; 0 --- число аппаратных потоков */
+        explicit Server(Setup setup, unsigned workers = 0);
+        ~Server();
+
+        Server(const Server&) = delete;
+        Server& operator =(const Server&) = delete;
+
+        /** Начинает принимать соединения по адресу ```address```
+         * \return ```false``` в случае ошибки (см. \ref getError)
+         * */
+        bool listen(const std::string& address);
+
+        /** Возвращает TCP-порт, на котором принимаются соединения (полезно для ```tcp:0```) */
+        int getPort() const { return port_; }
+
+        /** Возвращает описание последней ошибки */
+        const std::string& getError() const { return error_; }
+
+        /** Обслуживает соединения, пока не будет вызван \ref stop */
+        void run();
+
+        /** Останавливает \ref run; можно вызывать из любого потока и из обработчика сигнала */
+        void stop();
+
+        /** Подключается к серверу по адресу ```address```
+         * \return дескриптор сокета или -1 в случае ошибки
+         * */
+        static int connect(const std::string& address, std::string* error);
+
+    private:
+        struct Connection {
+            Connection(int fd) : fd(fd), console(in, out) {}
+
+            int fd;
+            std::istringstream in;
+            std::ostringstream out;
+            Console console;
+            /** Принятые байты после последнего перевода строки */
+            std::string input;
+            /** Строки, ожидающие выполнения, и строки, выполняемые рабочим потоком */
+            std::vector<std::string> pending, running;
+            /** Вывод, ещё не отправленный клиенту */
+            std::string output;
+            /** События epoll, которых ждёт соединение; 0 --- дескриптор не зарегистрирован в epoll */
+            std::uint32_t events = 0;
+            bool busy = false;
+            bool eof = false;
+            bool exited = false;
+            bool broken = false;
+        };
+
+        struct Completion {
+            std::uint64_t id;
+            std::string output;
+            bool exited;
+        };
+
+        class WorkerPool;
+
+        void accept();
+        void read(std::uint64_t id, Connection& connection);
+        void write(Connection& connection);
+        void dispatch(std::uint64_t id, Connection& connection);
+        void complete();
+        void update(std::uint64_t id);
+
+        Setup setup_;
+        std::unique_ptr<WorkerPool> workers_;
+        int listenFd_ = -1;
+        int epollFd_ = -1;
+        int wakeFd_ = -1;
+        int port_ = 0;
+        std::string unixPath_;
+        std::string error_;
+        std::atomic<bool> stopping_{false};
+
+        std::map<std::uint64_t, std::unique_ptr<Connection>> connections_;
+        std::uint64_t nextId_ = 2;
+
+        std::mutex completionMutex_;
+        std::vector<Completion> completions_;
+};
@@ -6,10 +6,13 @@
 /** Приложение, позволяющее устанавливать значения переменных (см. \ref Console)*/
 class SetterApp : public IApp {
     public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "set";
         /** Аргументы не соответствуют требуемуемому формату */
         static constexpr int STATUS_BAD_ARGUMENTS = 1;
         explicit SetterApp(Console* parent) : parent_(parent) {}
-        virtual int exec(const std::vector<std::string>& args);
+        using IApp::exec;
+        virtual int exec(ArgList args);
         virtual const char* getStatusCodeDescription(int statusCode);
         virtual const char* getHelp();
     private:
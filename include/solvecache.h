@@ -0,0 +1,165 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <roots.h>
+
+/// Кэш решений квадратных уравнений
+/**
+ * Таблица с открытой адресацией: запись ищется в окне из \ref PROBE_LENGTH соседних
+ * ячеек, начиная с ячейки, заданной хешем коэффициентов. Если окно заполнено, новая
+ * запись вытесняет одну из записей окна по алгоритму CLOCK: у каждой записи есть бит
+ * обращения, который выставляется при попадании и сбрасывается стрелкой часов.
+ *
+ * Коэффициенты сравниваются побитово. Нормировать их (например, делить на старший
+ * коэффициент) нельзя: решатель сравнивает промежуточные значения с нулём с абсолютной
+ * погрешностью, поэтому решения пропорциональных уравнений могут различаться.
+ * */
+template <class Field>
+class SolveCache {
+    public:
+        typedef std::array<Field, 3> Key;
+        typedef Roots<Field> Value;
+
+        /** Длина окна поиска */
+        static constexpr std::size_t PROBE_LENGTH = 8;
+
+        /** Возвращает наибольшее допустимое число записей */
+        std::size_t capacity() const { return slots_.size(); }
+
+        /** Возвращает значение, переданное последнему вызову \ref resize */
+        std::size_t limit() const { return limit_; }
+
+        /** Возвращает число записей */
+        std::size_t size() const { return size_; }
+
+        std::uint64_t hits() const { return hits_; }
+        std::uint64_t misses() const { return misses_; }
+
+        /** Удаляет все записи и задаёт наибольшее число записей. Размер таблицы ---
+         * наибольшая степень двойки, не превосходящая ```capacity```; 0 выключает кэш */
+        void resize(std::size_t capacity) {
+            std::size_t size = 0;
+            if (capacity > 0) {
+                size = 1;
+                while (size * 2 <= capacity) {
+                    size *= 2;
+                }
+            }
+            slots_.assign(size, Slot());
+            limit_ = capacity;
+            size_ = 0;
+            hand_ = 0;
+        }
+
+        /** Удаляет все записи, не меняя размера таблицы */
+        void clear() {
+            resize(limit_);
+        }
+
+        /** Обнуляет счётчики попаданий и промахов */
+        void resetCounters() {
+            hits_ = 0;
+            misses_ = 0;
+        }
+
+        /** Ищет решение уравнения с коэффициентами ```key```
+         * \return указатель на решение или ```nullptr```, если его нет в кэше
+         * */
+        const Value* find(const Key& key) {
+            if (slots_.empty()) {
+                return nullptr;
+            }
+            std::uint64_t hash = hashKey(key);
+            std::size_t mask = slots_.size() - 1;
+            std::size_t probe = probeLength();
+            for (std::size_t i = 0; i < probe; ++i) {
+                Slot& slot = slots_[(hash + i) & mask];
+                if (!slot.used) {
+                    break;
+                }
+                if (slot.hash == hash && std::memcmp(&slot.key, &key, sizeof(Key)) == 0) {
+                    slot.referenced = true;
+                    ++hits_;
+                    return &slot.value;
+                }
+            }
+            ++misses_;
+            return nullptr;
+        }
+
+        /** Добавляет решение уравнения, которого нет в кэше */
+        void insert(const Key& key, const Value& value) {
+            if (slots_.empty()) {
+                return;
+            }
+            std::uint64_t hash = hashKey(key);
+            std::size_t mask = slots_.size() - 1;
+            std::size_t probe = probeLength();
+            Slot* victim = nullptr;
+            for (std::size_t i = 0; i < probe && victim == nullptr; ++i) {
+                Slot& slot = slots_[(hash + i) & mask];
+                if (!slot.used) {
+                    victim = &slot;
+                    ++size_;
+                }
+            }
+            // Окно заполнено: стрелка обходит окно, сбрасывая биты обращения,
+            // пока не найдёт запись, к которой не обращались с прошлого обхода
+            while (victim == nullptr) {
+                Slot& slot = slots_[(hash + hand_) & mask];
+                hand_ = (hand_ + 1) % probe;
+                if (slot.referenced) {
+                    slot.referenced = false;
+                } else {
+                    victim = &slot;
+                }
+            }
+            victim->used = true;
+            victim->referenced = false;
+            victim->hash = hash;
+            victim->key = key;
+            victim->value = value;
+        }
+
+    private:
+        struct Slot {
+            std::uint64_t hash = 0;
+            bool used = false;
+            bool referenced = false;
+            Key key;
+            Value value;
+        };
+
+        std::size_t probeLength() const {
+            return slots_.size() < PROBE_LENGTH ? slots_.size() : PROBE_LENGTH;
+        }
+
+        static std::uint64_t hashKey(const Key& key) {
+            std::uint64_t words[(sizeof(Key) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t)] = {};
+            std::memcpy(words, &key, sizeof(Key));
+            std::uint64_t hash = 0;
+            for (std::uint64_t word : words) {
+                hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+                hash ^= hash >> 32;
+            }
+            // У небольших целых чисел младшие биты мантиссы нулевые, поэтому
+            // перемешиваем все биты (финализатор MurmurHash3)
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            hash ^= hash >> 33;
+            hash *= 0xC4CEB9FE1A85EC53ULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        std::vector<Slot> slots_;
+        std::size_t limit_ = 0;
+        std::size_t size_ = 0;
+        std::size_t hand_ = 0;
+        std::uint64_t hits_ = 0;
+        std::uint64_t misses_ = 0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <field.h>
+#include <roots.h>
+
+/** Возвращает все значения квадратного корня из ```x``` */
+template <class Field>
+constexpr Roots<Field> squareRoot(const Field& x) {
+    Roots<Field> result;
+    if (isZero(x)) {
+        result.push_back(Field(0));
+    } else {
+        Field sqrt = FieldTraits<Field>::sqrt(x);
+        if (isValid(sqrt)) {
+            result.push_back(sqrt);
+            result.push_back(-sqrt);
+        }
+    }
+    return result;
+}
+
+/** Решает уравнение k*x + b = 0 */
+template <class Field>
+constexpr Roots<Field> solveLinear(const Field& k, const Field& b) {
+    Roots<Field> result;
+    if (isZero(k)) {
+        if (isZero(b)) {
+            result = Roots<Field>::all();
+        }
+    } else {
+        result.push_back(-b / k);
+    }
+    return result;
+}
+
+/** Решает уравнение a*x^2 + b*x + c = 0, где ```coefficients``` = {a, b, c}.
+ * Этот порядок операций повторяют пакетные ядра (см. \ref solveRealBatch).
+ * */
+template <class Field>
+constexpr Roots<Field> solveSquare(const std::array<Field, 3>& coefficients) {
+    if (isZero(coefficients[0])) {
+        return solveLinear(coefficients[1], coefficients[2]);
+    }
+    typedef typename FieldTraits<Field>::Real Real;
+    Field discriminant = coefficients[1] * coefficients[1] - Real(4) * coefficients[0] * coefficients[2];
+    Roots<Field> result = squareRoot(discriminant);
+    for (Field& root : result) {
+        root -= coefficients[1];
+        root /= coefficients[0];
+        root /= Real(2);
+    }
+    return result;
+}
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <array>
 #include <app.h>
 #include <console.h>
+#include <solvecache.h>
+#include <complex>
 
 class SolverApp : public IApp {
     public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "solve";
         /** Аргументы не соответствуют требуемуемому формату */
         static constexpr int STATUS_BAD_ARGUMENTS = 1;
         /** Значение переменной ```field``` некорректно (см. \ref Console) */
@@ -12,23 +17,26 @@ class SolverApp : public IApp {
         /** Не удалось обработать входные данные */
         static constexpr int STATUS_PARSE_ERROR = 3;
         SolverApp(const Console* parent) : parent_(parent) {}
-        virtual int exec(const std::vector<std::string>& args);
+        using IApp::exec;
+        virtual int exec(ArgList args);
         virtual const char* getStatusCodeDescription(int statusCode);
         virtual const char* getHelp();
-    private:
-        template <class Field>
-        Field parse(const std::string& input, bool* ok = nullptr) const;
 
-        template <class Field>
-        std::vector<Field> solveSquare(const std::array<Field, 3>& coefficients, bool* isDegenerateEquation) const;
+        /** Возвращает кэш решений над вещественными числами (см. переменную ```cache_size```) */
+        SolveCache<double>& getRealCache() { return realCache_; }
 
+        /** Возвращает кэш решений над комплексными числами */
+        SolveCache<std::complex<double>>& getComplexCache() { return complexCache_; }
+    private:
         template <class Field>
-        std::vector<Field> solveLinear(const Field& k, const Field& b, bool* isDegenerateEquation) const;
+        Field parse(std::string_view input, bool* ok = nullptr) const;
 
         template <class Field>
-        std::vector<Field> squareRoot(const Field& x) const;
+        SolveCache<Field>* getCache();
 
         template <class Field>
-        int parseSolveAndPrint(const std::vector<std::string>& input) const;
+        int parseSolveAndPrint(ArgList input);
         const Console* parent_;
+        SolveCache<double> realCache_;
+        SolveCache<std::complex<double>> complexCache_;
 };
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <app.h>
+#include <console.h>
+
+/** Приложение, считающее статистику пакета квадратных уравнений без вывода решений
+ *
+ * Уравнения читаются блоками из двоичного файла уравнений (см. \ref BinaryFormat)
+ * или из текстового файла коэффициентов. Каждый блок делится на части, которые
+ * обрабатываются на пуле потоков консоли; у каждой части свои частичные итоги,
+ * которые складываются в порядке частей, поэтому результат не зависит от числа потоков.
+ *
+ * Число корней определяется векторным проходом по знаку дискриминанта
+ * (см. \ref countRealRoots); корни вычисляются (см. \ref solveRealBatch), только если
+ * нужны их минимум, максимум и среднее. Выводится короткая таблица.
+ * */
+class SolveStatsApp : public IApp {
+    public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "solvestats";
+        /** Аргументы не соответствуют требуемуемому формату */
+        static constexpr int STATUS_BAD_ARGUMENTS = 1;
+        /** Поле не R: статистика считается только для вещественных уравнений */
+        static constexpr int STATUS_BAD_FIELD = 2;
+        /** Не удалось обработать текстовый файл */
+        static constexpr int STATUS_PARSE_ERROR = 3;
+        /** Не удалось открыть файл */
+        static constexpr int STATUS_FILE_ERROR = 4;
+        /** Двоичный файл повреждён или не содержит уравнений */
+        static constexpr int STATUS_FORMAT_ERROR = 5;
+        /** Значение переменной ```kernel``` некорректно */
+        static constexpr int STATUS_BAD_KERNEL = 6;
+        SolveStatsApp(Console* parent) : parent_(parent) {}
+        using IApp::exec;
+        virtual int exec(ArgList args);
+        virtual const char* getStatusCodeDescription(int statusCode);
+        virtual const char* getHelp();
+    private:
+        Console* parent_;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+/// Ограниченная очередь без блокировок для одного производителя и одного потребителя
+/**
+ * Кольцевой буфер на ```capacity``` элементов (округляется вверх до степени двойки).
+ * \ref push вызывает только поток-производитель, \ref pop --- только поток-потребитель.
+ * Индексы головы и хвоста лежат в разных строках кэша, поэтому потоки не мешают друг
+ * другу, пока очередь не пуста и не полна.
+ *
+ * Полная очередь задерживает производителя (обратное давление), пустая --- потребителя;
+ * ожидающий поток сначала уступает процессор, а при долгом ожидании засыпает.
+ * После \ref close потребитель забирает оставшиеся элементы, а затем \ref pop
+ * возвращает ```false```; производитель, ожидающий места, тоже прекращает ожидание.
+ * */
+template <class T>
+class SpscRing {
+    public:
+        explicit SpscRing(std::size_t capacity) {
+            std::size_t size = 2;
+            while (size < capacity) {
+                size *= 2;
+            }
+            slots_.reset(new T[size]);
+            mask_ = size - 1;
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator =(const SpscRing&) = delete;
+
+        /** Кладёт элемент в очередь, дожидаясь свободного места
+         * \return ```false```, если очередь закрыта (элемент не добавлен)
+         * */
+        bool push(T&& value) {
+            std::size_t tail = tail_.load(std::memory_order_relaxed);
+            for (unsigned attempt = 0; tail - head_.load(std::memory_order_acquire) > mask_; ++attempt) {
+                if (closed_.load(std::memory_order_acquire)) {
+                    return false;
+                }
+                backOff(attempt);
+            }
+            slots_[tail & mask_] = std::move(value);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Забирает элемент из очереди, дожидаясь его появления
+         * \return ```false```, если очередь закрыта и пуста
+         * */
+        bool pop(T* value) {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            for (unsigned attempt = 0; tail_.load(std::memory_order_acquire) == head; ++attempt) {
+                if (closed_.load(std::memory_order_acquire)) {
+                    // Элемент мог быть добавлен до закрытия
+                    if (tail_.load(std::memory_order_acquire) == head) {
+                        return false;
+                    }
+                    break;
+                }
+                backOff(attempt);
+            }
+            *value = std::move(slots_[head & mask_]);
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Забирает элемент, если он есть, не дожидаясь его появления
+         * \return ```false```, если очередь пуста
+         * */
+        bool tryPop(T* value) {
+            std::size_t head = head_.load(std::memory_order_relaxed);
+            if (tail_.load(std::memory_order_acquire) == head) {
+                return false;
+            }
+            *value = std::move(slots_[head & mask_]);
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** Закрывает очередь; может вызываться любой из сторон */
+        void close() {
+            closed_.store(true, std::memory_order_release);
+        }
+
+    private:
+        static constexpr std::size_t CACHE_LINE = 64;
+        static constexpr unsigned YIELDS = 64;
+
+        static void backOff(unsigned attempt) {
+            if (attempt < YIELDS) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        std::unique_ptr<T[]> slots_;
+        std::size_t mask_;
+        alignas(CACHE_LINE) std::atomic<std::size_t> head_{0};
+        alignas(CACHE_LINE) std::atomic<std::size_t> tail_{0};
+        alignas(CACHE_LINE) std::atomic<bool> closed_{false};
+};
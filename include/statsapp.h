@@ -0,0 +1,25 @@
+#pragma once
+
+#include <app.h>
+#include <console.h>
+
+/**
+ * Приложение, показывающее статистику вызовов команд: число вызовов, ошибки
+ * по статусам и квантили времени выполнения (см. \ref Console::getCommandStats)
+ * */
+class StatsApp : public IApp {
+    public:
+        /** Команда, с которой связано приложение */
+        static constexpr const char* COMMAND = "stats";
+        /** Аргументы не соответствуют требуемуемому формату */
+        static constexpr int STATUS_BAD_ARGUMENTS = 1;
+        StatsApp(Console* parent) : parent_(parent) {}
+        using IApp::exec;
+        virtual int exec(ArgList args);
+        virtual const char* getStatusCodeDescription(int statusCode);
+        virtual const char* getHelp();
+    private:
+        void printTable(std::ostream& out) const;
+        void printJson(std::ostream& out) const;
+        Console* parent_;
+};
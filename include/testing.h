@@ -1,5 +1,7 @@
 #pragma once
 
+// Набор тестов регистрируется сам: достаточно определить его через TEST_SET
+// и вызвать Tester::runAll из main
 #define TEST_SET(test_set_name) \
 namespace test_autogen { \
     class test_set_name : public Tester { \
@@ -7,31 +9,76 @@ namespace test_autogen { \
             virtual const char* getName() const { return #test_set_name ; } \
             test_set_name(); \
     }; \
+    static Tester::SetRegistrar test_set_name ## Registrar( \
+        []() -> std::unique_ptr<Tester> { return std::unique_ptr<Tester>(new test_set_name()); }); \
 } \
 test_autogen::test_set_name::test_set_name()
 
+// Обычный тест: выполняется параллельно с другими
 #define TEST(test_name) TestInserter{this, #test_name } << []() -> bool
 
+// Тест, которому нужен весь процесс (глобальные счётчики, трассировка): выполняется один
+#define TEST_SERIAL(test_name) TestInserter{this, #test_name, Tester::KIND_SERIAL} << []() -> bool
+
+// Замер: тело выполняется runs раз подряд, выводится статистика времени одного запуска
+#define TEST_BENCH(test_name, runs) TestInserter{this, #test_name, Tester::KIND_BENCH, runs} << []() -> bool
+
 #include <vector>
 #include <functional>
+#include <memory>
 
+/// Набор тестов
+/**
+ * Обычные тесты всех наборов выполняются на нескольких потоках, затем по одному
+ * выполняются тесты \ref KIND_SERIAL и замеры \ref KIND_BENCH. Вывод теста в
+ * ```std::cout``` и ```std::cerr``` из его потока перехватывается и печатается
+ * вместе с результатом; результаты печатаются в порядке объявления тестов.
+ * */
 class Tester {
     public:
+        enum Kind {
+            KIND_PARALLEL,
+            KIND_SERIAL,
+            KIND_BENCH
+        };
         struct Test {
             std::function<bool()> test;
             const char* name;
+            Kind kind;
+            unsigned runs;
         };
         struct TestInserter {
             Tester* tester;
             const char* name;
+            Kind kind = KIND_PARALLEL;
+            unsigned runs = 1;
             void operator <<(std::function<bool()> func) {
-                tester->registerTest({func, name});
+                tester->registerTest({func, name, kind, runs});
+            }
+        };
+        typedef std::unique_ptr<Tester> (*Factory)();
+        struct SetRegistrar {
+            explicit SetRegistrar(Factory factory) {
+                registerSet(factory);
             }
         };
     private:
         std::vector<Test> tests_;
     public:
+        virtual ~Tester() {}
         virtual const char* getName() const { return ""; }
         void registerTest(const Test& test);
-        void runTests();
+        const std::vector<Test>& getTests() const { return tests_; }
+
+        /** Добавляет набор в общий список (см. \ref TEST_SET) */
+        static void registerSet(Factory factory);
+
+        /** Выполняет зарегистрированные наборы с параметрами командной строки:
+         * ```-f pattern``` --- только тесты, полное имя которых (```Set.Test```)
+         * содержит ```pattern``` или совпадает с ним, если в нём есть ```*```;
+         * ```-s index/count``` --- только часть index из count (для запуска в нескольких процессах);
+         * ```-j threads``` --- число потоков для обычных тестов; ```-l``` --- только список тестов.
+         * \return 0, если все выбранные тесты прошли
+         * */
+        static int runAll(int argc, char* argv[]);
 };
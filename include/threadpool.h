@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Пул потоков с перехватом работы (work stealing)
+/**
+ * Задачи распределяются по очередям потоков равномерно. Поток берёт задачи
+ * с конца своей очереди, а когда она пуста --- с начала очередей других
+ * потоков. Вызывающий поток также участвует в работе.
+ * */
+class ThreadPool {
+    public:
+        /** Создаёт пул из ```threads``` потоков, включая вызывающий.
+         * Если ```threads``` равно 0, используется число аппаратных потоков.
+         * */
+        explicit ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator =(const ThreadPool&) = delete;
+
+        /** Возвращает число потоков в пуле, включая вызывающий */
+        unsigned size() const;
+
+        /** Выполняет ```task(i)``` для всех i из [0, count) и дожидается завершения.
+         * Порядок выполнения не определён; вызовы не должны бросать исключения.
+         * */
+        void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task);
+
+        /** Возвращает число аппаратных потоков (не меньше 1) */
+        static unsigned hardwareThreads();
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::size_t> tasks;
+        };
+
+        bool takeTask(unsigned worker, std::size_t* task);
+        void runTasks(unsigned worker);
+        void workerLoop(unsigned worker);
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread> threads_;
+
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        std::condition_variable done_;
+        unsigned long generation_ = 0;
+        bool stopping_ = false;
+
+        const std::function<void(std::size_t)>* task_ = nullptr;
+        std::atomic<std::size_t> pending_{0};
+        unsigned busyWorkers_ = 0;
+};
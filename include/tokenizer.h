@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+/** Разбивает строку на токены, разделённые пробельными символами. Токены ссылаются
+ * на символы строки; предыдущее содержимое ```tokens``` удаляется, но выделенная
+ * память переиспользуется.
+ * */
+void tokenize(std::string_view input, std::vector<std::string_view>* tokens);
+
+/** Проверяет, что строка пуста или является комментарием (начинается с ```#```) */
+bool isComment(std::string_view input);
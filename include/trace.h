@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// Запись временной шкалы выполнения в формате Chrome Trace Event
+/**
+ * Файл открывается в chrome://tracing или в Perfetto (ui.perfetto.dev). Каждый
+ * отрезок времени (см. \ref TraceSpan) записывается как событие ```"ph": "X"```,
+ * у каждого потока своя дорожка.
+ *
+ * События пишутся в буфер своего потока без блокировок: буфер регистрируется один
+ * раз при первом событии потока и растёт блоками, поэтому память выделяется раз
+ * на несколько тысяч событий. Буферы читает только \ref write, который вызывается,
+ * когда параллельная работа закончена.
+ *
+ * Пока трассировка не включена (\ref enable), \ref TraceSpan стоит одну проверку флага.
+ * */
+class Tracer {
+    public:
+        /** Включает трассировку; время событий отсчитывается от этого вызова */
+        static void enable();
+
+        /** Выключает трассировку; записанные события сохраняются до \ref write */
+        static void disable();
+
+        static bool isEnabled() { return enabled_; }
+
+        /** Возвращает время в наносекундах с момента \ref enable */
+        static std::uint64_t now();
+
+        /** Записывает событие в буфер текущего потока. Имя длиннее
+         * \ref MAX_NAME_LENGTH символов обрезается */
+        static void record(const char* category, std::string_view name, std::uint64_t start, std::uint64_t finish);
+
+        /** Записывает события всех потоков в файл в формате JSON
+         * \return ```true```, если файл записан */
+        static bool write(const char* fileName);
+
+        /** Наибольшая длина имени события */
+        static constexpr std::size_t MAX_NAME_LENGTH = 31;
+
+    private:
+        static bool enabled_;
+};
+
+/// Отрезок времени от создания объекта до его уничтожения
+/**
+ * ```category``` должна быть строковой константой; ```name``` копируется при
+ * уничтожении объекта и должна быть действительна до этого момента.
+ * */
+class TraceSpan {
+    public:
+        TraceSpan(const char* category, std::string_view name) : category_(category), name_(name) {
+            if (Tracer::isEnabled()) {
+                start_ = Tracer::now();
+                active_ = true;
+            }
+        }
+
+        ~TraceSpan() {
+            if (active_) {
+                Tracer::record(category_, name_, start_, Tracer::now());
+            }
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator =(const TraceSpan&) = delete;
+
+    private:
+        const char* category_;
+        std::string_view name_;
+        std::uint64_t start_ = 0;
+        bool active_ = false;
+};
@@ -0,0 +1,69 @@
+#include <arena.h>
+#include <new>
+
+constexpr std::size_t Arena::DEFAULT_BLOCK_SIZE;
+
+Arena::~Arena() {
+    for (const auto& block : blocks_) {
+        ::operator delete(block.data);
+    }
+}
+
+void Arena::addBlock(std::size_t size) {
+    // Место под запись блока выделяется заранее, чтобы исключение не потеряло блок
+    blocks_.reserve(blocks_.size() + 1);
+    blocks_.push_back({static_cast<char*>(::operator new(size)), size});
+    ++blockAllocations_;
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    while (current_ < blocks_.size()) {
+        const Block& block = blocks_[current_];
+        std::size_t address = reinterpret_cast<std::size_t>(block.data) + offset_;
+        std::size_t padding = (alignment - address % alignment) % alignment;
+        if (offset_ + padding + bytes <= block.size) {
+            offset_ += padding + bytes;
+            return block.data + offset_ - bytes;
+        }
+        ++current_;
+        offset_ = 0;
+    }
+    // Блоки растут вдвое, пока команда не перестанет помещаться
+    std::size_t size = blocks_.empty() ? blockSize_ : 2 * blocks_.back().size;
+    while (size < bytes + alignment) {
+        size *= 2;
+    }
+    addBlock(size);
+    current_ = blocks_.size() - 1;
+    offset_ = 0;
+    return do_allocate(bytes, alignment);
+}
+
+void Arena::reset() {
+    if (blocks_.size() > 1) {
+        std::size_t capacity = getCapacity();
+        for (const auto& block : blocks_) {
+            ::operator delete(block.data);
+        }
+        blocks_.clear();
+        addBlock(capacity);
+    }
+    current_ = 0;
+    offset_ = 0;
+}
+
+std::size_t Arena::getUsed() const {
+    std::size_t used = offset_;
+    for (std::size_t i = 0; i < current_ && i < blocks_.size(); ++i) {
+        used += blocks_[i].size;
+    }
+    return used;
+}
+
+std::size_t Arena::getCapacity() const {
+    std::size_t capacity = 0;
+    for (const auto& block : blocks_) {
+        capacity += block.size;
+    }
+    return capacity;
+}
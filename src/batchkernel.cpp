@@ -0,0 +1,722 @@
+#include <batchkernel.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+static const double EPS = std::numeric_limits<double>::epsilon();
+
+// Скалярная версия повторяет порядок операций solveSquare<double>,
+// поэтому оба пути дают одинаковые до бита результаты.
+static void solveRealScalar(const double* a, const double* b, const double* c,
+                            double* x1, double* x2, signed char* count,
+                            std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        if (std::abs(a[i]) < EPS) {
+            if (std::abs(b[i]) < EPS) {
+                count[i] = (std::abs(c[i]) < EPS) ? BATCH_DEGENERATE : 0;
+            } else {
+                x1[i] = -c[i] / b[i];
+                count[i] = 1;
+            }
+            continue;
+        }
+
+        double discriminant = b[i] * b[i] - 4. * a[i] * c[i];
+        if (std::abs(discriminant) < EPS) {
+            x1[i] = (0. - b[i]) / a[i] / 2.;
+            count[i] = 1;
+            continue;
+        }
+
+        double sqrt = std::sqrt(discriminant);
+        if (sqrt != sqrt) {
+            count[i] = 0;
+            continue;
+        }
+        x1[i] = (sqrt - b[i]) / a[i] / 2.;
+        x2[i] = (-sqrt - b[i]) / a[i] / 2.;
+        count[i] = 2;
+    }
+}
+
+// Условия те же, что в solveRealScalar: два корня, только если квадратный корень
+// из дискриминанта не NaN и дискриминант не считается нулевым
+static void countRealRootsScalar(const double* a, const double* b, const double* c,
+                                 std::size_t begin, std::size_t end, BatchRootHistogram* histogram) {
+    for (std::size_t i = begin; i < end; ++i) {
+        if (std::abs(a[i]) < EPS) {
+            if (std::abs(b[i]) < EPS) {
+                if (std::abs(c[i]) < EPS) {
+                    ++histogram->degenerate;
+                } else {
+                    ++histogram->roots[0];
+                }
+            } else {
+                ++histogram->roots[1];
+            }
+            continue;
+        }
+        double discriminant = b[i] * b[i] - 4. * a[i] * c[i];
+        if (std::abs(discriminant) < EPS) {
+            ++histogram->roots[1];
+        } else if (discriminant >= EPS) {
+            ++histogram->roots[2];
+        } else {
+            ++histogram->roots[0];
+        }
+    }
+}
+
+static inline bool isZeroPair(double re, double im) {
+    return std::abs(re) < EPS && std::abs(im) < EPS;
+}
+
+// Деление комплексных чисел по алгоритму Смита
+static inline void complexDiv(double nr, double ni, double dr, double di, double* qr, double* qi) {
+    if (std::abs(dr) >= std::abs(di)) {
+        double r = di / dr;
+        double den = dr + di * r;
+        *qr = (nr + ni * r) / den;
+        *qi = (ni - nr * r) / den;
+    } else {
+        double r = dr / di;
+        double den = di + dr * r;
+        *qr = (ni + nr * r) / den;
+        *qi = (ni * r - nr) / den;
+    }
+}
+
+// Модуль комплексного числа с масштабированием, исключающим переполнение
+static inline double complexAbs(double x, double y) {
+    double s = std::max(std::abs(x), std::abs(y));
+    if (s == 0) {
+        return s;
+    }
+    x /= s;
+    y /= s;
+    return s * std::sqrt(x * x + y * y);
+}
+
+// Главное значение квадратного корня, как в std::sqrt(std::complex);
+// знак мнимой части берётся из знака y, включая отрицательный ноль. Модуль
+// считается масштабированием, а не через hypot, как в csqrt, поэтому младший
+// разряд может отличаться от std::sqrt
+static inline void complexSqrt(double x, double y, double* sr, double* si) {
+    if (x == 0) {
+        double t = std::sqrt(std::abs(y) / 2);
+        *sr = t;
+        *si = std::copysign(t, y);
+        return;
+    }
+    double t = std::sqrt(2 * (complexAbs(x, y) + std::abs(x)));
+    double u = t / 2;
+    if (x > 0) {
+        *sr = u;
+        *si = y / t;
+    } else {
+        *sr = std::abs(y) / t;
+        *si = std::copysign(u, y);
+    }
+}
+
+// Повторяет операции solveComplexAVX2 по одной дорожке, поэтому оба ядра дают
+// одинаковые до бита результаты
+static void solveComplexScalar(const ComplexBatchView& v, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        double ar = v.aRe[i], ai = v.aIm[i];
+        double br = v.bRe[i], bi = v.bIm[i];
+        double cr = v.cRe[i], ci = v.cIm[i];
+
+        if (isZeroPair(ar, ai)) {
+            if (isZeroPair(br, bi)) {
+                v.count[i] = isZeroPair(cr, ci) ? BATCH_DEGENERATE : 0;
+            } else {
+                complexDiv(-cr, -ci, br, bi, &v.x1Re[i], &v.x1Im[i]);
+                v.count[i] = 1;
+            }
+            continue;
+        }
+
+        double ar4 = 4. * ar, ai4 = 4. * ai;
+        double dr = (br * br - bi * bi) - (ar4 * cr - ai4 * ci);
+        double di = (br * bi + bi * br) - (ar4 * ci + ai4 * cr);
+
+        double qr, qi;
+        if (isZeroPair(dr, di)) {
+            complexDiv(0. - br, 0. - bi, ar, ai, &qr, &qi);
+            v.x1Re[i] = qr / 2.;
+            v.x1Im[i] = qi / 2.;
+            v.count[i] = 1;
+            continue;
+        }
+
+        double sr, si;
+        complexSqrt(dr, di, &sr, &si);
+        complexDiv(sr - br, si - bi, ar, ai, &qr, &qi);
+        v.x1Re[i] = qr / 2.;
+        v.x1Im[i] = qi / 2.;
+        complexDiv(-sr - br, -si - bi, ar, ai, &qr, &qi);
+        v.x2Re[i] = qr / 2.;
+        v.x2Im[i] = qi / 2.;
+        v.count[i] = 2;
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+__attribute__((target("avx2")))
+static void solveRealAVX2(const double* a, const double* b, const double* c,
+                          double* x1, double* x2, signed char* count,
+                          std::size_t begin, std::size_t end) {
+    const __m256d eps = _mm256_set1_pd(EPS);
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d two = _mm256_set1_pd(2.);
+    const __m256d four = _mm256_set1_pd(4.);
+
+    std::size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i);
+        __m256d vb = _mm256_loadu_pd(b + i);
+        __m256d vc = _mm256_loadu_pd(c + i);
+
+        __m256d linear = _mm256_cmp_pd(_mm256_and_pd(va, absMask), eps, _CMP_LT_OQ);
+        __m256d zeroB = _mm256_cmp_pd(_mm256_and_pd(vb, absMask), eps, _CMP_LT_OQ);
+        __m256d zeroC = _mm256_cmp_pd(_mm256_and_pd(vc, absMask), eps, _CMP_LT_OQ);
+
+        __m256d discriminant = _mm256_sub_pd(_mm256_mul_pd(vb, vb),
+                                             _mm256_mul_pd(_mm256_mul_pd(four, va), vc));
+        __m256d zeroD = _mm256_cmp_pd(_mm256_and_pd(discriminant, absMask), eps, _CMP_LT_OQ);
+        __m256d sqrt = _mm256_sqrt_pd(discriminant);
+        __m256d valid = _mm256_cmp_pd(sqrt, sqrt, _CMP_EQ_OQ);
+
+        // Если дискриминант равен нулю, корень квадратный из него считается равным нулю
+        __m256d root = _mm256_blendv_pd(sqrt, zero, zeroD);
+        __m256d r1 = _mm256_div_pd(_mm256_div_pd(_mm256_sub_pd(root, vb), va), two);
+        __m256d r2 = _mm256_div_pd(_mm256_div_pd(_mm256_sub_pd(_mm256_xor_pd(sqrt, _mm256_set1_pd(-0.)), vb), va), two);
+        __m256d lin = _mm256_div_pd(_mm256_xor_pd(vc, _mm256_set1_pd(-0.)), vb);
+
+        _mm256_storeu_pd(x1 + i, _mm256_blendv_pd(r1, lin, linear));
+        _mm256_storeu_pd(x2 + i, r2);
+
+        int linearBits = _mm256_movemask_pd(linear);
+        int zeroBBits = _mm256_movemask_pd(zeroB);
+        int zeroCBits = _mm256_movemask_pd(zeroC);
+        int zeroDBits = _mm256_movemask_pd(zeroD);
+        int validBits = _mm256_movemask_pd(valid);
+        for (int lane = 0; lane < 4; ++lane) {
+            int bit = 1 << lane;
+            signed char n;
+            if (linearBits & bit) {
+                if (zeroBBits & bit) {
+                    n = (zeroCBits & bit) ? BATCH_DEGENERATE : 0;
+                } else {
+                    n = 1;
+                }
+            } else if (zeroDBits & bit) {
+                n = 1;
+            } else {
+                n = (validBits & bit) ? 2 : 0;
+            }
+            count[i + lane] = n;
+        }
+    }
+
+    solveRealScalar(a, b, c, x1, x2, count, i, end);
+}
+
+__attribute__((target("avx2,popcnt")))
+static void countRealRootsAVX2(const double* a, const double* b, const double* c,
+                               std::size_t begin, std::size_t end, BatchRootHistogram* histogram) {
+    const __m256d eps = _mm256_set1_pd(EPS);
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    const __m256d four = _mm256_set1_pd(4.);
+
+    std::uint64_t degenerate = 0;
+    std::uint64_t one = 0;
+    std::uint64_t two = 0;
+    std::size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i);
+        __m256d vb = _mm256_loadu_pd(b + i);
+        __m256d vc = _mm256_loadu_pd(c + i);
+
+        int linear = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(va, absMask), eps, _CMP_LT_OQ));
+        int zeroB = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(vb, absMask), eps, _CMP_LT_OQ));
+        int zeroC = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(vc, absMask), eps, _CMP_LT_OQ));
+        __m256d discriminant = _mm256_sub_pd(_mm256_mul_pd(vb, vb),
+                                             _mm256_mul_pd(_mm256_mul_pd(four, va), vc));
+        int zeroD = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(discriminant, absMask), eps, _CMP_LT_OQ));
+        // Сравнение с NaN ложно, поэтому уравнения с NaN попадают в «нет корней»
+        int positiveD = _mm256_movemask_pd(_mm256_cmp_pd(discriminant, eps, _CMP_GE_OQ));
+
+        degenerate += __builtin_popcount(linear & zeroB & zeroC);
+        one += __builtin_popcount((linear & ~zeroB) | (~linear & zeroD & 0xF));
+        two += __builtin_popcount(~linear & positiveD & 0xF);
+    }
+    std::uint64_t vectorized = (i - begin) - degenerate - one - two;
+    histogram->degenerate += degenerate;
+    histogram->roots[0] += vectorized;
+    histogram->roots[1] += one;
+    histogram->roots[2] += two;
+    countRealRootsScalar(a, b, c, i, end, histogram);
+}
+
+#define AVX2_INLINE __attribute__((target("avx2"), always_inline)) static inline
+
+AVX2_INLINE __m256d absPd(__m256d x) {
+    return _mm256_and_pd(x, _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL)));
+}
+
+AVX2_INLINE __m256d negPd(__m256d x) {
+    return _mm256_xor_pd(x, _mm256_set1_pd(-0.));
+}
+
+AVX2_INLINE __m256d isZeroPd(__m256d re, __m256d im) {
+    const __m256d eps = _mm256_set1_pd(EPS);
+    return _mm256_and_pd(_mm256_cmp_pd(absPd(re), eps, _CMP_LT_OQ),
+                         _mm256_cmp_pd(absPd(im), eps, _CMP_LT_OQ));
+}
+
+AVX2_INLINE void complexDivPd(__m256d nr, __m256d ni, __m256d dr, __m256d di, __m256d* qr, __m256d* qi) {
+    __m256d realIsLarger = _mm256_cmp_pd(absPd(dr), absPd(di), _CMP_GE_OQ);
+    __m256d large = _mm256_blendv_pd(di, dr, realIsLarger);
+    __m256d small = _mm256_blendv_pd(dr, di, realIsLarger);
+    __m256d r = _mm256_div_pd(small, large);
+    __m256d den = _mm256_add_pd(large, _mm256_mul_pd(small, r));
+    __m256d re = _mm256_blendv_pd(_mm256_add_pd(ni, _mm256_mul_pd(nr, r)),
+                                  _mm256_add_pd(nr, _mm256_mul_pd(ni, r)), realIsLarger);
+    __m256d im = _mm256_blendv_pd(_mm256_sub_pd(_mm256_mul_pd(ni, r), nr),
+                                  _mm256_sub_pd(ni, _mm256_mul_pd(nr, r)), realIsLarger);
+    *qr = _mm256_div_pd(re, den);
+    *qi = _mm256_div_pd(im, den);
+}
+
+AVX2_INLINE void complexSqrtPd(__m256d x, __m256d y, __m256d* sr, __m256d* si) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d two = _mm256_set1_pd(2.);
+    __m256d absX = absPd(x);
+    __m256d absY = absPd(y);
+    // blendv выбирает по знаковому биту, поэтому y служит маской для copysign
+    __m256d negY = y;
+
+    __m256d s = _mm256_max_pd(absX, absY);
+    __m256d xs = _mm256_div_pd(x, s);
+    __m256d ys = _mm256_div_pd(y, s);
+    __m256d abs = _mm256_mul_pd(s, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(xs, xs), _mm256_mul_pd(ys, ys))));
+    abs = _mm256_blendv_pd(abs, zero, _mm256_cmp_pd(s, zero, _CMP_EQ_OQ));
+
+    __m256d t = _mm256_sqrt_pd(_mm256_mul_pd(two, _mm256_add_pd(abs, absX)));
+    __m256d u = _mm256_div_pd(t, two);
+    __m256d signedU = _mm256_blendv_pd(u, negPd(u), negY);
+    __m256d positive = _mm256_cmp_pd(x, zero, _CMP_GT_OQ);
+    __m256d re = _mm256_blendv_pd(_mm256_div_pd(absY, t), u, positive);
+    __m256d im = _mm256_blendv_pd(signedU, _mm256_div_pd(y, t), positive);
+
+    __m256d t0 = _mm256_sqrt_pd(_mm256_div_pd(absY, two));
+    __m256d onAxis = _mm256_cmp_pd(x, zero, _CMP_EQ_OQ);
+    *sr = _mm256_blendv_pd(re, t0, onAxis);
+    *si = _mm256_blendv_pd(im, _mm256_blendv_pd(t0, negPd(t0), negY), onAxis);
+}
+
+__attribute__((target("avx2")))
+static void solveComplexAVX2(const ComplexBatchView& v, std::size_t begin, std::size_t end) {
+    const __m256d two = _mm256_set1_pd(2.);
+    const __m256d four = _mm256_set1_pd(4.);
+    const __m256d zero = _mm256_setzero_pd();
+
+    std::size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d ar = _mm256_loadu_pd(v.aRe + i), ai = _mm256_loadu_pd(v.aIm + i);
+        __m256d br = _mm256_loadu_pd(v.bRe + i), bi = _mm256_loadu_pd(v.bIm + i);
+        __m256d cr = _mm256_loadu_pd(v.cRe + i), ci = _mm256_loadu_pd(v.cIm + i);
+
+        __m256d linear = isZeroPd(ar, ai);
+        __m256d zeroB = isZeroPd(br, bi);
+        __m256d zeroC = isZeroPd(cr, ci);
+
+        __m256d ar4 = _mm256_mul_pd(four, ar), ai4 = _mm256_mul_pd(four, ai);
+        __m256d dr = _mm256_sub_pd(_mm256_sub_pd(_mm256_mul_pd(br, br), _mm256_mul_pd(bi, bi)),
+                                   _mm256_sub_pd(_mm256_mul_pd(ar4, cr), _mm256_mul_pd(ai4, ci)));
+        __m256d di = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(br, bi), _mm256_mul_pd(bi, br)),
+                                   _mm256_add_pd(_mm256_mul_pd(ar4, ci), _mm256_mul_pd(ai4, cr)));
+        __m256d zeroD = isZeroPd(dr, di);
+
+        __m256d sr, si;
+        complexSqrtPd(dr, di, &sr, &si);
+        // Если дискриминант равен нулю, корень квадратный из него считается равным нулю
+        __m256d rootRe = _mm256_blendv_pd(sr, zero, zeroD);
+        __m256d rootIm = _mm256_blendv_pd(si, zero, zeroD);
+
+        __m256d q1r, q1i, q2r, q2i, lr, li;
+        complexDivPd(_mm256_sub_pd(rootRe, br), _mm256_sub_pd(rootIm, bi), ar, ai, &q1r, &q1i);
+        complexDivPd(_mm256_sub_pd(negPd(sr), br), _mm256_sub_pd(negPd(si), bi), ar, ai, &q2r, &q2i);
+        complexDivPd(negPd(cr), negPd(ci), br, bi, &lr, &li);
+
+        _mm256_storeu_pd(v.x1Re + i, _mm256_blendv_pd(_mm256_div_pd(q1r, two), lr, linear));
+        _mm256_storeu_pd(v.x1Im + i, _mm256_blendv_pd(_mm256_div_pd(q1i, two), li, linear));
+        _mm256_storeu_pd(v.x2Re + i, _mm256_div_pd(q2r, two));
+        _mm256_storeu_pd(v.x2Im + i, _mm256_div_pd(q2i, two));
+
+        int linearBits = _mm256_movemask_pd(linear);
+        int zeroBBits = _mm256_movemask_pd(zeroB);
+        int zeroCBits = _mm256_movemask_pd(zeroC);
+        int zeroDBits = _mm256_movemask_pd(zeroD);
+        for (int lane = 0; lane < 4; ++lane) {
+            int bit = 1 << lane;
+            signed char n;
+            if (linearBits & bit) {
+                if (zeroBBits & bit) {
+                    n = (zeroCBits & bit) ? BATCH_DEGENERATE : 0;
+                } else {
+                    n = 1;
+                }
+            } else {
+                n = (zeroDBits & bit) ? 1 : 2;
+            }
+            v.count[i + lane] = n;
+        }
+    }
+
+    solveComplexScalar(v, i, end);
+}
+#endif
+
+BatchKernel detectBatchKernel() {
+#ifdef HAVE_X86_KERNELS
+    static const BatchKernel detected = __builtin_cpu_supports("avx2") ? KERNEL_AVX2 : KERNEL_SCALAR;
+    return detected;
+#else
+    return KERNEL_SCALAR;
+#endif
+}
+
+bool parseBatchKernel(std::string_view name, BatchKernel* kernel) {
+    if (name == "auto") {
+        *kernel = KERNEL_AUTO;
+    } else if (name == "scalar") {
+        *kernel = KERNEL_SCALAR;
+    } else if (name == "avx2") {
+        *kernel = KERNEL_AVX2;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void solveRealBatch(const double* a, const double* b, const double* c,
+                    double* x1, double* x2, signed char* count,
+                    std::size_t begin, std::size_t end,
+                    BatchKernel kernel) {
+    if (kernel == KERNEL_AUTO) {
+        kernel = detectBatchKernel();
+    }
+#ifdef HAVE_X86_KERNELS
+    if (kernel == KERNEL_AVX2 && detectBatchKernel() == KERNEL_AVX2) {
+        solveRealAVX2(a, b, c, x1, x2, count, begin, end);
+        return;
+    }
+#endif
+    solveRealScalar(a, b, c, x1, x2, count, begin, end);
+}
+
+void countRealRoots(const double* a, const double* b, const double* c,
+                    std::size_t begin, std::size_t end, BatchRootHistogram* histogram,
+                    BatchKernel kernel) {
+    if (kernel == KERNEL_AUTO) {
+        kernel = detectBatchKernel();
+    }
+#ifdef HAVE_X86_KERNELS
+    if (kernel == KERNEL_AVX2 && detectBatchKernel() == KERNEL_AVX2) {
+        countRealRootsAVX2(a, b, c, begin, end, histogram);
+        return;
+    }
+#endif
+    countRealRootsScalar(a, b, c, begin, end, histogram);
+}
+
+void solveComplexBatch(const ComplexBatchView& batch, std::size_t begin, std::size_t end,
+                       BatchKernel kernel) {
+    if (kernel == KERNEL_AUTO) {
+        kernel = detectBatchKernel();
+    }
+#ifdef HAVE_X86_KERNELS
+    if (kernel == KERNEL_AVX2 && detectBatchKernel() == KERNEL_AVX2) {
+        solveComplexAVX2(batch, begin, end);
+        return;
+    }
+#endif
+    solveComplexScalar(batch, begin, end);
+}
+
+// Адаптивный режим. Коэффициенты, с которыми работает путь float: ноль или модуль
+// из [2^-60, 2^60], тогда ни b^2, ни 4ac не выходят за пределы нормализованных float
+static const double FLOAT_PATH_MIN = 0x1p-60;
+static const double FLOAT_PATH_MAX = 0x1p60;
+// Множитель оценки погрешности: округление коэффициентов до float плюс
+// несколько округлений в самой формуле, в единицах младшего разряда
+static const float FLOAT_ERROR_ULPS = 8 * std::numeric_limits<float>::epsilon() / 2;
+// Дискриминант, неотличимый от нуля в double, должен решаться в double
+static const float FLOAT_MIN_DISCRIMINANT = 2 * EPS;
+
+static inline bool inFloatRange(double x, bool allowZero) {
+    double ax = std::abs(x);
+    return (allowZero && x == 0) || (ax >= FLOAT_PATH_MIN && ax <= FLOAT_PATH_MAX);
+}
+
+// Проверяет, что оценка относительной погрешности корня x не превышает tolerance:
+// 8u * (|a|x^2 + |b||x| + |c|) <= tolerance * |x| * sqrt(D)
+static inline bool floatRootAccurate(float a, float b, float c, float x, float s, float tolerance) {
+    float ax = std::abs(x);
+    float t = std::fma(std::abs(b), ax, std::abs(c));
+    t = std::fma(std::abs(a) * ax, ax, t);
+    float lhs = FLOAT_ERROR_ULPS * t;
+    float rhs = (tolerance * ax) * s;
+    return lhs <= rhs && lhs < std::numeric_limits<float>::infinity();
+}
+
+// Решает уравнение в float; возвращает false, если нужна большая точность.
+// Векторная версия (solveFloatAVX2) повторяет порядок операций до бита
+static inline bool solveFloat(double ad, double bd, double cd, float tolerance,
+                              double* x1, double* x2, signed char* count) {
+    if (!(std::abs(ad) >= 2 * EPS && inFloatRange(ad, false) && inFloatRange(bd, true) && inFloatRange(cd, true))) {
+        return false;
+    }
+    float a = static_cast<float>(ad);
+    float b = static_cast<float>(bd);
+    float c = static_cast<float>(cd);
+
+    float fourA = 4.f * a;
+    float p = fourA * c;
+    float e = std::fma(fourA, c, -p);
+    float d = std::fma(b, b, -p) - e;
+    float bound = FLOAT_ERROR_ULPS * std::fma(b, b, std::abs(p));
+    float absD = std::abs(d);
+    if (!(absD > bound && absD >= FLOAT_MIN_DISCRIMINANT)) {
+        return false;
+    }
+    if (d < 0) {
+        *count = 0;
+        return true;
+    }
+
+    float s = std::sqrt(d);
+    float q = -0.5f * (b + std::copysign(s, b));
+    float r1 = q / a;
+    float r2 = c / q;
+    float plus = std::signbit(b) ? r1 : r2;
+    float minus = std::signbit(b) ? r2 : r1;
+    if (!floatRootAccurate(a, b, c, plus, s, tolerance) || !floatRootAccurate(a, b, c, minus, s, tolerance)) {
+        return false;
+    }
+    *x1 = plus;
+    *x2 = minus;
+    *count = 2;
+    return true;
+}
+
+static inline float fmaReal(float x, float y, float z) { return std::fma(x, y, z); }
+static inline double fmaReal(double x, double y, double z) { return std::fma(x, y, z); }
+static inline long double fmaReal(long double x, long double y, long double z) { return std::fma(x, y, z); }
+
+// Устойчивое решение в типе Real. Классификация совпадает с solveRealScalar;
+// возвращает false, если оценка погрешности корней превышает tolerance
+template <class Real>
+static bool solveStable(Real a, Real b, Real c, Real tolerance, Real* x1, Real* x2, signed char* count) {
+    if (std::abs(a) < EPS) {
+        if (std::abs(b) < EPS) {
+            *count = (std::abs(c) < EPS) ? BATCH_DEGENERATE : 0;
+        } else {
+            *x1 = -c / b;
+            *count = 1;
+        }
+        return true;
+    }
+
+    Real fourA = 4 * a;
+    Real p = fourA * c;
+    Real e = fmaReal(fourA, c, -p);
+    Real d = fmaReal(b, b, -p) - e;
+    if (std::abs(d) < EPS) {
+        *x1 = (0 - b) / a / 2;
+        *count = 1;
+        return true;
+    }
+    if (!(d > 0)) {
+        *count = 0;
+        return true;
+    }
+
+    Real s = std::sqrt(d);
+    Real q = -(b + std::copysign(s, b)) / 2;
+    Real r1 = q / a;
+    Real r2 = c / q;
+    *x1 = std::signbit(b) ? r1 : r2;
+    *x2 = std::signbit(b) ? r2 : r1;
+    *count = 2;
+
+    const Real ulps = 8 * std::numeric_limits<Real>::epsilon() / 2;
+    for (Real x : {*x1, *x2}) {
+        Real ax = std::abs(x);
+        Real lhs = ulps * (std::abs(a) * ax * ax + std::abs(b) * ax + std::abs(c));
+        if (!(lhs <= tolerance * ax * s)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void escalate(const double* a, const double* b, const double* c,
+                     double* x1, double* x2, signed char* count, unsigned char* precision,
+                     std::size_t i, double tolerance, BatchAdaptiveCounters* counters) {
+    if (solveStable<double>(a[i], b[i], c[i], tolerance, &x1[i], &x2[i], &count[i])) {
+        precision[i] = BATCH_DOUBLE;
+        ++counters->solvedDouble;
+        return;
+    }
+    long double r1 = 0, r2 = 0;
+    solveStable<long double>(a[i], b[i], c[i], tolerance, &r1, &r2, &count[i]);
+    x1[i] = static_cast<double>(r1);
+    x2[i] = static_cast<double>(r2);
+    precision[i] = BATCH_LONG_DOUBLE;
+    ++counters->solvedLongDouble;
+}
+
+static void solveAdaptiveScalar(const double* a, const double* b, const double* c,
+                                double* x1, double* x2, signed char* count, unsigned char* precision,
+                                std::size_t begin, std::size_t end, double tolerance,
+                                BatchAdaptiveCounters* counters) {
+    float floatTolerance = static_cast<float>(tolerance);
+    for (std::size_t i = begin; i < end; ++i) {
+        if (solveFloat(a[i], b[i], c[i], floatTolerance, &x1[i], &x2[i], &count[i])) {
+            precision[i] = BATCH_FLOAT;
+            ++counters->solvedFloat;
+        } else {
+            escalate(a, b, c, x1, x2, count, precision, i, tolerance, counters);
+        }
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+#define AVX2_FMA __attribute__((target("avx2,fma")))
+
+AVX2_FMA static inline __m256 absPs(__m256 x) {
+    return _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+}
+
+// Маска (по 4 бита на половину) коэффициентов, допустимых для пути float
+AVX2_FMA static inline int inFloatRangeMask(__m256d x, bool allowZero) {
+    __m256d ax = _mm256_and_pd(x, _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL)));
+    __m256d ok = _mm256_and_pd(_mm256_cmp_pd(ax, _mm256_set1_pd(FLOAT_PATH_MIN), _CMP_GE_OQ),
+                               _mm256_cmp_pd(ax, _mm256_set1_pd(FLOAT_PATH_MAX), _CMP_LE_OQ));
+    if (allowZero) {
+        ok = _mm256_or_pd(ok, _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_EQ_OQ));
+    }
+    return _mm256_movemask_pd(ok);
+}
+
+AVX2_FMA static inline __m256 loadFloat8(const double* x, int* rangeMask, bool allowZero) {
+    __m256d lo = _mm256_loadu_pd(x);
+    __m256d hi = _mm256_loadu_pd(x + 4);
+    *rangeMask = inFloatRangeMask(lo, allowZero) | (inFloatRangeMask(hi, allowZero) << 4);
+    return _mm256_set_m128(_mm256_cvtpd_ps(hi), _mm256_cvtpd_ps(lo));
+}
+
+AVX2_FMA static inline __m256 floatRootAccurateMask(__m256 a, __m256 b, __m256 c, __m256 x, __m256 s, __m256 tolerance) {
+    __m256 ax = absPs(x);
+    __m256 t = _mm256_fmadd_ps(absPs(b), ax, absPs(c));
+    t = _mm256_fmadd_ps(_mm256_mul_ps(absPs(a), ax), ax, t);
+    __m256 lhs = _mm256_mul_ps(_mm256_set1_ps(FLOAT_ERROR_ULPS), t);
+    __m256 rhs = _mm256_mul_ps(_mm256_mul_ps(tolerance, ax), s);
+    return _mm256_and_ps(_mm256_cmp_ps(lhs, rhs, _CMP_LE_OQ),
+                         _mm256_cmp_ps(lhs, _mm256_set1_ps(std::numeric_limits<float>::infinity()), _CMP_LT_OQ));
+}
+
+AVX2_FMA static void solveAdaptiveAVX2(const double* a, const double* b, const double* c,
+                                       double* x1, double* x2, signed char* count, unsigned char* precision,
+                                       std::size_t begin, std::size_t end, double tolerance,
+                                       BatchAdaptiveCounters* counters) {
+    const __m256 signMask = _mm256_set1_ps(-0.f);
+    const __m256 vTolerance = _mm256_set1_ps(static_cast<float>(tolerance));
+    std::size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        int rangeA, rangeB, rangeC;
+        __m256 va = loadFloat8(a + i, &rangeA, false);
+        __m256 vb = loadFloat8(b + i, &rangeB, true);
+        __m256 vc = loadFloat8(c + i, &rangeC, true);
+        __m256d minA = _mm256_set1_pd(2 * EPS);
+        int notLinear = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(_mm256_loadu_pd(a + i), _mm256_castsi256_pd(
+                            _mm256_set1_epi64x(0x7fffffffffffffffLL))), minA, _CMP_GE_OQ))
+                        | (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(_mm256_loadu_pd(a + i + 4), _mm256_castsi256_pd(
+                            _mm256_set1_epi64x(0x7fffffffffffffffLL))), minA, _CMP_GE_OQ)) << 4);
+
+        __m256 fourA = _mm256_mul_ps(_mm256_set1_ps(4.f), va);
+        __m256 p = _mm256_mul_ps(fourA, vc);
+        __m256 e = _mm256_fmsub_ps(fourA, vc, p);
+        __m256 d = _mm256_sub_ps(_mm256_fmsub_ps(vb, vb, p), e);
+        __m256 bound = _mm256_mul_ps(_mm256_set1_ps(FLOAT_ERROR_ULPS), _mm256_fmadd_ps(vb, vb, absPs(p)));
+        __m256 absD = absPs(d);
+        __m256 separated = _mm256_and_ps(_mm256_cmp_ps(absD, bound, _CMP_GT_OQ),
+                                         _mm256_cmp_ps(absD, _mm256_set1_ps(FLOAT_MIN_DISCRIMINANT), _CMP_GE_OQ));
+        __m256 negative = _mm256_cmp_ps(d, _mm256_setzero_ps(), _CMP_LT_OQ);
+
+        __m256 s = _mm256_sqrt_ps(d);
+        __m256 q = _mm256_mul_ps(_mm256_set1_ps(-0.5f), _mm256_add_ps(vb, _mm256_or_ps(s, _mm256_and_ps(vb, signMask))));
+        __m256 r1 = _mm256_div_ps(q, va);
+        __m256 r2 = _mm256_div_ps(vc, q);
+        // blendv выбирает по знаковому биту b, как std::signbit
+        __m256 plus = _mm256_blendv_ps(r2, r1, vb);
+        __m256 minus = _mm256_blendv_ps(r1, r2, vb);
+        __m256 accurate = _mm256_and_ps(floatRootAccurateMask(va, vb, vc, plus, s, vTolerance),
+                                        floatRootAccurateMask(va, vb, vc, minus, s, vTolerance));
+
+        int okMask = rangeA & rangeB & rangeC & notLinear & _mm256_movemask_ps(separated);
+        int negativeMask = _mm256_movemask_ps(negative);
+        int accurateMask = _mm256_movemask_ps(accurate);
+
+        _mm256_storeu_pd(x1 + i, _mm256_cvtps_pd(_mm256_castps256_ps128(plus)));
+        _mm256_storeu_pd(x1 + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(plus, 1)));
+        _mm256_storeu_pd(x2 + i, _mm256_cvtps_pd(_mm256_castps256_ps128(minus)));
+        _mm256_storeu_pd(x2 + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(minus, 1)));
+        for (int lane = 0; lane < 8; ++lane) {
+            int bit = 1 << lane;
+            if ((okMask & bit) && (negativeMask & bit)) {
+                count[i + lane] = 0;
+            } else if ((okMask & bit) && (accurateMask & bit)) {
+                count[i + lane] = 2;
+            } else {
+                escalate(a, b, c, x1, x2, count, precision, i + lane, tolerance, counters);
+                continue;
+            }
+            precision[i + lane] = BATCH_FLOAT;
+            ++counters->solvedFloat;
+        }
+    }
+    solveAdaptiveScalar(a, b, c, x1, x2, count, precision, i, end, tolerance, counters);
+}
+
+static bool hasFMA() {
+    static const bool supported = __builtin_cpu_supports("fma");
+    return supported;
+}
+#endif
+
+void solveRealBatchAdaptive(const double* a, const double* b, const double* c,
+                            double* x1, double* x2, signed char* count, unsigned char* precision,
+                            std::size_t begin, std::size_t end, double tolerance,
+                            BatchAdaptiveCounters* counters, BatchKernel kernel) {
+    if (kernel == KERNEL_AUTO) {
+        kernel = detectBatchKernel();
+    }
+#ifdef HAVE_X86_KERNELS
+    if (kernel == KERNEL_AVX2 && detectBatchKernel() == KERNEL_AVX2 && hasFMA()) {
+        solveAdaptiveAVX2(a, b, c, x1, x2, count, precision, begin, end, tolerance, counters);
+        return;
+    }
+#endif
+    solveAdaptiveScalar(a, b, c, x1, x2, count, precision, begin, end, tolerance, counters);
+}
@@ -0,0 +1,402 @@
+#include <batchsolverapp.h>
+#include <numparse.h>
+#include <field.h>
+#include <resultwriter.h>
+#include <threadpool.h>
+#include <trace.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void BatchSolverApp::RealBatch::resize(std::size_t size) {
+    for (auto* column : {&a, &b, &c, &x1, &x2}) {
+        column->resize(size);
+    }
+    count.resize(size);
+    precision.resize(adaptive ? size : 0);
+}
+
+void BatchSolverApp::RealBatch::set(std::size_t index, int column, double value) {
+    std::vector<double>* columns[3] = {&a, &b, &c};
+    (*columns[column])[index] = value;
+}
+
+void BatchSolverApp::RealBatch::solve(BatchKernel kernel, std::size_t begin, std::size_t end,
+                                      BatchAdaptiveCounters* counters) {
+    if (adaptive) {
+        solveRealBatchAdaptive(a.data(), b.data(), c.data(), x1.data(), x2.data(), count.data(), precision.data(),
+                               begin, end, tolerance, counters, kernel);
+    } else {
+        solveRealBatch(a.data(), b.data(), c.data(), x1.data(), x2.data(), count.data(),
+                       begin, end, kernel);
+    }
+}
+
+void BatchSolverApp::RealBatch::writeRoot(ResultWriter& out, std::size_t i, int index) const {
+    double root = (index == 0) ? x1[i] : x2[i];
+    // Корни, найденные в float, выводятся с точностью float
+    if (adaptive && precision[i] == BATCH_FLOAT) {
+        out << static_cast<float>(root);
+    } else {
+        out << root;
+    }
+}
+
+void BatchSolverApp::ComplexBatch::resize(std::size_t size) {
+    for (auto* column : {&aRe, &aIm, &bRe, &bIm, &cRe, &cIm, &x1Re, &x1Im, &x2Re, &x2Im}) {
+        column->resize(size);
+    }
+    count.resize(size);
+}
+
+void BatchSolverApp::ComplexBatch::set(std::size_t index, int column, const std::complex<double>& value) {
+    std::vector<double>* columns[3][2] = {{&aRe, &aIm}, {&bRe, &bIm}, {&cRe, &cIm}};
+    (*columns[column][0])[index] = value.real();
+    (*columns[column][1])[index] = value.imag();
+}
+
+void BatchSolverApp::ComplexBatch::solve(BatchKernel kernel, std::size_t begin, std::size_t end,
+                                         BatchAdaptiveCounters*) {
+    ComplexBatchView view = {
+        aRe.data(), aIm.data(), bRe.data(), bIm.data(), cRe.data(), cIm.data(),
+        x1Re.data(), x1Im.data(), x2Re.data(), x2Im.data(), count.data()
+    };
+    solveComplexBatch(view, begin, end, kernel);
+}
+
+void BatchSolverApp::ComplexBatch::writeRoot(ResultWriter& out, std::size_t i, int index) const {
+    out << ((index == 0) ? std::complex<double>(x1Re[i], x1Im[i]) : std::complex<double>(x2Re[i], x2Im[i]));
+}
+
+static bool parseCoefficient(std::string_view token, double* value) {
+    bool ok = true;
+    *value = parseDouble(token, &ok);
+    return ok;
+}
+
+static bool parseCoefficient(std::string_view token, std::complex<double>* value) {
+    bool ok = true;
+    *value = parseComplex(token, &ok);
+    return ok;
+}
+
+static bool readFile(const std::string& fileName, std::string* data) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    *data = buffer.str();
+    return true;
+}
+
+static inline bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c));
+}
+
+// Вызывает callback(begin, end) для каждого токена в [begin, end)
+template <class Callback>
+static void forEachToken(const char* begin, const char* end, Callback callback) {
+    while (true) {
+        while (begin != end && isSpace(*begin)) {
+            ++begin;
+        }
+        if (begin == end) {
+            return;
+        }
+        const char* tokenEnd = begin;
+        while (tokenEnd != end && !isSpace(*tokenEnd)) {
+            ++tokenEnd;
+        }
+        if (!callback(begin, tokenEnd)) {
+            return;
+        }
+        begin = tokenEnd;
+    }
+}
+
+template <class Batch>
+int BatchSolverApp::load(const std::string& fileName, Batch* batch) const {
+    TraceSpan span("solvebatch", "load");
+    std::string data;
+    if (!readFile(fileName, &data)) {
+        return STATUS_FILE_ERROR;
+    }
+
+    // Файл делится на части по границам токенов. Первый проход считает токены
+    // в каждой части, второй --- разбирает их сразу на свои места в массивах.
+    ThreadPool& pool = parent_->getThreadPool();
+    std::size_t pieces = std::max<std::size_t>(1, std::min<std::size_t>(pool.size() * 4, data.size() / 4096));
+    std::vector<std::size_t> bounds(pieces + 1, data.size());
+    bounds[0] = 0;
+    for (std::size_t k = 1; k < pieces; ++k) {
+        std::size_t pos = std::max(bounds[k - 1], data.size() / pieces * k);
+        while (pos < data.size() && !isSpace(data[pos])) {
+            ++pos;
+        }
+        bounds[k] = pos;
+    }
+
+    const char* text = data.data();
+    std::vector<std::size_t> firstToken(pieces + 1, 0);
+    pool.parallelFor(pieces, [&](std::size_t k) {
+        std::size_t tokens = 0;
+        forEachToken(text + bounds[k], text + bounds[k + 1], [&](const char*, const char*) {
+            ++tokens;
+            return true;
+        });
+        firstToken[k + 1] = tokens;
+    });
+    for (std::size_t k = 0; k < pieces; ++k) {
+        firstToken[k + 1] += firstToken[k];
+    }
+
+    std::size_t total = firstToken[pieces];
+    if (total % 3 != 0) {
+        LOG_ERROR(parent_) << "Number of coefficients is not a multiple of 3\n";
+        return STATUS_PARSE_ERROR;
+    }
+    batch->resize(total / 3);
+
+    std::vector<std::string> badTokens(pieces);
+    std::vector<std::size_t> badIndex(pieces, total);
+    pool.parallelFor(pieces, [&](std::size_t k) {
+        TraceSpan span("solvebatch", "parse piece");
+        std::size_t index = firstToken[k];
+        forEachToken(text + bounds[k], text + bounds[k + 1], [&](const char* begin, const char* end) {
+            std::string_view token(begin, end - begin);
+            typename Batch::Field value;
+            if (!parseCoefficient(token, &value)) {
+                badTokens[k] = std::string(token);
+                badIndex[k] = index;
+                return false;
+            }
+            batch->set(index / 3, index % 3, value);
+            ++index;
+            return true;
+        });
+    });
+
+    for (std::size_t k = 0; k < pieces; ++k) {
+        if (badIndex[k] != total) {
+            LOG_ERROR(parent_) << "Cannot parse coefficient #" << (badIndex[k] + 1) << ": " << badTokens[k] << '\n';
+            return STATUS_PARSE_ERROR;
+        }
+    }
+    return STATUS_OK;
+}
+
+// Сообщение о числе решений уравнения (см. \ref BatchRootCount), как у solve
+template <class Stream>
+static void writeSolutionCount(Stream& out, int count) {
+    if (count == BATCH_DEGENERATE) {
+        out << "Equation is degenerate: every value is its solution\n";
+    } else {
+        out << "Equation has " << count << " solution" << (count == 1 ? "" : "s") << ":\n";
+    }
+}
+
+template <class Batch>
+void BatchSolverApp::print(const Batch& batch, std::size_t begin, std::size_t end, std::string& text) const {
+    // С приёмником сообщений заголовки пишутся в него после результатов (см. loadSolveAndPrint)
+    bool verbose = parent_->isLogEnabled(VERB_INFO) && parent_->getLogSink() == nullptr;
+    ResultWriter out(text, parent_->getPrecision());
+    for (std::size_t i = begin; i < end; ++i) {
+        int count = batch.count[i];
+        if (verbose) {
+            out << Console::PROMPT_INFO;
+            writeSolutionCount(out, count);
+        }
+        if (count == BATCH_DEGENERATE) {
+            continue;
+        }
+        for (int j = 0; j < count; ++j) {
+            if (j != 0) {
+                out << ' ';
+            }
+            batch.writeRoot(out, i, j);
+        }
+        out << '\n';
+    }
+}
+
+std::size_t BatchSolverApp::getChunkSize(std::size_t size) const {
+    std::string str = parent_->getVariable("batch_chunk", "auto");
+    if (str == "auto") {
+        // Около восьми блоков на поток, чтобы перехват работы сглаживал неравномерность
+        std::size_t chunk = size / (parent_->getThreads() * 8);
+        chunk = std::max<std::size_t>(4096, std::min<std::size_t>(chunk, 1 << 16));
+        return chunk;
+    }
+    char* end;
+    long chunk = std::strtol(str.c_str(), &end, 10);
+    if (*end != '\0' || chunk <= 0) {
+        return 0;
+    }
+    return chunk;
+}
+
+template <class Batch>
+int BatchSolverApp::loadSolveAndPrint(const std::string& fileName, BatchKernel kernel, Batch* batch,
+                                      BatchAdaptiveCounters* counters) const {
+    std::size_t chunkSize = getChunkSize(0);
+    if (chunkSize == 0) {
+        return STATUS_BAD_CHUNK;
+    }
+
+    int status = load(fileName, batch);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    std::size_t size = batch->count.size();
+    chunkSize = getChunkSize(size);
+    std::size_t chunks = (size + chunkSize - 1) / chunkSize;
+    std::vector<std::string> texts(chunks);
+    // У каждого блока свои счётчики, чтобы потоки не писали в общую память
+    std::vector<BatchAdaptiveCounters> chunkCounters(chunks);
+    parent_->getThreadPool().parallelFor(chunks, [&](std::size_t k) {
+        std::size_t begin = k * chunkSize;
+        std::size_t end = std::min(size, begin + chunkSize);
+        {
+            TraceSpan span("solvebatch", "solve chunk");
+            batch->solve(kernel, begin, end, &chunkCounters[k]);
+        }
+        TraceSpan span("solvebatch", "print chunk");
+        print(*batch, begin, end, texts[k]);
+    });
+
+    TraceSpan span("solvebatch", "write");
+    for (const auto& text : texts) {
+        parent_->output().write(text.data(), text.size());
+    }
+    // Приёмник сообщений пишет только поток команд, поэтому заголовки не выводятся из потоков пула
+    if (parent_->getLogSink() != nullptr && parent_->isLogEnabled(VERB_INFO)) {
+        for (signed char count : batch->count) {
+            writeSolutionCount(parent_->info(), count);
+        }
+    }
+    for (const auto& chunk : chunkCounters) {
+        counters->solvedFloat += chunk.solvedFloat;
+        counters->solvedDouble += chunk.solvedDouble;
+        counters->solvedLongDouble += chunk.solvedLongDouble;
+    }
+    return STATUS_OK;
+}
+
+int BatchSolverApp::solveAdaptive(const std::string& fileName, BatchKernel kernel) {
+    char* end;
+    std::string str = parent_->getVariable("tolerance", "1e-6");
+    double tolerance = std::strtod(str.c_str(), &end);
+    if (*end != '\0' || !(tolerance > 0)) {
+        return STATUS_BAD_TOLERANCE;
+    }
+
+    RealBatch batch;
+    batch.adaptive = true;
+    batch.tolerance = tolerance;
+    BatchAdaptiveCounters counters;
+    int status = loadSolveAndPrint(fileName, kernel, &batch, &counters);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    LOG_INFO(parent_) << "Solved in float: " << counters.solvedFloat
+                    << ", escalated to double: " << counters.solvedDouble
+                    << ", escalated to long double: " << counters.solvedLongDouble << '\n';
+    totals_.solvedFloat += counters.solvedFloat;
+    totals_.solvedDouble += counters.solvedDouble;
+    totals_.solvedLongDouble += counters.solvedLongDouble;
+    parent_->setVariable("adaptive_float", std::to_string(totals_.solvedFloat));
+    parent_->setVariable("adaptive_double", std::to_string(totals_.solvedDouble));
+    parent_->setVariable("adaptive_long_double", std::to_string(totals_.solvedLongDouble));
+    return STATUS_OK;
+}
+
+int BatchSolverApp::exec(ArgList args) {
+    if (args.size() != 2) {
+        return STATUS_BAD_ARGUMENTS;
+    }
+
+    BatchKernel kernel;
+    if (!parseBatchKernel(parent_->getVariable("kernel", "auto"), &kernel)) {
+        return STATUS_BAD_KERNEL;
+    }
+
+    std::string mode = parent_->getVariable("mode", "exact");
+    if (mode == "adaptive") {
+        return (parent_->getField() == FIELD_REAL) ? solveAdaptive(std::string(args[1]), kernel) : STATUS_BAD_MODE;
+    } else if (mode != "exact") {
+        return STATUS_BAD_MODE;
+    }
+
+    BatchAdaptiveCounters counters;
+    switch (parent_->getField()) {
+        case FIELD_REAL: {
+            RealBatch batch;
+            return loadSolveAndPrint(std::string(args[1]), kernel, &batch, &counters);
+        }
+        case FIELD_COMPLEX: {
+            ComplexBatch batch;
+            return loadSolveAndPrint(std::string(args[1]), kernel, &batch, &counters);
+        }
+        default:
+            return STATUS_BAD_FIELD;
+    }
+}
+
+const char* BatchSolverApp::getStatusCodeDescription(int statusCode) {
+    switch (statusCode) {
+        case STATUS_OK:
+            return "OK";
+        case STATUS_BAD_ARGUMENTS:
+            return "Number of arguments should be exactly 1";
+        case STATUS_BAD_FIELD:
+            return "'field' value is invalid";
+        case STATUS_PARSE_ERROR:
+            return "Error while parsing coefficients";
+        case STATUS_FILE_ERROR:
+            return "Cannot open file";
+        case STATUS_BAD_KERNEL:
+            return "'kernel' value is invalid";
+        case STATUS_BAD_CHUNK:
+            return "'batch_chunk' value is invalid";
+        case STATUS_BAD_MODE:
+            return "'mode' value is invalid (adaptive mode needs field R)";
+        case STATUS_BAD_TOLERANCE:
+            return "'tolerance' value is invalid";
+        default:
+            return "Invalid status code";
+    }
+}
+
+const char* BatchSolverApp::getHelp() {
+    return  "Usage: solvebatch <filename>\n"
+            "Reads triples 'a b c' from file <filename> and solves every\n"
+            "equation a*x^2 + b*x + c = 0. Output is the same as for a sequence\n"
+            "of 'solve a b c' commands, except that over field C roots may differ\n"
+            "in the last unit of precision: complex square root and division\n"
+            "(Smith's algorithm) are vectorized. Numbers of roots are the same.\n"
+            "Coefficients are taken from the field selected by variable \"field\"\n"
+            "(R or C, see 'help solve').\n"
+            "Variable \"kernel\" selects the implementation:\n"
+            " auto   - best one available on this CPU (default)\n"
+            " scalar - portable scalar code\n"
+            " avx2   - vectorized code (falls back to scalar if AVX2 is not supported)\n"
+            "Work is split into chunks and done in parallel. Number of threads\n"
+            "is taken from variable \"threads\" (default: auto, one per CPU),\n"
+            "chunk size (in equations) - from variable \"batch_chunk\" (default: auto).\n"
+            "Variable \"mode\" selects the algorithm:\n"
+            " exact    - same roots as 'solve' (over field R bit for bit) (default)\n"
+            " adaptive - numerically stable formula (no cancellation when b^2 >> 4ac),\n"
+            "            solved in float first; equations whose estimated relative error\n"
+            "            exceeds variable \"tolerance\" (default: 1e-6) are solved again in\n"
+            "            double or long double. Roots found in float are printed as float.\n"
+            "            Only field R is supported. Variables \"adaptive_float\",\n"
+            "            \"adaptive_double\" and \"adaptive_long_double\" count equations\n"
+            "            solved with each precision.";
+}
@@ -0,0 +1,232 @@
+#include <binaryformat.h>
+#include <batchkernel.h>
+#include <algorithm>
+#include <cstring>
+
+constexpr std::uint32_t BinaryFormat::VERSION;
+constexpr std::size_t BinaryFormat::HEADER_SIZE;
+constexpr std::uint32_t BinaryFormat::DEFAULT_BLOCK_SIZE;
+
+static const char EQUATIONS_MAGIC[4] = {'S', 'Q', 'E', 'Q'};
+static const char RESULTS_MAGIC[4] = {'S', 'Q', 'R', 'S'};
+
+// Наибольший размер блока, который согласен читать BinaryReader: защищает от
+// попытки выделить память по испорченному заголовку
+static constexpr std::uint32_t MAX_BLOCK_SIZE = 1 << 24;
+
+static void storeUint(unsigned char* dst, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        dst[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+static std::uint64_t loadUint(const unsigned char* src, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= std::uint64_t(src[i]) << (8 * i);
+    }
+    return value;
+}
+
+static inline void storeDouble(unsigned char* dst, double value) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::memcpy(dst, &value, sizeof(value));
+#else
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(value));
+    storeUint(dst, bits, 8);
+#endif
+}
+
+static inline double loadDouble(const unsigned char* src) {
+    double value;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    std::memcpy(&value, src, sizeof(value));
+#else
+    std::uint64_t bits = loadUint(src, 8);
+    std::memcpy(&value, &bits, sizeof(value));
+#endif
+    return value;
+}
+
+// Размер блока из size уравнений в байтах
+static std::size_t blockBytes(BinaryKind kind, bool complex, std::size_t size) {
+    std::size_t bytes = BinaryFormat::columnCount(kind, complex) * size * sizeof(double);
+    if (kind == BINARY_RESULTS) {
+        bytes += (2 * size + 7) / 8 * 8;
+    }
+    return bytes;
+}
+
+void BinaryBlock::resize(std::size_t newSize, std::size_t columnCount, bool withCount) {
+    size = newSize;
+    columns.resize(columnCount);
+    for (auto& column : columns) {
+        column.resize(newSize);
+    }
+    count.resize(withCount ? newSize : 0);
+}
+
+std::size_t BinaryFormat::columnCount(BinaryKind kind, bool complex) {
+    std::size_t columns = (kind == BINARY_EQUATIONS) ? 3 : 2;
+    return complex ? 2 * columns : columns;
+}
+
+bool BinaryFormat::isBinaryFile(const std::string& fileName) {
+    std::ifstream in(fileName, std::ios::binary);
+    char magic[4];
+    if (!in.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, EQUATIONS_MAGIC, 4) == 0 || std::memcmp(magic, RESULTS_MAGIC, 4) == 0;
+}
+
+bool BinaryReader::open(const std::string& fileName) {
+    error_.clear();
+    in_.open(fileName, std::ios::binary);
+    if (!in_) {
+        error_ = "Cannot open file " + fileName;
+        return false;
+    }
+    unsigned char header[BinaryFormat::HEADER_SIZE];
+    if (!in_.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        error_ = "File is too short for a header";
+        return false;
+    }
+    if (std::memcmp(header, EQUATIONS_MAGIC, 4) == 0) {
+        kind_ = BINARY_EQUATIONS;
+    } else if (std::memcmp(header, RESULTS_MAGIC, 4) == 0) {
+        kind_ = BINARY_RESULTS;
+    } else {
+        error_ = "Not a binary equations or results file";
+        return false;
+    }
+    std::uint32_t version = loadUint(header + 4, 4);
+    std::uint32_t field = loadUint(header + 8, 4);
+    blockSize_ = loadUint(header + 12, 4);
+    count_ = loadUint(header + 16, 8);
+    read_ = 0;
+    if (version != BinaryFormat::VERSION) {
+        error_ = "Unsupported format version " + std::to_string(version);
+        return false;
+    }
+    if (field > 1) {
+        error_ = "Unknown field code " + std::to_string(field);
+        return false;
+    }
+    if (blockSize_ == 0 || blockSize_ > MAX_BLOCK_SIZE) {
+        error_ = "Bad block size " + std::to_string(blockSize_);
+        return false;
+    }
+    complex_ = (field == 1);
+    return true;
+}
+
+bool BinaryReader::readBlock(BinaryBlock* block) {
+    if (read_ >= count_) {
+        return false;
+    }
+    std::size_t size = std::min<std::uint64_t>(blockSize_, count_ - read_);
+    bytes_.resize(blockBytes(kind_, complex_, size));
+    if (!in_.read(reinterpret_cast<char*>(bytes_.data()), bytes_.size())) {
+        error_ = "File is truncated at equation #" + std::to_string(read_ + 1);
+        return false;
+    }
+
+    block->resize(size, BinaryFormat::columnCount(kind_, complex_), kind_ == BINARY_RESULTS);
+    const unsigned char* src = bytes_.data();
+    if (kind_ == BINARY_RESULTS) {
+        // Число корней задаёт, сколько столбцов корней читать потребителю, поэтому
+        // повреждённые байты счётчиков отвергаются здесь
+        for (std::size_t i = 0; i < size; ++i) {
+            if (src[i] > 2 || src[size + i] > 1) {
+                error_ = "Damaged file: bad root count at equation #" + std::to_string(read_ + i + 1);
+                return false;
+            }
+            block->count[i] = src[size + i] ? static_cast<signed char>(BATCH_DEGENERATE) : static_cast<signed char>(src[i]);
+        }
+        src += (2 * size + 7) / 8 * 8;
+    }
+    for (auto& column : block->columns) {
+        for (std::size_t i = 0; i < size; ++i, src += sizeof(double)) {
+            column[i] = loadDouble(src);
+        }
+    }
+    read_ += size;
+    return true;
+}
+
+bool BinaryWriter::open(const std::string& fileName, BinaryKind kind, bool complex, std::uint32_t blockSize) {
+    error_.clear();
+    kind_ = kind;
+    complex_ = complex;
+    blockSize_ = blockSize;
+    count_ = 0;
+    lastBlock_ = false;
+    out_.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        error_ = "Cannot create file " + fileName;
+        return false;
+    }
+    // Число уравнений пока неизвестно и записывается в close()
+    unsigned char header[BinaryFormat::HEADER_SIZE] = {};
+    std::memcpy(header, kind == BINARY_EQUATIONS ? EQUATIONS_MAGIC : RESULTS_MAGIC, 4);
+    storeUint(header + 4, BinaryFormat::VERSION, 4);
+    storeUint(header + 8, complex ? 1 : 0, 4);
+    storeUint(header + 12, blockSize, 4);
+    out_.write(reinterpret_cast<const char*>(header), sizeof(header));
+    return bool(out_);
+}
+
+bool BinaryWriter::writeBlock(const BinaryBlock& block) {
+    if (block.size == 0) {
+        return true;
+    }
+    if (lastBlock_ || block.size > blockSize_) {
+        error_ = "Only the last block may be smaller than the block size";
+        return false;
+    }
+    lastBlock_ = (block.size < blockSize_);
+
+    std::size_t size = block.size;
+    bytes_.assign(blockBytes(kind_, complex_, size), 0);
+    unsigned char* dst = bytes_.data();
+    if (kind_ == BINARY_RESULTS) {
+        for (std::size_t i = 0; i < size; ++i) {
+            bool degenerate = (block.count[i] == BATCH_DEGENERATE);
+            dst[i] = degenerate ? 0 : block.count[i];
+            dst[size + i] = degenerate ? 1 : 0;
+        }
+        dst += (2 * size + 7) / 8 * 8;
+    }
+    // Столбцы второго корня идут после столбцов первого
+    std::size_t perRoot = complex_ ? 2 : 1;
+    for (std::size_t k = 0; k < block.columns.size(); ++k) {
+        const std::vector<double>& column = block.columns[k];
+        int root = static_cast<int>(k / perRoot);
+        for (std::size_t i = 0; i < size; ++i, dst += sizeof(double)) {
+            if (kind_ == BINARY_EQUATIONS || root < block.count[i]) {
+                storeDouble(dst, column[i]);
+            }
+        }
+    }
+    out_.write(reinterpret_cast<const char*>(bytes_.data()), bytes_.size());
+    count_ += size;
+    if (!out_) {
+        error_ = "Write error";
+        return false;
+    }
+    return true;
+}
+
+bool BinaryWriter::close() {
+    unsigned char count[8];
+    storeUint(count, count_, 8);
+    out_.seekp(16);
+    out_.write(reinterpret_cast<const char*>(count), sizeof(count));
+    out_.close();
+    if (!out_ && error_.empty()) {
+        error_ = "Write error";
+    }
+    return error_.empty();
+}
@@ -0,0 +1,118 @@
+#include <binarysolverapp.h>
+#include <binaryformat.h>
+#include <batchkernel.h>
+#include <threadpool.h>
+#include <trace.h>
+#include <algorithm>
+
+// Решает уравнения блока с номерами из [begin, end)
+static void solveBlock(const BinaryBlock& equations, BinaryBlock* results, bool complex,
+                       std::size_t begin, std::size_t end, BatchKernel kernel) {
+    const auto& in = equations.columns;
+    auto& out = results->columns;
+    if (!complex) {
+        solveRealBatch(in[0].data(), in[1].data(), in[2].data(), out[0].data(), out[1].data(),
+                       results->count.data(), begin, end, kernel);
+        return;
+    }
+    ComplexBatchView view = {
+        in[0].data(), in[1].data(), in[2].data(), in[3].data(), in[4].data(), in[5].data(),
+        out[0].data(), out[1].data(), out[2].data(), out[3].data(), results->count.data()
+    };
+    solveComplexBatch(view, begin, end, kernel);
+}
+
+int BinarySolverApp::exec(ArgList args) {
+    if (args.size() != 3) {
+        return STATUS_BAD_ARGUMENTS;
+    }
+    BatchKernel kernel;
+    if (!parseBatchKernel(parent_->getVariable("kernel", "auto"), &kernel)) {
+        return STATUS_BAD_KERNEL;
+    }
+
+    BinaryReader reader;
+    if (!reader.open(std::string(args[1]))) {
+        LOG_ERROR(parent_) << reader.getError() << '\n';
+        return reader.getError().compare(0, 11, "Cannot open") == 0 ? STATUS_FILE_ERROR : STATUS_FORMAT_ERROR;
+    }
+    if (reader.getKind() != BINARY_EQUATIONS) {
+        LOG_ERROR(parent_) << "File " << args[1] << " contains results, not equations\n";
+        return STATUS_FORMAT_ERROR;
+    }
+    bool complex = reader.isComplex();
+    BinaryWriter writer;
+    if (!writer.open(std::string(args[2]), BINARY_RESULTS, complex, reader.getBlockSize())) {
+        LOG_ERROR(parent_) << writer.getError() << '\n';
+        return STATUS_FILE_ERROR;
+    }
+
+    ThreadPool& pool = parent_->getThreadPool();
+    BinaryBlock equations;
+    BinaryBlock results;
+    std::uint64_t solved = 0;
+    while (true) {
+        {
+            TraceSpan span("solvebin", "read");
+            if (!reader.readBlock(&equations)) {
+                break;
+            }
+        }
+        std::size_t size = equations.size;
+        results.resize(size, BinaryFormat::columnCount(BINARY_RESULTS, complex), true);
+        // Несколько частей на поток, чтобы перехват работы сглаживал неравномерность
+        std::size_t chunkSize = std::max<std::size_t>(4096, size / (pool.size() * 4));
+        std::size_t chunks = (size + chunkSize - 1) / chunkSize;
+        pool.parallelFor(chunks, [&](std::size_t k) {
+            TraceSpan span("solvebin", "solve chunk");
+            std::size_t begin = k * chunkSize;
+            solveBlock(equations, &results, complex, begin, std::min(size, begin + chunkSize), kernel);
+        });
+        TraceSpan span("solvebin", "write");
+        if (!writer.writeBlock(results)) {
+            LOG_ERROR(parent_) << writer.getError() << '\n';
+            return STATUS_WRITE_ERROR;
+        }
+        solved += size;
+    }
+    if (!reader.getError().empty()) {
+        LOG_ERROR(parent_) << reader.getError() << '\n';
+        return STATUS_FORMAT_ERROR;
+    }
+    if (!writer.close()) {
+        LOG_ERROR(parent_) << writer.getError() << '\n';
+        return STATUS_WRITE_ERROR;
+    }
+    LOG_INFO(parent_) << "Solved " << solved << " equation" << (solved == 1 ? "" : "s") << '\n';
+    return STATUS_OK;
+}
+
+const char* BinarySolverApp::getStatusCodeDescription(int statusCode) {
+    switch (statusCode) {
+        case STATUS_OK:
+            return "OK";
+        case STATUS_BAD_ARGUMENTS:
+            return "Number of arguments should be exactly 2";
+        case STATUS_FILE_ERROR:
+            return "Cannot open file";
+        case STATUS_FORMAT_ERROR:
+            return "Input is not a valid binary equations file";
+        case STATUS_WRITE_ERROR:
+            return "Cannot write results";
+        case STATUS_BAD_KERNEL:
+            return "'kernel' value is invalid";
+        default:
+            return "Invalid status code";
+    }
+}
+
+const char* BinarySolverApp::getHelp() {
+    return  "Usage: solvebin <equations> <results>\n"
+            "Solves every equation of binary file <equations> and writes roots to binary\n"
+            "file <results>. Binary files are made from text by 'convert', results are\n"
+            "turned back into text by 'convert' as well (see 'help convert').\n"
+            "Field (R or C) is stored in the equations file. Roots are bit for bit the\n"
+            "same as printed by 'solvebatch'. Files are processed block by block, so\n"
+            "they may be larger than memory. Variables \"kernel\" and \"threads\" are\n"
+            "used as by 'solvebatch'.";
+}
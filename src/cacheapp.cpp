@@ -0,0 +1,54 @@
+#include <cacheapp.h>
+#include <solverapp.h>
+#include <iostream>
+
+template <class Field>
+static void printCache(std::ostream& out, const char* field, const SolveCache<Field>& cache) {
+    out << field << ": hits " << cache.hits() << ", misses " << cache.misses()
+        << ", entries " << cache.size() << '/' << cache.capacity() << '\n';
+}
+
+int CacheApp::exec(ArgList args) {
+    auto iter = parent_->getApps().find(SolverApp::COMMAND);
+    SolverApp* solver = (iter == parent_->getApps().end()) ? nullptr : dynamic_cast<SolverApp*>(iter->second);
+    if (solver == nullptr) {
+        return STATUS_NO_SOLVER;
+    }
+
+    if (args.size() == 1) {
+        printCache(parent_->output(), "R", solver->getRealCache());
+        printCache(parent_->output(), "C", solver->getComplexCache());
+    } else if (args.size() == 2 && args[1] == "clear") {
+        solver->getRealCache().clear();
+        solver->getComplexCache().clear();
+    } else if (args.size() == 2 && args[1] == "reset") {
+        solver->getRealCache().resetCounters();
+        solver->getComplexCache().resetCounters();
+    } else {
+        return STATUS_BAD_ARGUMENTS;
+    }
+    return STATUS_OK;
+}
+
+const char* CacheApp::getStatusCodeDescription(int statusCode) {
+    switch (statusCode) {
+        case STATUS_OK:
+            return "OK";
+        case STATUS_BAD_ARGUMENTS:
+            return "Usage: cache [clear | reset]";
+        case STATUS_NO_SOLVER:
+            return "'solve' app is not installed";
+        default:
+            return "Invalid status code";
+    }
+}
+
+const char* CacheApp::getHelp() {
+    return  "Usage: cache [clear | reset]\n"
+            "'solve' remembers solutions of the last equations if variable \"cache_size\"\n"
+            "is set to a positive number (the cache is off by default). Equations are\n"
+            "looked up by their exact coefficients, separately for each field.\n"
+            "Without arguments, prints hits, misses and number of entries for each field.\n"
+            " clear - forget all remembered solutions\n"
+            " reset - set hit and miss counters to zero";
+}
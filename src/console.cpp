@@ -1,8 +1,20 @@
 #include <console.h>
+#include <threadpool.h>
+#include <resultwriter.h>
+#include <tokenizer.h>
+#include <script.h>
+#include <trace.h>
+#include <spscring.h>
+#include <logsink.h>
+#include <chrono>
 #include <iostream>
-#include <iomanip>
 #include <sstream>
-#include <algorithm>
+#include <thread>
+#include <iomanip>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <charconv>
 
 class NullOutputStream : public std::ostream {
     public:
@@ -15,44 +27,205 @@ class NullOutputStream : public std::ostream {
 
 static NullOutputStream devNull;
 
+constexpr const char* Console::PROMPT_DEBUG;
+constexpr const char* Console::PROMPT_INFO;
+constexpr const char* Console::PROMPT_ERROR;
+
+static Verbosity parseVerbosity(const std::string& str) {
+    if (str == "ERROR") {
+        return VERB_ERROR;
+    } else if (str == "INFO") {
+        return VERB_INFO;
+    }
+    return VERB_DEBUG;
+}
+
+static FieldType parseField(const std::string& str) {
+    if (str == "R") {
+        return FIELD_REAL;
+    } else if (str == "C") {
+        return FIELD_COMPLEX;
+    } else if (str == "F") {
+        return FIELD_FLOAT;
+    } else if (str == "CF") {
+        return FIELD_COMPLEX_FLOAT;
+    } else if (str == "LD") {
+        return FIELD_LONG_DOUBLE;
+    } else if (str == "CLD") {
+        return FIELD_COMPLEX_LONG_DOUBLE;
+#ifdef HAVE_QUADMATH
+    } else if (str == "Q128") {
+        return FIELD_FLOAT128;
+    } else if (str == "CQ128") {
+        return FIELD_COMPLEX_FLOAT128;
+#endif
+    }
+    return FIELD_INVALID;
+}
+
+static unsigned parseThreads(const std::string& str) {
+    char* end;
+    long threads = std::strtol(str.c_str(), &end, 10);
+    if (str == "auto" || *end != '\0' || threads <= 0) {
+        return ThreadPool::hardwareThreads();
+    }
+    return threads;
+}
+
+static int parsePrecision(const std::string& str) {
+    char* end;
+    long precision = std::strtol(str.c_str(), &end, 10);
+    if (*end != '\0' || precision <= 0) {
+        return ResultWriter::PRECISION_SHORTEST;
+    }
+    return precision;
+}
+
+static std::size_t parseCacheSize(const std::string& str) {
+    char* end;
+    long long size = std::strtoll(str.c_str(), &end, 10);
+    if (*end != '\0' || size <= 0) {
+        return 0;
+    }
+    return size;
+}
+
+Console::Console(std::istream& in, std::ostream& out) :
+        out_(&out), in_(in),
+        threads_(ThreadPool::hardwareThreads()),
+        precision_(ResultWriter::PRECISION_SHORTEST) {
+    watchVariable("verbosity", [this](const std::string& value) { verbosity_ = parseVerbosity(value); });
+    watchVariable("field", [this](const std::string& value) { field_ = parseField(value); });
+    watchVariable("threads", [this](const std::string& value) { threads_ = parseThreads(value); });
+    watchVariable("precision", [this](const std::string& value) { precision_ = parsePrecision(value); });
+    watchVariable("cache_size", [this](const std::string& value) { cacheSize_ = parseCacheSize(value); });
+    watchVariable("stats", [this](const std::string& value) { statsEnabled_ = (value != "off"); });
+    watchVariable("PS1", [this](const std::string& value) { prompt_ = value; });
+}
+
 Console::~Console() {
-    std::vector<IApp*> ptrs;
-    ptrs.reserve(apps_.size());
-    for (const auto& app : apps_) {
-        ptrs.push_back(app.second);
+}
+
+static inline std::uint64_t hashName(std::string_view name, std::uint64_t seed) {
+    std::uint64_t hash = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash ^ (hash >> 29);
+}
+
+int Console::execVirtual(IApp* app, ArgList args) {
+    return app->exec(args);
+}
+
+bool Console::registerApp(const std::string& name, IApp* app, ExecFunction exec) {
+    if (findApp(name) >= 0) {
+        return false;
+    }
+    appTable_.push_back({name, app, exec});
+    stats_.emplace_back();
+    apps_[name] = app;
+    rebuildHashTable();
+    return true;
+}
+
+void Console::rebuildHashTable() {
+    // Подбираем затравку, при которой у всех команд разные ячейки; если за
+    // разумное число попыток это не удаётся, увеличиваем таблицу
+    std::size_t size = 1;
+    while (size < 2 * appTable_.size()) {
+        size *= 2;
+    }
+    while (true) {
+        for (std::uint64_t seed = 0; seed < 256; ++seed) {
+            hashTable_.assign(size, -1);
+            bool collision = false;
+            for (std::size_t i = 0; i < appTable_.size() && !collision; ++i) {
+                int& slot = hashTable_[hashName(appTable_[i].name, seed) & (size - 1)];
+                collision = (slot >= 0);
+                slot = i;
+            }
+            if (!collision) {
+                hashSeed_ = seed;
+                return;
+            }
+        }
+        size *= 2;
+    }
+}
+
+int Console::findApp(std::string_view name) const {
+    if (hashTable_.empty()) {
+        return -1;
     }
+    int index = hashTable_[hashName(name, hashSeed_) & (hashTable_.size() - 1)];
+    return (index >= 0 && appTable_[index].name == name) ? index : -1;
+}
+
+int Console::execApp(int index, ArgList args) {
+    const AppEntry& entry = appTable_[index];
+    return entry.exec(entry.app, args);
+}
 
-    std::sort(ptrs.begin(), ptrs.end());
-    ptrs.erase(std::unique(ptrs.begin(), ptrs.end()), ptrs.end());
+int Console::getAppCount() const {
+    return appTable_.size();
+}
 
-    for (IApp* ptr : ptrs) {
-        delete ptr;
+const std::string& Console::getAppName(int index) const {
+    return appTable_[index].name;
+}
+
+const CommandStats& Console::getCommandStats(int index) const {
+    return stats_[index];
+}
+
+void Console::resetStats() {
+    for (auto& stats : stats_) {
+        stats.reset();
     }
 }
 
+bool Console::isStatsEnabled() const {
+    return statsEnabled_;
+}
+
 std::ostream& Console::output() const {
-    return out_;
+    return *out_;
 }
 
 std::ostream& Console::log(Verbosity verbosity, const char* prompt) const {
-    if (verbosity >= getVerbosity()) {
-        return out_ << prompt;
-    } else {
+    if (!isLogEnabled(verbosity)) {
         return devNull;
     }
+    return (logSink_ != nullptr ? logSink_->stream() : *out_) << prompt;
+}
+
+void Console::setLogSink(LogSink* sink) {
+    if (logSink_ != nullptr) {
+        logSink_->flush();
+    }
+    logSink_ = sink;
+}
+
+// Приглашение относится к вводу, поэтому всегда выводится в поток вывода
+void Console::printPrompt() {
+    if (isLogEnabled(VERB_INFO)) {
+        *out_ << prompt_;
+    }
 }
 
 std::ostream& Console::debug() const {
-    return log(VERB_DEBUG, "# [DEBUG] ");
+    return log(VERB_DEBUG, PROMPT_DEBUG);
 }
 
 std::ostream& Console::info() const {
-    return log(VERB_INFO, "# [INFO ] ");
+    return log(VERB_INFO, PROMPT_INFO);
 }
 
 
 std::ostream& Console::error() const {
-    return log(VERB_ERROR, "# [ERROR] ");
+    return log(VERB_ERROR, PROMPT_ERROR);
 }
 
 std::istream& Console::input() const {
@@ -61,39 +234,80 @@ std::istream& Console::input() const {
 
 
 Verbosity Console::getVerbosity() const {
-    std::string str = getVariable("verbosity", "DEBUG");
-    if (str == "ERROR") {
-        return VERB_ERROR;
-    } else if (str == "INFO") {
-        return VERB_INFO;
-    }
-    return VERB_DEBUG;
+    return verbosity_;
+}
+
+FieldType Console::getField() const {
+    return field_;
+}
+
+const std::string& Console::getPrompt() const {
+    return prompt_;
+}
+
+unsigned Console::getThreads() const {
+    return threads_;
+}
+
+int Console::getPrecision() const {
+    return precision_;
 }
 
-static std::vector<std::string> tokenize(std::string&& input) {
-    std::vector<std::string> result;
-    std::stringstream stream(std::move(input));
-    std::string token;
-    while (stream >> token) {
-        result.push_back(std::move(token));
+std::size_t Console::getCacheSize() const {
+    return cacheSize_;
+}
+
+void Console::setAutoFlush(bool autoFlush) {
+    autoFlush_ = autoFlush;
+}
+
+void Console::setPipelined(bool pipelined) {
+    pipelined_ = pipelined;
+}
+
+ThreadPool& Console::getThreadPool() const {
+    unsigned threads = getThreads();
+    if (!threadPool_ || threadPool_->size() != threads) {
+        threadPool_.reset();
+        threadPool_.reset(new ThreadPool(threads));
     }
+    return *threadPool_;
+}
 
-    return result;
+Arena& Console::getArena() const {
+    return arena_;
 }
 
-static inline bool isComment(const std::string& input) {
-    auto begin = input.begin();
-    auto end = input.end();
-    while (begin != end && std::isspace(*begin)) {
-        ++begin;
+void Console::setInputBuffer(const char* data, std::size_t size) {
+    inputPos_ = data;
+    inputEnd_ = data + size;
+}
+
+bool Console::readLine(std::string_view* line) {
+    if (inputPos_ == nullptr) {
+        if (!std::getline(input(), lineBuffer_)) {
+            return false;
+        }
+        *line = lineBuffer_;
+        return true;
+    }
+
+    if (inputPos_ == inputEnd_) {
+        return false;
+    }
+    const char* lineEnd = static_cast<const char*>(std::memchr(inputPos_, '\n', inputEnd_ - inputPos_));
+    if (lineEnd == nullptr) {
+        lineEnd = inputEnd_;
     }
-    return begin == end || *begin == '#';
+    *line = std::string_view(inputPos_, lineEnd - inputPos_);
+    inputPos_ = (lineEnd == inputEnd_) ? lineEnd : lineEnd + 1;
+    return true;
 }
 
-int Console::exec(int argc, char* argv[]) {
-    info() << "Square equation solver\n";
-    info() << "by Vladimir Ogorodnikov, 2018\n";
-    info() << "Type \"help\" for more information\n";
+void Console::start(int argc, char* argv[]) {
+    LOG_INFO(this) << "Square equation solver\n";
+    LOG_INFO(this) << "by Vladimir Ogorodnikov, 2018\n";
+    LOG_INFO(this) << "Type \"help\" for more information\n";
 
     setVariable("nargs", std::to_string(argc));
 
@@ -102,41 +316,413 @@ int Console::exec(int argc, char* argv[]) {
         name += std::to_string(i + 1);
         setVariable(name, argv[i]);
     }
+}
 
-    std::string input;
-    while (true) {
-        log(VERB_INFO, getVariable("PS1", "> ").c_str());
-        if (!std::getline(this->input(), input)) {
-            break;
+void Console::stop() {
+    LOG_INFO(this) << "Bye!\n";
+    if (logSink_ != nullptr) {
+        logSink_->flush();
+    }
+    output().flush();
+}
+
+void Console::execCommand(int appIndex, ArgList args) {
+    if (appIndex < 0) {
+        LOG_ERROR(this) << "No such app: " << args[0] << '\n';
+        return;
+    }
+    TraceSpan span("command", appTable_[appIndex].name);
+    IApp* app = appTable_[appIndex].app;
+    int statusCode;
+    if (statsEnabled_) {
+        // steady_clock читается через vDSO без системного вызова, это десятки наносекунд
+        auto start = std::chrono::steady_clock::now();
+        statusCode = execApp(appIndex, args);
+        auto finish = std::chrono::steady_clock::now();
+        stats_[appIndex].record(statusCode, std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count());
+    } else {
+        statusCode = execApp(appIndex, args);
+    }
+    arena_.reset();
+    if (statusCode != IApp::STATUS_OK) {
+        LOG_ERROR(this) << "Status code " << statusCode << ": " << app->getStatusCodeDescription(statusCode) << '\n';
+    }
+    if (logSink_ != nullptr) {
+        logSink_->flush();
+    }
+    setVariable("status", std::to_string(statusCode));
+}
+
+bool Console::execLine(std::string_view line) {
+    if (compiler_ == nullptr) {
+        if (isComment(line)) {
+            return true;
+        }
+        if (!startsLoop(line)) {
+            {
+                TraceSpan span("console", "tokenize");
+                tokenize(line, &tokens_);
+            }
+            return execTokens(ArgList(tokens_));
+        }
+    }
+    return compileLine(line);
+}
+
+bool Console::execTokens(ArgList args) {
+    if (args[0] == "exit") {
+        return false;
+    }
+    if (args[0].size() > 1 && args[0][0] == '$') {
+        LOG_ERROR(this) << "Script error: command name cannot be a variable\n";
+        return true;
+    }
+    execCommand(findApp(args[0]), substituteVariables(args));
+    return true;
+}
+
+ArgList Console::substituteVariables(ArgList args) {
+    // Как в сценариях (см. Program): $name заменяется значением переменной,
+    // неизвестная переменная --- пустой строкой
+    std::size_t first = 1;
+    while (first < args.size() && !(args[first].size() > 1 && args[first][0] == '$')) {
+        ++first;
+    }
+    if (first == args.size()) {
+        return args;
+    }
+    static const std::string emptyValue;
+    substituted_.assign(args.begin(), args.end());
+    for (std::size_t i = first; i < args.size(); ++i) {
+        if (args[i].size() > 1 && args[i][0] == '$') {
+            variableName_.assign(args[i].substr(1));
+            auto it = variables_.find(variableName_);
+            substituted_[i] = (it == variables_.end()) ? emptyValue : it->second;
         }
+    }
+    return ArgList(substituted_);
+}
 
-        if (isComment(input)) {
-            continue;
+bool Console::compileLine(std::string_view line) {
+    if (compiler_ == nullptr) {
+        compiler_.reset(new ScriptCompiler);
+    }
+    // Цикл накапливается до парной команды end и выполняется как сценарий
+    if (!compiler_->addLine(line)) {
+        LOG_ERROR(this) << "Script error: " << compiler_->getError() << '\n';
+        compiler_.reset();
+        return true;
+    }
+    if (compiler_->getDepth() > 0) {
+        return true;
+    }
+    Program program;
+    compiler_->finish(&program);
+    compiler_.reset();
+    return run(program);
+}
+
+int Console::exec(int argc, char* argv[]) {
+    start(argc, argv);
+
+    if (pipelined_) {
+        execPipelined();
+    } else {
+        std::string_view input;
+        while (true) {
+            printPrompt();
+            if (!readLine(&input) || !execLine(input)) {
+                break;
+            }
+            if (autoFlush_) {
+                output().flush();
+            }
         }
+    }
+    if (compiler_ != nullptr) {
+        LOG_ERROR(this) << "Script error: unexpected end of input, loop is not closed with 'end'\n";
+        compiler_.reset();
+    }
+    stop();
+    return 0;
+}
+
+namespace {
+    /// Порция строк ввода, прочитанная и разбитая на токены потоком чтения
+    struct InputBatch {
+        /** Строки подряд, без переводов строк */
+        std::string text;
+        /** Конец каждой строки в ```text``` */
+        std::vector<std::size_t> lineEnds;
+        /** Токены всех строк; у пустых строк и комментариев токенов нет */
+        std::vector<std::string_view> tokens;
+        /** Конец токенов каждой строки в ```tokens``` */
+        std::vector<std::size_t> tokenEnds;
+        /** Порция кончается строкой, после которой интерпретатор может завершиться;
+         * поток чтения ждёт ответа в очереди продолжения, прежде чем читать дальше */
+        bool mayExit = false;
+    };
+
+    /// Ответ потока выполнения на порцию, после которой интерпретатор мог завершиться
+    enum PipelineResume {
+        /** Интерпретатор завершился: дальше не читать */
+        RESUME_STOP,
+        /** Читать дальше как обычно */
+        RESUME_READ,
+        /** Компилируется цикл с командой exit: читать по строке и снова ждать ответа */
+        RESUME_STEP
+    };
+
+    // Строк в порции ввода и порций в каждой очереди конвейера
+    constexpr std::size_t PIPELINE_BATCH_LINES = 256;
+    constexpr std::size_t PIPELINE_DEPTH = 16;
+}
 
-        std::vector<std::string> tokens = tokenize(std::move(input));
-        if (tokens.empty()) {
-            continue;
+void Console::execPipelined() {
+    SpscRing<std::unique_ptr<InputBatch>> inputRing(PIPELINE_DEPTH);
+    SpscRing<std::string> outputRing(PIPELINE_DEPTH);
+
+    // Ответы потока выполнения на порции с возможным выходом (см. InputBatch::mayExit)
+    SpscRing<PipelineResume> resumeRing(1);
+
+    // Чтение: порция заканчивается, когда в потоке не осталось прочитанных данных,
+    // чтобы не задерживать команды, которые вводятся по одной. После строки exit
+    // поток чтения не читает дальше, пока не узнает, завершился ли интерпретатор:
+    // иначе он остался бы ждать ввода, которого может и не быть
+    std::thread reader([this, &inputRing, &resumeRing] {
+        std::vector<std::string_view> lineTokens;
+        std::string_view line;
+        bool more = true;
+        bool step = false;
+        while (more) {
+            std::unique_ptr<InputBatch> batch(new InputBatch);
+            {
+                TraceSpan span("pipeline", "read");
+                do {
+                    more = readLine(&line);
+                    if (more) {
+                        batch->text.append(line);
+                        batch->lineEnds.push_back(batch->text.size());
+                        batch->mayExit = step || isExit(line);
+                    }
+                } while (more && !batch->mayExit && batch->lineEnds.size() < PIPELINE_BATCH_LINES &&
+                         (inputPos_ != nullptr || input().rdbuf()->in_avail() > 0));
+            }
+            if (batch->lineEnds.empty()) {
+                break;
+            }
+            {
+                TraceSpan span("pipeline", "tokenize");
+                std::size_t begin = 0;
+                for (std::size_t end : batch->lineEnds) {
+                    std::string_view text(batch->text.data() + begin, end - begin);
+                    if (!isComment(text)) {
+                        tokenize(text, &lineTokens);
+                        batch->tokens.insert(batch->tokens.end(), lineTokens.begin(), lineTokens.end());
+                    }
+                    batch->tokenEnds.push_back(batch->tokens.size());
+                    begin = end;
+                }
+            }
+            bool mayExit = batch->mayExit;
+            if (!inputRing.push(std::move(batch))) {
+                break;
+            }
+            if (mayExit) {
+                PipelineResume resume;
+                if (!resumeRing.pop(&resume) || resume == RESUME_STOP) {
+                    break;
+                }
+                step = (resume == RESUME_STEP);
+            }
         }
-        if (tokens[0] == "exit") {
-            break;
+        inputRing.close();
+    });
+
+    std::ostream* target = out_;
+    std::thread writer([this, target, &outputRing] {
+        std::string chunk;
+        while (outputRing.pop(&chunk)) {
+            TraceSpan span("pipeline", "write");
+            target->write(chunk.data(), chunk.size());
+            if (autoFlush_) {
+                target->flush();
+            }
         }
-        auto appIter = apps_.find(tokens[0]);
-        if (appIter == apps_.end()) {
-            error() << "No such app: " << tokens[0] << '\n';
-        } else {
-            IApp* app = appIter->second;
-            int statusCode = app->exec(tokens);
-            if (statusCode != IApp::STATUS_OK) {
-                error() << "Status code " << statusCode << ": " << app->getStatusCodeDescription(statusCode) << std::endl;
+    });
+
+    // Выполнение: вывод команд порции собирается в памяти и передаётся потоку записи
+    std::ostringstream buffer;
+    out_ = &buffer;
+    std::unique_ptr<InputBatch> batch;
+    bool running = true;
+    // Приглашение к следующей строке выводится сразу после выполнения предыдущей,
+    // вывод такой же, как в последовательном режиме
+    printPrompt();
+    while (running && inputRing.pop(&batch)) {
+        {
+            TraceSpan span("pipeline", "execute");
+            std::size_t lineBegin = 0;
+            std::size_t tokenBegin = 0;
+            for (std::size_t i = 0; i < batch->lineEnds.size() && running; ++i) {
+                std::string_view line(batch->text.data() + lineBegin, batch->lineEnds[i] - lineBegin);
+                ArgList args(batch->tokens.data() + tokenBegin, batch->tokenEnds[i] - tokenBegin);
+                lineBegin = batch->lineEnds[i];
+                tokenBegin = batch->tokenEnds[i];
+
+                if (compiler_ != nullptr || (!args.empty() && (args[0] == "for" || args[0] == "repeat"))) {
+                    running = compileLine(line);
+                } else if (!args.empty()) {
+                    running = execTokens(args);
+                }
+                if (running) {
+                    printPrompt();
+                }
             }
-            setVariable("status", std::to_string(statusCode));
         }
+        outputRing.push(buffer.str());
+        buffer.str("");
+        if (batch->mayExit) {
+            resumeRing.push(!running ? RESUME_STOP : (compiler_ != nullptr) ? RESUME_STEP : RESUME_READ);
+        }
+    }
+    if (buffer.tellp() > 0) {
+        outputRing.push(buffer.str());
     }
-    info() << "Bye!\n";
+    inputRing.close();
+    resumeRing.close();
+    outputRing.close();
+    writer.join();
+    reader.join();
+    out_ = target;
+}
+
+int Console::exec(int argc, char* argv[], const Program& program) {
+    start(argc, argv);
+    run(program);
+    stop();
     return 0;
 }
 
+/** Возвращает целое значение аргумента цикла: разобранное при компиляции
+ * или разобранное из значения переменной */
+static bool loopBound(const Program::Argument& arg, const std::string* value, std::int64_t* result) {
+    if (value == nullptr) {
+        *result = arg.number;
+        return arg.hasNumber != 0;
+    }
+    const char* begin = value->data();
+    const char* end = begin + value->size();
+    std::from_chars_result parsed = std::from_chars(begin, end, *result);
+    return parsed.ec == std::errc() && parsed.ptr == end;
+}
+
+bool Console::run(const Program& program) {
+    struct Frame {
+        std::uint32_t start;
+        std::int64_t current;
+        std::int64_t last;
+        std::int64_t step;
+    };
+
+    // Команды и имена переменных разрешаются один раз на весь запуск программы
+    std::vector<int> appIndices(program.code.size(), -1);
+    for (std::size_t pc = 0; pc < program.code.size(); ++pc) {
+        const Program::Instruction& instruction = program.code[pc];
+        if (instruction.op == Program::OP_CALL) {
+            appIndices[pc] = findApp(program.text(program.args[instruction.firstArg]));
+        }
+    }
+    std::vector<std::string> names(program.args.size());
+    for (std::size_t i = 0; i < program.args.size(); ++i) {
+        if (program.args[i].kind == Program::ARG_VARIABLE) {
+            names[i] = program.text(program.args[i]);
+        }
+    }
+    static const std::string emptyValue;
+    auto valueOf = [this, &names](std::size_t arg) -> const std::string* {
+        auto it = variables_.find(names[arg]);
+        return (it == variables_.end()) ? &emptyValue : &it->second;
+    };
+
+    std::vector<Frame> frames;
+    std::size_t pc = 0;
+    while (pc < program.code.size()) {
+        const Program::Instruction& instruction = program.code[pc];
+        const Program::Argument* args = program.args.data() + instruction.firstArg;
+        switch (instruction.op) {
+            case Program::OP_CALL: {
+                tokens_.clear();
+                for (std::uint32_t i = 0; i < instruction.argCount; ++i) {
+                    tokens_.push_back(args[i].kind == Program::ARG_VARIABLE
+                        ? std::string_view(*valueOf(instruction.firstArg + i))
+                        : program.text(args[i]));
+                }
+                execCommand(appIndices[pc], ArgList(tokens_));
+                if (autoFlush_) {
+                    output().flush();
+                }
+                break;
+            }
+            case Program::OP_FOR:
+            case Program::OP_REPEAT: {
+                Frame frame = {static_cast<std::uint32_t>(pc), 1, 0, 1};
+                bool ok = true;
+                if (instruction.op == Program::OP_FOR) {
+                    std::int64_t bounds[3] = {0, 0, 1};
+                    for (std::uint32_t i = 1; i < instruction.argCount && ok; ++i) {
+                        const std::string* value = (args[i].kind == Program::ARG_VARIABLE)
+                            ? valueOf(instruction.firstArg + i) : nullptr;
+                        ok = loopBound(args[i], value, &bounds[i - 1]);
+                    }
+                    frame.current = bounds[0];
+                    frame.last = bounds[1];
+                    frame.step = bounds[2];
+                } else {
+                    const std::string* value = (args[0].kind == Program::ARG_VARIABLE)
+                        ? valueOf(instruction.firstArg) : nullptr;
+                    ok = loopBound(args[0], value, &frame.last);
+                }
+                if (!ok || frame.step == 0) {
+                    LOG_ERROR(this) << "Bad loop bounds\n";
+                    return true;
+                }
+                if ((frame.step > 0) ? (frame.current > frame.last) : (frame.current < frame.last)) {
+                    pc = instruction.target;
+                    break;
+                }
+                if (instruction.op == Program::OP_FOR) {
+                    setVariable(std::string(program.text(args[0])), std::to_string(frame.current));
+                }
+                frames.push_back(frame);
+                break;
+            }
+            case Program::OP_END: {
+                Frame& frame = frames.back();
+                const Program::Instruction& loop = program.code[frame.start];
+                bool again = (frame.step > 0)
+                    ? (frame.current <= frame.last - frame.step)
+                    : (frame.current >= frame.last - frame.step);
+                if (!again) {
+                    frames.pop_back();
+                    break;
+                }
+                frame.current += frame.step;
+                if (loop.op == Program::OP_FOR) {
+                    const Program::Argument& var = program.args[loop.firstArg];
+                    setVariable(std::string(program.text(var)), std::to_string(frame.current));
+                }
+                pc = frame.start;
+                break;
+            }
+            case Program::OP_EXIT:
+                return false;
+        }
+        ++pc;
+    }
+    return true;
+}
+
 std::string Console::getVariable(const std::string& name, const std::string& defaultValue) const {
     auto it = variables_.find(name);
     if (it == variables_.end()) {
@@ -148,6 +734,16 @@ std::string Console::getVariable(const std::string& name, const std::string& def
 
 void Console::setVariable(const std::string& name, const std::string& value) {
     variables_[name] = value;
+    auto it = observers_.find(name);
+    if (it != observers_.end()) {
+        for (const auto& observer : it->second) {
+            observer(value);
+        }
+    }
+}
+
+void Console::watchVariable(const std::string& name, std::function<void(const std::string&)> observer) {
+    observers_[name].push_back(std::move(observer));
 }
 
 const std::map<std::string, IApp*>& Console::getApps() const {
@@ -159,5 +755,9 @@ const std::map<std::string, std::string>& Console::getAllVariables() const {
 }
 
 void Console::addAlias(const std::string& newName, const std::string& oldName) {
-    apps_[newName] = apps_[oldName];
+    int index = findApp(oldName);
+    if (index >= 0) {
+        AppEntry entry = appTable_[index];
+        registerApp(newName, entry.app, entry.exec);
+    }
 }
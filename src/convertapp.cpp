@@ -0,0 +1,237 @@
+#include <convertapp.h>
+#include <binaryformat.h>
+#include <batchkernel.h>
+#include <mappedfile.h>
+#include <numparse.h>
+#include <resultwriter.h>
+#include <tokenizer.h>
+#include <trace.h>
+#include <complex>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+static bool parseCoefficient(std::string_view token, double* value) {
+    bool ok = true;
+    *value = parseDouble(token, &ok);
+    return ok;
+}
+
+static bool parseCoefficient(std::string_view token, std::complex<double>* value) {
+    bool ok = true;
+    *value = parseComplex(token, &ok);
+    return ok;
+}
+
+static void setCoefficient(BinaryBlock* block, std::size_t index, int column, double value) {
+    block->columns[column][index] = value;
+}
+
+static void setCoefficient(BinaryBlock* block, std::size_t index, int column, const std::complex<double>& value) {
+    block->columns[2 * column][index] = value.real();
+    block->columns[2 * column + 1][index] = value.imag();
+}
+
+// Разбирает коэффициенты текстового файла и пишет их блоками
+template <class Field>
+static int convertCoefficients(const MappedFile& input, BinaryWriter* writer, const Console& console) {
+    const bool complex = !std::is_same<Field, double>::value;
+    const std::size_t blockSize = writer->getBlockSize();
+    const std::size_t columns = BinaryFormat::columnCount(BINARY_EQUATIONS, complex);
+    BinaryBlock block;
+    block.resize(blockSize, columns, false);
+
+    std::vector<std::string_view> tokens;
+    std::uint64_t index = 0;
+    const char* pos = input.data();
+    const char* end = pos + input.size();
+    while (pos != end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        lineEnd = (lineEnd == nullptr) ? end : lineEnd;
+        std::string_view line(pos, lineEnd - pos);
+        pos = (lineEnd == end) ? end : lineEnd + 1;
+        if (isComment(line)) {
+            continue;
+        }
+        tokenize(line, &tokens);
+        for (std::size_t t = (tokens[0] == "solve") ? 1 : 0; t < tokens.size(); ++t) {
+            Field value;
+            if (!parseCoefficient(tokens[t], &value)) {
+                LOG_ERROR(&console) << "Cannot parse coefficient #" << (index + 1) << ": "
+                                << tokens[t] << '\n';
+                return ConvertApp::STATUS_PARSE_ERROR;
+            }
+            std::size_t equation = (index / 3) % blockSize;
+            setCoefficient(&block, equation, index % 3, value);
+            ++index;
+            if (index % (3 * blockSize) == 0 && !writer->writeBlock(block)) {
+                LOG_ERROR(&console) << writer->getError() << '\n';
+                return ConvertApp::STATUS_WRITE_ERROR;
+            }
+        }
+    }
+    if (index % 3 != 0) {
+        LOG_ERROR(&console) << "Number of coefficients is not a multiple of 3\n";
+        return ConvertApp::STATUS_PARSE_ERROR;
+    }
+    block.resize((index / 3) % blockSize, columns, false);
+    if (!writer->writeBlock(block)) {
+        LOG_ERROR(&console) << writer->getError() << '\n';
+        return ConvertApp::STATUS_WRITE_ERROR;
+    }
+    return ConvertApp::STATUS_OK;
+}
+
+int ConvertApp::textToBinary(const std::string& inFileName, const std::string& outFileName) const {
+    FieldType field = parent_->getField();
+    if (field != FIELD_REAL && field != FIELD_COMPLEX) {
+        return STATUS_BAD_FIELD;
+    }
+    // Отображённые страницы читаются последовательно и вытесняются ядром,
+    // поэтому файл может быть больше памяти
+    MappedFile input;
+    if (!input.open(inFileName.c_str())) {
+        return STATUS_FILE_ERROR;
+    }
+    BinaryWriter writer;
+    if (!writer.open(outFileName, BINARY_EQUATIONS, field == FIELD_COMPLEX)) {
+        LOG_ERROR(parent_) << writer.getError() << '\n';
+        return STATUS_FILE_ERROR;
+    }
+    TraceSpan span("convert", "text to binary");
+    int status = (field == FIELD_REAL) ? convertCoefficients<double>(input, &writer, *parent_)
+                                       : convertCoefficients<std::complex<double>>(input, &writer, *parent_);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    if (!writer.close()) {
+        LOG_ERROR(parent_) << writer.getError() << '\n';
+        return STATUS_WRITE_ERROR;
+    }
+    return STATUS_OK;
+}
+
+// Коэффициенты выводятся кратчайшей записью, поэтому читаются обратно без потерь
+static void printEquations(const BinaryBlock& block, bool complex, std::string& text) {
+    ResultWriter out(text);
+    for (std::size_t i = 0; i < block.size; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            if (k != 0) {
+                out << ' ';
+            }
+            if (complex) {
+                out << std::complex<double>(block.columns[2 * k][i], block.columns[2 * k + 1][i]);
+            } else {
+                out << block.columns[k][i];
+            }
+        }
+        out << '\n';
+    }
+}
+
+// Повторяет вывод solvebatch
+static void printResults(const BinaryBlock& block, bool complex, bool verbose, int precision, std::string& text) {
+    ResultWriter out(text, precision);
+    for (std::size_t i = 0; i < block.size; ++i) {
+        int count = block.count[i];
+        if (count == BATCH_DEGENERATE) {
+            if (verbose) {
+                out << Console::PROMPT_INFO << "Equation is degenerate: every value is its solution\n";
+            }
+            continue;
+        }
+        if (verbose) {
+            out << Console::PROMPT_INFO << "Equation has " << count << " solution" << (count == 1 ? "" : "s") << ":\n";
+        }
+        for (int j = 0; j < count; ++j) {
+            if (j != 0) {
+                out << ' ';
+            }
+            if (complex) {
+                out << std::complex<double>(block.columns[2 * j][i], block.columns[2 * j + 1][i]);
+            } else {
+                out << block.columns[j][i];
+            }
+        }
+        out << '\n';
+    }
+}
+
+int ConvertApp::binaryToText(const std::string& inFileName, const std::string& outFileName) const {
+    BinaryReader reader;
+    if (!reader.open(inFileName)) {
+        LOG_ERROR(parent_) << reader.getError() << '\n';
+        return STATUS_FORMAT_ERROR;
+    }
+    std::ofstream out(outFileName, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return STATUS_FILE_ERROR;
+    }
+
+    TraceSpan span("convert", "binary to text");
+    bool verbose = parent_->isLogEnabled(VERB_INFO);
+    BinaryBlock block;
+    std::string text;
+    while (reader.readBlock(&block)) {
+        text.clear();
+        if (reader.getKind() == BINARY_EQUATIONS) {
+            printEquations(block, reader.isComplex(), text);
+        } else {
+            printResults(block, reader.isComplex(), verbose, parent_->getPrecision(), text);
+        }
+        out.write(text.data(), text.size());
+    }
+    if (!reader.getError().empty()) {
+        LOG_ERROR(parent_) << reader.getError() << '\n';
+        return STATUS_FORMAT_ERROR;
+    }
+    out.close();
+    return out ? STATUS_OK : STATUS_WRITE_ERROR;
+}
+
+int ConvertApp::exec(ArgList args) {
+    if (args.size() != 3) {
+        return STATUS_BAD_ARGUMENTS;
+    }
+    std::string inFileName(args[1]);
+    std::string outFileName(args[2]);
+    if (BinaryFormat::isBinaryFile(inFileName)) {
+        return binaryToText(inFileName, outFileName);
+    }
+    return textToBinary(inFileName, outFileName);
+}
+
+const char* ConvertApp::getStatusCodeDescription(int statusCode) {
+    switch (statusCode) {
+        case STATUS_OK:
+            return "OK";
+        case STATUS_BAD_ARGUMENTS:
+            return "Number of arguments should be exactly 2";
+        case STATUS_BAD_FIELD:
+            return "'field' value is invalid (binary files support R and C)";
+        case STATUS_PARSE_ERROR:
+            return "Error while parsing coefficients";
+        case STATUS_FILE_ERROR:
+            return "Cannot open file";
+        case STATUS_FORMAT_ERROR:
+            return "Binary file is damaged";
+        case STATUS_WRITE_ERROR:
+            return "Cannot write output file";
+        default:
+            return "Invalid status code";
+    }
+}
+
+const char* ConvertApp::getHelp() {
+    return  "Usage: convert <input> <output>\n"
+            "Converts between text and binary files:\n"
+            " text     -> binary equations: <input> has coefficients 'a b c' as for\n"
+            "             'solvebatch'; lines of a script 'solve a b c' are accepted too,\n"
+            "             comments are skipped. Field (R or C) is taken from variable \"field\".\n"
+            " binary equations -> text: triples 'a b c', one equation per line\n"
+            " binary results   -> text: the same output as 'solvebatch' (variables\n"
+            "             \"verbosity\" and \"precision\" are used)\n"
+            "Binary files start with a 32-byte header followed by blocks of 65536\n"
+            "equations stored column by column as little-endian doubles. Use 'solvebin'\n"
+            "to solve a binary equations file.";
+}
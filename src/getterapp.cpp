@@ -1,7 +1,7 @@
 #include <getterapp.h>
 #include <iostream>
 
-int GetterApp::exec(const std::vector<std::string>& args) {
+int GetterApp::exec(ArgList args) {
     if (args.size() == 1) {
         return STATUS_BAD_ARGUMENTS;
     }
@@ -10,7 +10,7 @@ int GetterApp::exec(const std::vector<std::string>& args) {
         if (needToPrintName) {
             parent_->output() << *iter << ": ";
         }
-        parent_->output() << parent_->getVariable(*iter, "") << std::endl;
+        parent_->output() << parent_->getVariable(std::string(*iter), "") << '\n';
     }
     return STATUS_OK;
 }
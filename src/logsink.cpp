@@ -0,0 +1,60 @@
+#include <logsink.h>
+
+constexpr std::size_t LogSink::RECORD_SIZE;
+constexpr std::size_t LogSink::CAPACITY;
+
+LogSink::Buffer::Buffer(LogSink* sink) : sink_(sink) {
+    setp(record_.text, record_.text + RECORD_SIZE);
+}
+
+void LogSink::Buffer::push() {
+    record_.size = pptr() - pbase();
+    if (record_.size > 0) {
+        sink_->ring_.push(Record(record_));
+        setp(record_.text, record_.text + RECORD_SIZE);
+    }
+}
+
+int LogSink::Buffer::overflow(int c) {
+    push();
+    if (c != traits_type::eof()) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int LogSink::Buffer::sync() {
+    push();
+    return 0;
+}
+
+LogSink::LogSink(std::ostream& out) :
+        out_(out), ring_(CAPACITY), buffer_(this), stream_(&buffer_) {
+    writer_ = std::thread(&LogSink::writerLoop, this);
+}
+
+LogSink::~LogSink() {
+    buffer_.push();
+    ring_.close();
+    writer_.join();
+}
+
+void LogSink::flush() {
+    buffer_.push();
+}
+
+void LogSink::writerLoop() {
+    Record record;
+    while (true) {
+        // Поток вывода сбрасывается, только когда новых сообщений пока нет
+        if (!ring_.tryPop(&record)) {
+            out_.flush();
+            if (!ring_.pop(&record)) {
+                break;
+            }
+        }
+        out_.write(record.text, record.size);
+    }
+    out_.flush();
+}
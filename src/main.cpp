@@ -3,26 +3,144 @@
 #include <setterapp.h>
 #include <getterapp.h>
 #include <solverapp.h>
+#include <batchsolverapp.h>
+#include <cacheapp.h>
+#include <polysolverapp.h>
+#include <statsapp.h>
+#include <binarysolverapp.h>
+#include <convertapp.h>
+#include <solvestatsapp.h>
+#include <mappedfile.h>
+#include <script.h>
+#include <server.h>
+#include <trace.h>
+#include <logsink.h>
 
+#include <csignal>
 #include <cstring>
+#include <cstdio>
+#include <unistd.h>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string_view>
 
 static const char* HELP_TEXT =
 "Square Equation Solver by Vladimir Ogorodnikov, 2018\n"
-"Usage: %s [-h] [-o filename]  [-q] [-i | filename] [args...]\n"
+"Usage: %s [-h] [-o filename]  [-q] [-m] [-c dir] [-t filename] [-l filename] [-p] [-i | filename] [args...]\n"
+"       %s [-q] [-t filename] --serve address\n"
 "   -o filename -- write output to file 'filename' instead of stdout\n"
 "   -q          -- quiet mode (set 'verbosity' variable to 'ERROR')\n"
+"   -m          -- map input file into memory instead of reading it as a stream\n"
+"                  (ignored for stdin, pipes and other non-regular files)\n"
+"   -c dir      -- compile input file and cache the compiled script in directory 'dir';\n"
+"                  next runs of the same script skip parsing\n"
+"   -t filename -- write a timeline of executed commands to 'filename' in Chrome trace\n"
+"                  event format (open it in chrome://tracing or ui.perfetto.dev)\n"
+"   -l filename -- write messages to file 'filename' ('stderr' for standard error) on a\n"
+"                  background thread instead of mixing them into the output\n"
+"   --serve address -- serve clients on 'unix:<path>' or 'tcp:<port>' (localhost);\n"
+"                  every line sent by a client is executed as a command in its own\n"
+"                  session, output is sent back; stop with SIGINT or SIGTERM\n"
+"   -p          -- pipelined mode: read input and write output on separate threads\n"
+"                  while commands are executed\n"
 "   -i          -- interactive mode (use it to prevent treating first argument as filename)\n"
 "   -h          -- print this help\n"
 "All other arguments are passed as variables 'arg1', 'arg2', ... and so on. Number of arguments is stored in 'nargs'.\n";
 
+/** Устанавливает приложения интерпретатора */
+static void setupConsole(Console& console) {
+    console.installApps<HelpApp, SetterApp, GetterApp, SolverApp, BatchSolverApp, CacheApp, PolySolverApp, StatsApp,
+                        BinarySolverApp, ConvertApp, SolveStatsApp>();
+    console.addAlias("?", "help");
+}
+
+static Server* activeServer = nullptr;
+
+static void stopServer(int) {
+    activeServer->stop();
+}
+
+/** Обслуживает клиентов по адресу ```address```, пока не придёт SIGINT или SIGTERM */
+static int serve(const char* address, bool quiet) {
+    Server server([quiet](Console& console) {
+        if (quiet) {
+            console.setVariable("verbosity", "ERROR");
+        }
+        setupConsole(console);
+    });
+    if (!server.listen(address)) {
+        std::cerr << "Cannot serve " << address << ": " << server.getError() << std::endl;
+        return 1;
+    }
+    activeServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    server.run();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    activeServer = nullptr;
+    if (!server.getError().empty()) {
+        std::cerr << server.getError() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/** Загружает скомпилированный сценарий из кэша или компилирует его и сохраняет в кэш */
+static bool loadScript(Console& console, const char* cacheDir, const MappedFile* mapped, std::istream& in,
+                       Program* program) {
+    std::string text;
+    std::string_view script;
+    if (mapped != nullptr) {
+        script = std::string_view(mapped->data(), mapped->size());
+    } else {
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        text = buffer.str();
+        script = text;
+    }
+
+    std::uint64_t hash = Program::hash(script);
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%016llx.sqbc", static_cast<unsigned long long>(hash));
+    std::string cacheFName = std::string(cacheDir) + name;
+    if (program->load(cacheFName, hash)) {
+        LOG_DEBUG(&console) << "Loaded compiled script " << cacheFName << '\n';
+        return true;
+    }
+
+    ScriptCompiler compiler;
+    while (!script.empty()) {
+        std::size_t lineEnd = script.find('\n');
+        if (!compiler.addLine(script.substr(0, lineEnd))) {
+            std::cerr << "Script error: " << compiler.getError() << std::endl;
+            return false;
+        }
+        script.remove_prefix(lineEnd == std::string_view::npos ? script.size() : lineEnd + 1);
+    }
+    if (!compiler.finish(program)) {
+        std::cerr << "Script error: " << compiler.getError() << std::endl;
+        return false;
+    }
+    if (!program->save(cacheFName, hash)) {
+        LOG_ERROR(&console) << "Cannot write compiled script " << cacheFName << '\n';
+    }
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     int currentArg = 1;
     bool quiet = false;
     bool interactive = false;
+    bool mapInput = false;
+    bool pipelined = false;
     const char* outFName = nullptr;
     const char* inFName = nullptr;
+    const char* cacheDir = nullptr;
+    const char* traceFName = nullptr;
+    const char* logFName = nullptr;
+    const char* serveAddress = nullptr;
 
     while (currentArg < argc) {
         if (std::strcmp(argv[currentArg], "-o") == 0) {
@@ -34,10 +152,42 @@ int main(int argc, char* argv[]) {
             outFName = argv[currentArg];
         } else if (std::strcmp(argv[currentArg], "-q") == 0) {
             quiet = true;
+        } else if (std::strcmp(argv[currentArg], "-m") == 0) {
+            mapInput = true;
+        } else if (std::strcmp(argv[currentArg], "-p") == 0) {
+            pipelined = true;
+        } else if (std::strcmp(argv[currentArg], "-c") == 0) {
+            ++currentArg;
+            if (currentArg >= argc) {
+                std::cerr << "No cache directory specified" << std::endl;
+                return 1;
+            }
+            cacheDir = argv[currentArg];
+        } else if (std::strcmp(argv[currentArg], "-t") == 0) {
+            ++currentArg;
+            if (currentArg >= argc) {
+                std::cerr << "No trace file specified" << std::endl;
+                return 1;
+            }
+            traceFName = argv[currentArg];
+        } else if (std::strcmp(argv[currentArg], "-l") == 0) {
+            ++currentArg;
+            if (currentArg >= argc) {
+                std::cerr << "No log file specified" << std::endl;
+                return 1;
+            }
+            logFName = argv[currentArg];
+        } else if (std::strcmp(argv[currentArg], "--serve") == 0) {
+            ++currentArg;
+            if (currentArg >= argc) {
+                std::cerr << "No address specified" << std::endl;
+                return 1;
+            }
+            serveAddress = argv[currentArg];
         } else if (std::strcmp(argv[currentArg], "-i") == 0) {
             interactive = true;
         } else if (std::strcmp(argv[currentArg], "-h") == 0) {
-            std::printf(HELP_TEXT, argv[0]);
+            std::printf(HELP_TEXT, argv[0], argv[0]);
             return 0;
         } else {
             break;
@@ -45,6 +195,22 @@ int main(int argc, char* argv[]) {
         ++currentArg;
     }
 
+    if (serveAddress != nullptr) {
+        if (logFName != nullptr) {
+            std::cerr << "Option -l is not supported with --serve" << std::endl;
+            return 1;
+        }
+        if (traceFName != nullptr) {
+            Tracer::enable();
+        }
+        int status = serve(serveAddress, quiet);
+        if (traceFName != nullptr && !Tracer::write(traceFName)) {
+            std::cerr << "Cannot write trace file: " << traceFName << std::endl;
+            return 1;
+        }
+        return status;
+    }
+
     if (currentArg < argc && !interactive) {
         inFName = argv[currentArg];
         ++currentArg;
@@ -53,12 +219,19 @@ int main(int argc, char* argv[]) {
     std::istream* in  = &std::cin;
     std::ostream* out = &std::cout;
 
-    if (inFName != nullptr) {
+    MappedFile mappedInput;
+    bool inputMapped = mapInput && inFName != nullptr && mappedInput.open(inFName);
+
+    if (inFName != nullptr && !inputMapped) {
         in = new std::ifstream(inFName);
     }
 
     if (outFName != nullptr) {
-        out = new std::ofstream(outFName);
+        static char outputBuffer[1 << 20];
+        std::ofstream* file = new std::ofstream;
+        file->rdbuf()->pubsetbuf(outputBuffer, sizeof(outputBuffer));
+        file->open(outFName);
+        out = file;
     }
 
     bool ioOK = true;
@@ -80,14 +253,54 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    std::ios::sync_with_stdio(false);
+
     Console console(*in, *out);
+    console.setAutoFlush(out == &std::cout && isatty(STDOUT_FILENO));
+    console.setPipelined(pipelined);
+    if (inputMapped) {
+        console.setInputBuffer(mappedInput.data(), mappedInput.size());
+    }
     if (quiet) {
         console.setVariable("verbosity", "ERROR");
     }
-    console.emplaceApp<HelpApp>("help");
-    console.emplaceApp<SetterApp>("set");
-    console.emplaceApp<GetterApp>("get");
-    console.emplaceApp<SolverApp>("solve");
-    console.addAlias("?", "help");
-    return console.exec(argc - currentArg, argv + currentArg);
+    setupConsole(console);
+
+    // Сообщения пишет фоновый поток; sink закрывается после console.exec, дописав их
+    std::ofstream logFile;
+    std::unique_ptr<LogSink> logSink;
+    if (logFName != nullptr) {
+        if (std::strcmp(logFName, "stderr") != 0) {
+            logFile.open(logFName);
+            if (!logFile) {
+                std::cerr << "Bad file: " << logFName << std::endl;
+                return 1;
+            }
+        }
+        logSink.reset(new LogSink(logFile.is_open() ? static_cast<std::ostream&>(logFile) : std::cerr));
+        console.setLogSink(logSink.get());
+    }
+
+    if (traceFName != nullptr) {
+        Tracer::enable();
+    }
+
+    int status;
+    if (cacheDir != nullptr && inFName != nullptr) {
+        Program program;
+        if (!loadScript(console, cacheDir, inputMapped ? &mappedInput : nullptr, *in, &program)) {
+            return 1;
+        }
+        status = console.exec(argc - currentArg, argv + currentArg, program);
+    } else {
+        status = console.exec(argc - currentArg, argv + currentArg);
+    }
+    console.setLogSink(nullptr);
+    logSink.reset();
+
+    if (traceFName != nullptr && !Tracer::write(traceFName)) {
+        std::cerr << "Cannot write trace file: " << traceFName << std::endl;
+        return 1;
+    }
+    return status;
 }
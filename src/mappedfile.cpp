@@ -0,0 +1,53 @@
+#include <mappedfile.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const char* fileName) {
+    close();
+
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    size_ = info.st_size;
+    if (size_ == 0) {
+        // Пустой файл отобразить нельзя, но читать из него можно
+        ::close(fd);
+        data_ = "";
+        return true;
+    }
+
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        size_ = 0;
+        return false;
+    }
+
+    madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(addr);
+    mapped_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+}
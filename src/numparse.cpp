@@ -0,0 +1,143 @@
+#include <numparse.h>
+#include <charconv>
+#include <cstdlib>
+#include <locale.h>
+#include <string>
+
+/// Копия токена, завершённая нулевым символом, для функций стандартной библиотеки C
+class TerminatedToken {
+    public:
+        explicit TerminatedToken(std::string_view token) {
+            if (token.size() < sizeof(buffer_)) {
+                token.copy(buffer_, token.size());
+                buffer_[token.size()] = '\0';
+                str_ = buffer_;
+            } else {
+                long_.assign(token.begin(), token.end());
+                str_ = long_.c_str();
+            }
+        }
+
+        const char* c_str() const { return str_; }
+
+    private:
+        char buffer_[64];
+        std::string long_;
+        const char* str_;
+};
+
+static locale_t cLocale() {
+    static locale_t locale = newlocale(LC_ALL_MASK, "C", nullptr);
+    return locale;
+}
+
+static void parseC(const char* str, char** end, float* value) {
+    *value = strtof_l(str, end, cLocale());
+}
+
+static void parseC(const char* str, char** end, double* value) {
+    *value = strtod_l(str, end, cLocale());
+}
+
+static void parseC(const char* str, char** end, long double* value) {
+    *value = strtold_l(str, end, cLocale());
+}
+
+#ifdef HAVE_QUADMATH
+static void parseC(const char* str, char** end, Float128* value) {
+    *value = strtoflt128(str, end);
+}
+#endif
+
+// Медленный путь: strtod в локали "C". Нужен для шестнадцатеричной записи
+// и для чисел за пределами диапазона типа, которые std::from_chars отвергает.
+template <class Real>
+static std::size_t parseSlow(std::string_view token, Real* value) {
+    TerminatedToken str(token);
+    char* end;
+    parseC(str.c_str(), &end, value);
+    return end - str.c_str();
+}
+
+static inline bool isHexPrefix(const char* begin, const char* end) {
+    return end - begin >= 2 && begin[0] == '0' && (begin[1] == 'x' || begin[1] == 'X');
+}
+
+// Разбирает число в начале токена так же, как strtod, и возвращает длину
+// разобранной части (0, если число не найдено)
+template <class Real>
+static std::size_t parsePrefix(std::string_view token, Real* value) {
+    const char* begin = token.data();
+    const char* end = begin + token.size();
+    const char* ptr = begin;
+
+    // std::from_chars не принимает '+' перед числом, а strtod принимает
+    if (ptr != end && *ptr == '+') {
+        ++ptr;
+        if (ptr != end && *ptr == '-') {
+            return 0;
+        }
+    }
+    const char* digits = (ptr != end && *ptr == '-') ? ptr + 1 : ptr;
+    if (isHexPrefix(digits, end)) {
+        return parseSlow(token, value);
+    }
+
+    std::from_chars_result result = std::from_chars(ptr, end, *value);
+    if (result.ec == std::errc::invalid_argument) {
+        return 0;
+    }
+    if (result.ec == std::errc::result_out_of_range) {
+        return parseSlow(token, value);
+    }
+    return result.ptr - begin;
+}
+
+#ifdef HAVE_QUADMATH
+// Для __float128 нет std::from_chars
+static std::size_t parsePrefix(std::string_view token, Float128* value) {
+    return parseSlow(token, value);
+}
+#endif
+
+template <class Real>
+Real parseReal(std::string_view token, bool* ok) {
+    Real val = 0;
+    *ok = (parsePrefix(token, &val) != 0);
+    return val;
+}
+
+template <class Real>
+std::complex<Real> parseComplex(std::string_view token, bool* ok) {
+    Real first = 0;
+    std::size_t length = parsePrefix(token, &first);
+    if (length == 0) {
+        *ok = false;
+        return {0, 0};
+    }
+    std::string_view rest = token.substr(length);
+
+    Real second = 0;
+    *ok = true;
+    if (parsePrefix(rest, &second) != 0) {
+        return {first, second};
+    } else if (rest == "j") {
+        return {0, first};
+    } else if (rest.empty()) {
+        return {first, 0};
+    } else {
+        *ok = false;
+        return {0, 0};
+    }
+}
+
+template float parseReal<float>(std::string_view, bool*);
+template double parseReal<double>(std::string_view, bool*);
+template long double parseReal<long double>(std::string_view, bool*);
+template std::complex<float> parseComplex<float>(std::string_view, bool*);
+template std::complex<double> parseComplex<double>(std::string_view, bool*);
+template std::complex<long double> parseComplex<long double>(std::string_view, bool*);
+#ifdef HAVE_QUADMATH
+template Float128 parseReal<Float128>(std::string_view, bool*);
+template std::complex<Float128> parseComplex<Float128>(std::string_view, bool*);
+#endif
@@ -0,0 +1,297 @@
+#include <polysolverapp.h>
+#include <polysolver.h>
+#include <numparse.h>
+#include <solver.h>
+#include <resultwriter.h>
+#include <threadpool.h>
+#include <tokenizer.h>
+#include <trace.h>
+#include <algorithm>
+#include <complex>
+#include <fstream>
+#include <sstream>
+
+template <class Real>
+static bool parseValue(std::string_view input, Real* value) {
+    bool ok = true;
+    *value = parseReal<Real>(input, &ok);
+    return ok;
+}
+
+template <class Real>
+static bool parseValue(std::string_view input, std::complex<Real>* value) {
+    bool ok = true;
+    *value = parseComplex<Real>(input, &ok);
+    return ok;
+}
+
+// Решения над полем вещественных чисел --- только вещественные корни
+template <class Real>
+static std::size_t collectSolutions(const std::complex<Real>* roots, const Real* radii, std::size_t count,
+                                    Real* solutions) {
+    std::size_t collected = 0;
+    for (std::size_t j = 0; j < count; ++j) {
+        if (isRealRoot(roots[j], radii[j])) {
+            solutions[collected++] = roots[j].real();
+        }
+    }
+    return collected;
+}
+
+template <class Real>
+static std::size_t collectSolutions(const std::complex<Real>* roots, const Real*, std::size_t count,
+                                    std::complex<Real>* solutions) {
+    std::copy(roots, roots + count, solutions);
+    return count;
+}
+
+// Сообщение о числе решений уравнения, как у solve; отрицательное число --- вырожденное уравнение
+template <class Stream>
+static void writeSolutionCount(Stream& out, long count) {
+    if (count < 0) {
+        out << "Equation is degenerate: every value is its solution\n";
+    } else {
+        out << "Equation has " << count << " solution" << (count == 1 ? "" : "s") << ":\n";
+    }
+}
+
+static bool readFile(const std::string& fileName, std::string* data) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    *data = buffer.str();
+    return true;
+}
+
+template <class Field>
+int PolySolverApp::parseSolveAndPrint(const ArgList* equations, std::size_t count) const {
+    typedef typename FieldTraits<Field>::Real Real;
+    typedef std::complex<Real> Complex;
+    // Все временные массивы живут до конца команды (см. Console::getArena)
+    Arena& arena = parent_->getArena();
+
+    // Коэффициенты всех уравнений подряд, от старшего к младшему; уравнение i занимает
+    // [first[i], first[i + 1]). Незначащие старшие нули отбрасываются
+    std::pmr::vector<Field> coefficients(&arena);
+    std::pmr::vector<std::size_t> first(count + 1, &arena);
+    {
+        TraceSpan span("solvepoly", "parse");
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            total += equations[i].size();
+        }
+        coefficients.reserve(total);
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t begin = coefficients.size();
+            first[i] = begin;
+            for (const auto& token : equations[i]) {
+                Field value;
+                if (!parseValue(token, &value)) {
+                    LOG_ERROR(parent_) << "Cannot parse coefficient of equation #" << (i + 1) << ": " << token << '\n';
+                    return STATUS_PARSE_ERROR;
+                }
+                coefficients.push_back(value);
+            }
+            std::size_t zeros = 0;
+            while (coefficients.size() - begin - zeros > 3 && isZero(coefficients[begin + zeros])) {
+                ++zeros;
+            }
+            coefficients.erase(coefficients.begin() + begin, coefficients.begin() + begin + zeros);
+        }
+        first[count] = coefficients.size();
+    }
+    auto degreeOf = [&first](std::size_t i) { return static_cast<int>(first[i + 1] - first[i]) - 1; };
+
+    // Уравнения степени выше второй упорядочиваются по степени и решаются пакетами.
+    // Решения уравнения i пишутся с позиции first[i]: их не больше, чем коэффициентов
+    std::pmr::vector<std::size_t> order(&arena);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (degreeOf(i) > 2) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&degreeOf](std::size_t x, std::size_t y) {
+        return degreeOf(x) < degreeOf(y) || (degreeOf(x) == degreeOf(y) && x < y);
+    });
+    std::pmr::vector<Field> solutions(coefficients.size(), &arena);
+    std::pmr::vector<std::size_t> solutionCount(count, &arena);
+    ThreadPool& pool = parent_->getThreadPool();
+    for (std::size_t groupBegin = 0, groupEnd; groupBegin < order.size(); groupBegin = groupEnd) {
+        int degree = degreeOf(order[groupBegin]);
+        groupEnd = groupBegin;
+        while (groupEnd < order.size() && degreeOf(order[groupEnd]) == degree) {
+            ++groupEnd;
+        }
+        const std::size_t* members = &order[groupBegin];
+        std::size_t size = groupEnd - groupBegin;
+        PolynomialBatch<Real> batch(degree, size, &arena);
+        for (std::size_t k = 0; k < size; ++k) {
+            const Field* equation = &coefficients[first[members[k]]];
+            for (int power = 0; power <= degree; ++power) {
+                batch.setCoefficient(k, power, equation[degree - power]);
+            }
+        }
+
+        // Потоки пула не выделяют память: у каждого блока свой участок для корней
+        std::size_t chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        std::pmr::vector<Complex> roots(chunks * degree, &arena);
+        std::pmr::vector<Real> radii(chunks * degree, &arena);
+        auto solveChunk = [&](std::size_t chunk) {
+            std::size_t begin = chunk * CHUNK_SIZE;
+            std::size_t end = std::min(size, begin + CHUNK_SIZE);
+            TraceSpan span("solvepoly", "solve chunk");
+            batch.solve(begin, end);
+            Complex* chunkRoots = &roots[chunk * degree];
+            Real* chunkRadii = &radii[chunk * degree];
+            for (std::size_t k = begin; k < end; ++k) {
+                for (int j = 0; j < degree; ++j) {
+                    chunkRoots[j] = batch.getRoot(k, j);
+                    chunkRadii[j] = batch.getRadius(k, j);
+                }
+                std::size_t merged = mergeRoots(chunkRoots, chunkRadii, degree,
+                                                [&batch, k](Complex* root, Real* radius, int multiplicity) {
+                                                    batch.refineMultiple(k, multiplicity, root, radius);
+                                                });
+                solutionCount[members[k]] = collectSolutions(chunkRoots, chunkRadii, merged,
+                                                             &solutions[first[members[k]]]);
+            }
+        };
+        // Обёртка из одной ссылки помещается в std::function без выделения памяти
+        pool.parallelFor(chunks, [&solveChunk](std::size_t chunk) { solveChunk(chunk); });
+    }
+
+    TraceSpan span("solvepoly", "print");
+    bool verbose = parent_->isLogEnabled(VERB_INFO);
+    // Без приёмника сообщений заголовки идут в результаты, чтобы сохранить порядок
+    bool separateLog = (parent_->getLogSink() != nullptr);
+    ResultWriter out(parent_->output(), parent_->getPrecision());
+    for (std::size_t i = 0; i < count; ++i) {
+        const Field* values = &solutions[first[i]];
+        std::size_t valueCount = solutionCount[i];
+        Roots<Field> roots;
+        if (degreeOf(i) <= 2) {
+            std::array<Field, 3> square = {Field(0), Field(0), Field(0)};
+            std::copy(&coefficients[first[i]], &coefficients[0] + first[i + 1], square.end() - (degreeOf(i) + 1));
+            roots = solveSquare(square);
+            if (roots.isDegenerate()) {
+                if (verbose && separateLog) {
+                    writeSolutionCount(parent_->info(), -1);
+                } else if (verbose) {
+                    out << Console::PROMPT_INFO;
+                    writeSolutionCount(out, -1);
+                }
+                continue;
+            }
+            values = roots.begin();
+            valueCount = roots.size();
+        }
+
+        if (verbose && separateLog) {
+            writeSolutionCount(parent_->info(), static_cast<long>(valueCount));
+        } else if (verbose) {
+            out << Console::PROMPT_INFO;
+            writeSolutionCount(out, static_cast<long>(valueCount));
+        }
+        for (std::size_t j = 0; j < valueCount; ++j) {
+            if (j > 0) {
+                out << ' ';
+            }
+            out << values[j];
+        }
+        out << '\n';
+    }
+    return STATUS_OK;
+}
+
+int PolySolverApp::solveAll(const ArgList* equations, std::size_t count) const {
+    switch (parent_->getField()) {
+        case FIELD_REAL:
+            return parseSolveAndPrint<double>(equations, count);
+        case FIELD_COMPLEX:
+            return parseSolveAndPrint<std::complex<double>>(equations, count);
+        case FIELD_FLOAT:
+            return parseSolveAndPrint<float>(equations, count);
+        case FIELD_COMPLEX_FLOAT:
+            return parseSolveAndPrint<std::complex<float>>(equations, count);
+        case FIELD_LONG_DOUBLE:
+            return parseSolveAndPrint<long double>(equations, count);
+        case FIELD_COMPLEX_LONG_DOUBLE:
+            return parseSolveAndPrint<std::complex<long double>>(equations, count);
+        default:
+            return STATUS_BAD_FIELD;
+    }
+}
+
+int PolySolverApp::exec(ArgList args) {
+    if (args.size() < 2) {
+        return STATUS_BAD_ARGUMENTS;
+    }
+    if (args[1] != "-f") {
+        ArgList equation(args.begin() + 1, args.size() - 1);
+        return solveAll(&equation, 1);
+    }
+    if (args.size() != 3) {
+        return STATUS_BAD_ARGUMENTS;
+    }
+
+    std::string data;
+    if (!readFile(std::string(args[2]), &data)) {
+        return STATUS_FILE_ERROR;
+    }
+    // Одна строка файла --- одно уравнение; пустые строки и комментарии пропускаются
+    std::vector<std::vector<std::string_view>> lines;
+    std::string_view rest(data);
+    while (!rest.empty()) {
+        std::size_t length = std::min(rest.find('\n'), rest.size());
+        std::string_view line = rest.substr(0, length);
+        rest.remove_prefix(std::min(length + 1, rest.size()));
+        if (!isComment(line)) {
+            lines.emplace_back();
+            tokenize(line, &lines.back());
+        }
+    }
+    std::vector<ArgList> equations;
+    for (const auto& line : lines) {
+        if (!line.empty()) {
+            equations.emplace_back(line);
+        }
+    }
+    return solveAll(equations.data(), equations.size());
+}
+
+const char* PolySolverApp::getStatusCodeDescription(int statusCode) {
+    switch (statusCode) {
+        case STATUS_OK:
+            return "OK";
+        case STATUS_BAD_ARGUMENTS:
+            return "Expected at least one coefficient or '-f <file>'";
+        case STATUS_BAD_FIELD:
+            return "'field' value is invalid or not supported by solvepoly";
+        case STATUS_PARSE_ERROR:
+            return "Error while parsing coefficients";
+        case STATUS_FILE_ERROR:
+            return "Cannot open file";
+        default:
+            return "Invalid status code";
+    }
+}
+
+const char* PolySolverApp::getHelp() {
+    return  "Usage: solvepoly a_n ... a_1 a_0\n"
+            "       solvepoly -f <file>\n"
+            "Finds all solutions for equation a_n*x^n + ... + a_1*x + a_0 = 0.\n"
+            "With '-f', every non-empty line of <file> is an equation in the same format;\n"
+            "solutions are printed in the order of equations.\n"
+            "Equations of degree 2 or less are solved exactly as by 'solve'. Cubic and quartic\n"
+            "equations are solved by Cardano's and Ferrari's formulas, higher degrees by\n"
+            "the Aberth-Ehrlich method; the roots are then refined by the same method.\n"
+            "Approximations of a multiple root, whose error bounds computed from the\n"
+            "polynomial overlap, are printed once as one refined root. Roots are printed in\n"
+            "the order of their real and then imaginary parts. Over field R only real roots\n"
+            "are printed; a root is real if its imaginary part is within its error bound.\n"
+            "Fields R, C, F, CF, LD and CLD are supported (see 'help solve'), as well as\n"
+            "variable \"precision\".";
+}
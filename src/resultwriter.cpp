@@ -0,0 +1,126 @@
+#include <resultwriter.h>
+#include <field.h>
+#include <charconv>
+#include <algorithm>
+
+ResultWriter::ResultWriter(std::ostream& out, int precision) : stream_(&out), precision_(precision) {
+}
+
+ResultWriter::ResultWriter(std::string& out, int precision) : string_(&out), precision_(precision) {
+}
+
+ResultWriter::~ResultWriter() {
+    flush();
+}
+
+void ResultWriter::flush() {
+    if (size_ == 0) {
+        return;
+    }
+    if (stream_ != nullptr) {
+        stream_->write(buffer_, size_);
+    } else {
+        string_->append(buffer_, size_);
+    }
+    size_ = 0;
+}
+
+void ResultWriter::reserve(std::size_t size) {
+    if (size_ + size > BUFFER_SIZE) {
+        flush();
+    }
+}
+
+template <class Real>
+ResultWriter& ResultWriter::writeReal(Real x) {
+    reserve(MAX_NUMBER_LENGTH);
+    char* begin = buffer_ + size_;
+    char* end = buffer_ + BUFFER_SIZE;
+    std::to_chars_result result = (precision_ == PRECISION_SHORTEST)
+        ? std::to_chars(begin, end, x)
+        : std::to_chars(begin, end, x, std::chars_format::general, precision_);
+    size_ = result.ptr - buffer_;
+    return *this;
+}
+
+#ifdef HAVE_QUADMATH
+ResultWriter& ResultWriter::operator <<(Float128 x) {
+    // std::to_chars для __float128 нет: кратчайшую запись ищем перебором точности,
+    // пока запись не разбирается обратно в то же число
+    static constexpr int MAX_DIGITS = 36;
+    reserve(MAX_NUMBER_LENGTH);
+    char* begin = buffer_ + size_;
+    int length = 0;
+    if (precision_ != PRECISION_SHORTEST) {
+        length = quadmath_snprintf(begin, MAX_NUMBER_LENGTH, "%.*Qg", precision_, x);
+    } else {
+        for (int digits = 1; digits <= MAX_DIGITS; ++digits) {
+            length = quadmath_snprintf(begin, MAX_NUMBER_LENGTH, "%.*Qg", digits, x);
+            if (strtoflt128(begin, nullptr) == x || x != x) {
+                break;
+            }
+        }
+    }
+    if (length > 0) {
+        size_ += std::min<std::size_t>(length, MAX_NUMBER_LENGTH - 1);
+    }
+    return *this;
+}
+#endif
+
+template <class Real>
+ResultWriter& ResultWriter::operator <<(const std::complex<Real>& x) {
+    if (isZero(x)) {
+        return *this << '0';
+    }
+
+    if (!isZero(x.real())) {
+        *this << x.real();
+    }
+
+    if (!isZero(x.imag())) {
+        if (!isZero(x.real()) && x.imag() > 0) {
+            *this << '+';
+        }
+        *this << x.imag() << 'j';
+    }
+    return *this;
+}
+
+ResultWriter& ResultWriter::operator <<(long x) {
+    reserve(MAX_NUMBER_LENGTH);
+    size_ = std::to_chars(buffer_ + size_, buffer_ + BUFFER_SIZE, x).ptr - buffer_;
+    return *this;
+}
+
+ResultWriter& ResultWriter::operator <<(char c) {
+    reserve(1);
+    buffer_[size_++] = c;
+    return *this;
+}
+
+ResultWriter& ResultWriter::operator <<(std::string_view str) {
+    if (str.size() > BUFFER_SIZE) {
+        flush();
+        if (stream_ != nullptr) {
+            stream_->write(str.data(), str.size());
+        } else {
+            string_->append(str.data(), str.size());
+        }
+        return *this;
+    }
+    reserve(str.size());
+    str.copy(buffer_ + size_, str.size());
+    size_ += str.size();
+    return *this;
+}
+
+template ResultWriter& ResultWriter::operator << <float>(const std::complex<float>&);
+template ResultWriter& ResultWriter::operator << <double>(const std::complex<double>&);
+template ResultWriter& ResultWriter::operator << <long double>(const std::complex<long double>&);
+#ifdef HAVE_QUADMATH
+template ResultWriter& ResultWriter::operator << <Float128>(const std::complex<Float128>&);
+#endif
+template ResultWriter& ResultWriter::writeReal<float>(float);
+template ResultWriter& ResultWriter::writeReal<double>(double);
+template ResultWriter& ResultWriter::writeReal<long double>(long double);
@@ -0,0 +1,236 @@
+#include <script.h>
+#include <tokenizer.h>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+
+static const char CACHE_MAGIC[4] = {'S', 'Q', 'B', 'C'};
+static const std::uint32_t CACHE_VERSION = 1;
+
+std::uint64_t Program::hash(std::string_view script) {
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (char c : script) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+template <class T>
+static void writeVector(std::ostream& out, const std::vector<T>& data) {
+    std::uint64_t size = data.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char*>(data.data()), size * sizeof(T));
+}
+
+template <class T>
+static bool readVector(std::istream& in, std::vector<T>* data) {
+    std::uint64_t size = 0;
+    if (!in.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > (1ULL << 32)) {
+        return false;
+    }
+    data->resize(size);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(data->data()), size * sizeof(T)));
+}
+
+bool Program::save(const std::string& fileName, std::uint64_t scriptHash) const {
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out) {
+        return false;
+    }
+    out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&CACHE_VERSION), sizeof(CACHE_VERSION));
+    out.write(reinterpret_cast<const char*>(&scriptHash), sizeof(scriptHash));
+    writeVector(out, code);
+    writeVector(out, args);
+    writeVector(out, std::vector<char>(pool.begin(), pool.end()));
+    return static_cast<bool>(out);
+}
+
+bool Program::load(const std::string& fileName, std::uint64_t scriptHash) {
+    std::ifstream in(fileName, std::ios::binary);
+    char magic[sizeof(CACHE_MAGIC)];
+    std::uint32_t version;
+    std::uint64_t storedHash;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0
+            || !in.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != CACHE_VERSION
+            || !in.read(reinterpret_cast<char*>(&storedHash), sizeof(storedHash)) || storedHash != scriptHash) {
+        return false;
+    }
+
+    std::vector<char> text;
+    if (!readVector(in, &code) || !readVector(in, &args) || !readVector(in, &text)) {
+        return false;
+    }
+    pool.assign(text.begin(), text.end());
+
+    // Защита от повреждённого файла: все ссылки должны оставаться в пределах программы,
+    // а циклы --- быть правильно вложены
+    std::vector<std::uint32_t> loops;
+    for (std::size_t pc = 0; pc < code.size(); ++pc) {
+        const Instruction& instruction = code[pc];
+        if (instruction.op > OP_EXIT || instruction.target >= code.size()
+                || instruction.firstArg + static_cast<std::uint64_t>(instruction.argCount) > args.size()) {
+            return false;
+        }
+        bool valid = true;
+        switch (instruction.op) {
+            case OP_CALL:
+                valid = instruction.argCount > 0;
+                break;
+            case OP_FOR:
+            case OP_REPEAT:
+                valid = (instruction.op == OP_FOR) ? (instruction.argCount == 3 || instruction.argCount == 4)
+                                                   : (instruction.argCount == 1);
+                loops.push_back(pc);
+                break;
+            case OP_END:
+                valid = !loops.empty() && instruction.target == loops.back() && code[loops.back()].target == pc;
+                if (valid) {
+                    loops.pop_back();
+                }
+                break;
+        }
+        if (!valid) {
+            return false;
+        }
+    }
+    if (!loops.empty()) {
+        return false;
+    }
+    for (const Argument& arg : args) {
+        if (arg.offset + static_cast<std::uint64_t>(arg.length) > pool.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parseInteger(std::string_view token, std::int64_t* value) {
+    const char* begin = token.data();
+    const char* end = begin + token.size();
+    if (begin != end && *begin == '+') {
+        ++begin;
+    }
+    std::from_chars_result result = std::from_chars(begin, end, *value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// Первое слово строки, без разбиения всей строки на токены
+static std::string_view firstWord(std::string_view line) {
+    std::size_t begin = 0;
+    while (begin < line.size() && std::isspace(static_cast<unsigned char>(line[begin]))) {
+        ++begin;
+    }
+    std::size_t end = begin;
+    while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end]))) {
+        ++end;
+    }
+    return line.substr(begin, end - begin);
+}
+
+bool startsLoop(std::string_view line) {
+    std::string_view word = firstWord(line);
+    return word == "for" || word == "repeat";
+}
+
+bool isExit(std::string_view line) {
+    return firstWord(line) == "exit";
+}
+
+bool ScriptCompiler::fail(const std::string& message) {
+    error_ = "line " + std::to_string(lineNumber_) + ": " + message;
+    return false;
+}
+
+std::uint32_t ScriptCompiler::addArgument(std::string_view token) {
+    Program::Argument arg;
+    arg.kind = Program::ARG_LITERAL;
+    if (token.size() > 1 && token[0] == '$') {
+        arg.kind = Program::ARG_VARIABLE;
+        token.remove_prefix(1);
+    }
+    arg.offset = program_.pool.size();
+    arg.length = token.size();
+    arg.number = 0;
+    arg.hasNumber = (arg.kind == Program::ARG_LITERAL) && parseInteger(token, &arg.number);
+    program_.pool.append(token.data(), token.size());
+    program_.args.push_back(arg);
+    return program_.args.size() - 1;
+}
+
+bool ScriptCompiler::addLine(std::string_view line) {
+    ++lineNumber_;
+    if (isComment(line)) {
+        return true;
+    }
+    tokenize(line, &tokens_);
+
+    Program::Instruction instruction;
+    instruction.target = 0;
+    instruction.firstArg = program_.args.size();
+    instruction.argCount = 0;
+
+    std::string_view command = tokens_[0];
+    std::size_t firstArg = 1;
+    if (command == "exit") {
+        instruction.op = Program::OP_EXIT;
+    } else if (command == "end") {
+        if (loops_.empty()) {
+            return fail("'end' without a loop");
+        }
+        instruction.op = Program::OP_END;
+        instruction.target = loops_.back();
+        program_.code[loops_.back()].target = program_.code.size();
+        loops_.pop_back();
+    } else if (command == "for") {
+        if (tokens_.size() != 4 && tokens_.size() != 5) {
+            return fail("usage: for <var> <from> <to> [<step>]");
+        }
+        instruction.op = Program::OP_FOR;
+        loops_.push_back(program_.code.size());
+    } else if (command == "repeat") {
+        if (tokens_.size() != 2) {
+            return fail("usage: repeat <n>");
+        }
+        instruction.op = Program::OP_REPEAT;
+        loops_.push_back(program_.code.size());
+    } else if (command[0] == '$') {
+        return fail("command name cannot be a variable");
+    } else {
+        instruction.op = Program::OP_CALL;
+        firstArg = 0;
+    }
+
+    if (instruction.op != Program::OP_EXIT && instruction.op != Program::OP_END) {
+        for (std::size_t i = firstArg; i < tokens_.size(); ++i) {
+            addArgument(tokens_[i]);
+        }
+        instruction.argCount = tokens_.size() - firstArg;
+    }
+
+    if (instruction.op == Program::OP_FOR || instruction.op == Program::OP_REPEAT) {
+        // Границы циклов должны быть целыми числами или переменными
+        const Program::Argument* args = program_.args.data() + instruction.firstArg;
+        for (std::size_t i = (instruction.op == Program::OP_FOR) ? 1 : 0; i < instruction.argCount; ++i) {
+            if (args[i].kind == Program::ARG_LITERAL && !args[i].hasNumber) {
+                return fail("loop bound is not an integer: " + std::string(program_.text(args[i])));
+            }
+        }
+    }
+
+    program_.code.push_back(instruction);
+    return true;
+}
+
+bool ScriptCompiler::finish(Program* program) {
+    if (!loops_.empty()) {
+        return fail("loop is not closed with 'end'");
+    }
+    *program = std::move(program_);
+    program_ = Program();
+    lineNumber_ = 0;
+    return true;
+}
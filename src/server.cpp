@@ -0,0 +1,434 @@
+#include <server.h>
+#include <threadpool.h>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/// Пул потоков, выполняющий задачи в порядке поступления без ожидания результата
+class Server::WorkerPool {
+    public:
+        explicit WorkerPool(unsigned threads) {
+            for (unsigned i = 0; i < threads; ++i) {
+                threads_.emplace_back([this] { workerLoop(); });
+            }
+        }
+
+        /** Дожидается выполнения всех задач */
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            wakeUp_.notify_all();
+            for (auto& thread : threads_) {
+                thread.join();
+            }
+        }
+
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                tasks_.push_back(std::move(task));
+            }
+            wakeUp_.notify_one();
+        }
+
+    private:
+        void workerLoop() {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wakeUp_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                    if (tasks_.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks_.front());
+                    tasks_.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        std::deque<std::function<void()>> tasks_;
+        std::vector<std::thread> threads_;
+        bool stopping_ = false;
+};
+
+// Идентификаторы событий epoll, не связанных с соединениями
+static constexpr std::uint64_t LISTEN_ID = 0;
+static constexpr std::uint64_t WAKE_ID = 1;
+
+// Разбирает адрес unix:<путь> или tcp:<порт> (только localhost)
+static bool parseAddress(const std::string& address, sockaddr_storage* storage, socklen_t* length,
+                         std::string* error) {
+    std::memset(storage, 0, sizeof(*storage));
+    if (address.compare(0, 5, "unix:") == 0) {
+        std::string path = address.substr(5);
+        sockaddr_un* un = reinterpret_cast<sockaddr_un*>(storage);
+        if (path.empty() || path.size() >= sizeof(un->sun_path)) {
+            *error = "Bad socket path: " + path;
+            return false;
+        }
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+        *length = sizeof(sockaddr_un);
+        return true;
+    }
+    if (address.compare(0, 4, "tcp:") == 0) {
+        char* end;
+        long port = std::strtol(address.c_str() + 4, &end, 10);
+        if (address.size() == 4 || *end != '\0' || port < 0 || port > 65535) {
+            *error = "Bad port: " + address.substr(4);
+            return false;
+        }
+        sockaddr_in* in = reinterpret_cast<sockaddr_in*>(storage);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        *length = sizeof(sockaddr_in);
+        return true;
+    }
+    *error = "Address should be unix:<path> or tcp:<port>: " + address;
+    return false;
+}
+
+static std::string systemError(const char* what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+Server::Server(Setup setup, unsigned workers)
+        : setup_(std::move(setup)),
+          workers_(new WorkerPool(workers == 0 ? ThreadPool::hardwareThreads() : workers)) {
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        error_ = systemError(epollFd_ < 0 ? "epoll_create1" : "eventfd");
+        return;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_ID;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event) != 0) {
+        error_ = systemError("epoll_ctl");
+    }
+}
+
+Server::~Server() {
+    // Рабочие потоки могут обращаться к соединениям, поэтому сначала дожидаемся их
+    workers_.reset();
+    for (const auto& connection : connections_) {
+        close(connection.second->fd);
+    }
+    connections_.clear();
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        if (!unixPath_.empty()) {
+            unlink(unixPath_.c_str());
+        }
+    }
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+}
+
+bool Server::listen(const std::string& address) {
+    // Ошибка конструктора: без epoll сервер работать не может
+    if (!error_.empty()) {
+        return false;
+    }
+    sockaddr_storage storage;
+    socklen_t length;
+    if (!parseAddress(address, &storage, &length, &error_)) {
+        return false;
+    }
+    listenFd_ = socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        error_ = systemError("socket");
+        return false;
+    }
+    if (storage.ss_family == AF_UNIX) {
+        // Оставшийся от прошлого запуска сокет мешает bind; другие файлы не трогаем
+        const char* path = reinterpret_cast<sockaddr_un*>(&storage)->sun_path;
+        struct stat info;
+        if (stat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+            unlink(path);
+        }
+    } else {
+        int yes = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    }
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&storage), length) != 0) {
+        error_ = systemError("bind");
+        return false;
+    }
+    if (storage.ss_family == AF_UNIX) {
+        unixPath_ = reinterpret_cast<sockaddr_un*>(&storage)->sun_path;
+    } else {
+        sockaddr_in bound;
+        socklen_t boundLength = sizeof(bound);
+        getsockname(listenFd_, reinterpret_cast<sockaddr*>(&bound), &boundLength);
+        port_ = ntohs(bound.sin_port);
+    }
+    if (::listen(listenFd_, SOMAXCONN) != 0) {
+        error_ = systemError("listen");
+        return false;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_ID;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event) != 0) {
+        error_ = systemError("epoll_ctl");
+        return false;
+    }
+    return true;
+}
+
+void Server::stop() {
+    stopping_ = true;
+    std::uint64_t one = 1;
+    ssize_t written = ::write(wakeFd_, &one, sizeof(one));
+    (void)written;
+}
+
+void Server::run() {
+    epoll_event events[64];
+    while (!stopping_) {
+        int count = epoll_wait(epollFd_, events, 64, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_ = systemError("epoll_wait");
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            std::uint64_t id = events[i].data.u64;
+            if (id == LISTEN_ID) {
+                accept();
+            } else if (id == WAKE_ID) {
+                std::uint64_t value;
+                ssize_t received = ::read(wakeFd_, &value, sizeof(value));
+                (void)received;
+                complete();
+            } else {
+                auto it = connections_.find(id);
+                if (it == connections_.end()) {
+                    continue;
+                }
+                Connection& connection = *it->second;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    read(id, connection);
+                }
+                if (events[i].events & EPOLLOUT) {
+                    write(connection);
+                }
+                update(id);
+            }
+        }
+    }
+}
+
+void Server::accept() {
+    while (true) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        std::uint64_t id = nextId_++;
+        Connection* connection = new Connection(fd);
+        connections_[id].reset(connection);
+        connection->console.setVariable("threads", "1");
+        setup_(connection->console);
+        update(id);
+    }
+}
+
+void Server::read(std::uint64_t id, Connection& connection) {
+    char buffer[65536];
+    while (true) {
+        ssize_t size = ::read(connection.fd, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (size <= 0) {
+            // Клиент закрыл соединение (или оно разорвано)
+            connection.eof = true;
+            connection.broken = (size < 0);
+            break;
+        }
+        connection.input.append(buffer, size);
+        // Чтение откладывается, пока клиент не заберёт вывод (см. update)
+        if (connection.output.size() >= OUTPUT_LIMIT) {
+            break;
+        }
+    }
+
+    std::size_t begin = 0;
+    std::size_t end;
+    while ((end = connection.input.find('\n', begin)) != std::string::npos) {
+        std::size_t length = end - begin;
+        if (length > 0 && connection.input[end - 1] == '\r') {
+            --length;
+        }
+        connection.pending.emplace_back(connection.input, begin, length);
+        begin = end + 1;
+    }
+    connection.input.erase(0, begin);
+    // Последняя строка может быть без перевода строки
+    if (connection.eof && !connection.input.empty()) {
+        connection.pending.push_back(std::move(connection.input));
+        connection.input.clear();
+    }
+    dispatch(id, connection);
+}
+
+void Server::write(Connection& connection) {
+    while (!connection.output.empty()) {
+        ssize_t size = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                connection.broken = true;
+                connection.output.clear();
+            }
+            return;
+        }
+        connection.output.erase(0, size);
+    }
+}
+
+void Server::dispatch(std::uint64_t id, Connection& connection) {
+    if (connection.busy || connection.pending.empty() || connection.exited || connection.broken) {
+        return;
+    }
+    connection.busy = true;
+    connection.running.swap(connection.pending);
+    Connection* target = &connection;
+    workers_->submit([this, id, target] {
+        bool exited = false;
+        for (const auto& line : target->running) {
+            if (!target->console.execLine(line)) {
+                exited = true;
+                break;
+            }
+        }
+        target->console.output().flush();
+        Completion completion = {id, target->out.str(), exited};
+        target->out.str("");
+        {
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            completions_.push_back(std::move(completion));
+        }
+        std::uint64_t one = 1;
+        ssize_t written = ::write(wakeFd_, &one, sizeof(one));
+        (void)written;
+    });
+}
+
+void Server::complete() {
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        completions.swap(completions_);
+    }
+    for (auto& completion : completions) {
+        Connection& connection = *connections_[completion.id];
+        connection.busy = false;
+        connection.running.clear();
+        connection.output += completion.output;
+        if (completion.exited) {
+            connection.exited = true;
+            connection.pending.clear();
+        }
+        write(connection);
+        dispatch(completion.id, connection);
+        update(completion.id);
+    }
+}
+
+void Server::update(std::uint64_t id) {
+    Connection& connection = *connections_[id];
+    bool finished = connection.eof || connection.exited;
+    if (!connection.busy &&
+        (connection.broken || (finished && connection.pending.empty() && connection.output.empty()))) {
+        if (connection.events != 0) {
+            epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+        }
+        close(connection.fd);
+        connections_.erase(id);
+        return;
+    }
+
+    std::uint32_t events = 0;
+    if (!connection.broken && !finished && connection.output.size() < OUTPUT_LIMIT) {
+        events |= EPOLLIN;
+    }
+    if (!connection.broken && !connection.output.empty()) {
+        events |= EPOLLOUT;
+    }
+    if (events == connection.events) {
+        return;
+    }
+    // Дескриптор зарегистрирован в epoll, только пока ждём каких-то событий: иначе
+    // (например, клиент закрыл запись, а команды ещё выполняются) он удаляется,
+    // чтобы закрытый сокет не будил цикл событием EPOLLHUP
+    epoll_event event = {};
+    event.events = events;
+    event.data.u64 = id;
+    int operation = (events == 0) ? EPOLL_CTL_DEL : (connection.events == 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    if (epoll_ctl(epollFd_, operation, connection.fd, &event) != 0) {
+        error_ = systemError("epoll_ctl");
+        connection.broken = true;
+        connection.output.clear();
+        if (operation != EPOLL_CTL_ADD) {
+            epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+        }
+        connection.events = 0;
+        if (!connection.busy) {
+            update(id);
+        }
+        return;
+    }
+    connection.events = events;
+}
+
+int Server::connect(const std::string& address, std::string* error) {
+    sockaddr_storage storage;
+    socklen_t length;
+    if (!parseAddress(address, &storage, &length, error)) {
+        return -1;
+    }
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        *error = systemError("socket");
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&storage), length) != 0) {
+        *error = systemError("connect");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -1,11 +1,11 @@
 #include <setterapp.h>
 
-int SetterApp::exec(const std::vector<std::string>& args) {
+int SetterApp::exec(ArgList args) {
     if (args.size() != 3) {
         return STATUS_BAD_ARGUMENTS;
     }
 
-    parent_->setVariable(args[1], args[2]);
+    parent_->setVariable(std::string(args[1]), std::string(args[2]));
     return STATUS_OK;
 }
 
@@ -1,182 +1,123 @@
 #include <solverapp.h>
+#include <numparse.h>
+#include <solver.h>
+#include <resultwriter.h>
+#include <trace.h>
 #include <iostream>
 #include <complex>
-#include <limits>
-#include <cstdlib>
-#include <cerrno>
-#include <cstring>
 
 #define OPT_PTR(type, x) static type default_##x##_var; if ( x == nullptr ) x = &default_##x##_var;
 
-template <class Field>
-Field SolverApp::parse(const std::string&, bool*) const {
-    return std::declval<Field>();
-}
-
-static inline double parseDouble(const char* begin, char** end, bool* ok) {
-    double val = std::strtod(begin, end);
-    *ok = (*end != begin);
-    return val;
+template <class Real>
+static void parseValue(std::string_view input, bool* ok, Real* value) {
+    *value = parseReal<Real>(input, ok);
 }
 
-template <>
-double SolverApp::parse<double>(const std::string& input, bool* ok) const {
-    OPT_PTR(bool, ok);
-    char* ptrEnd;
-    return parseDouble(input.c_str(), &ptrEnd, ok);
+template <class Real>
+static void parseValue(std::string_view input, bool* ok, std::complex<Real>* value) {
+    *value = parseComplex<Real>(input, ok);
 }
 
-template <>
-std::complex<double> SolverApp::parse<std::complex<double>>(const std::string& input, bool* ok) const {
+template <class Field>
+Field SolverApp::parse(std::string_view input, bool* ok) const {
     OPT_PTR(bool, ok);
-    std::array<double, 2> vals;
-    const char* strBegin = input.c_str();
-    char* strEnd;
-
-    vals[0] = parseDouble(strBegin, &strEnd, ok);
-    if (!*ok) {
-        return {0, 0};
-    }
-    strBegin = strEnd;
-
-    vals[1] = parseDouble(strBegin, &strEnd, ok);
-    if (*ok) {
-        return {vals[0], vals[1]};
-    } else {
-        *ok = true;
-        if (std::strcmp(strBegin, "j") == 0) {
-            return {0, vals[0]};
-        } else if (strBegin[0] == '\0') {
-            return {vals[0], 0};
-        } else {
-            *ok = false;
-            return {0, 0};
-        }
-    }
-}
-
-static bool isZero(const double& x) {
-    return std::abs(x) < std::numeric_limits<double>::epsilon();
-}
-
-static bool isZero(const std::complex<double>& x) {
-    return isZero(x.real()) && isZero(x.imag());
+    Field value;
+    parseValue(input, ok, &value);
+    return value;
 }
 
 template <class Field>
-static bool isValid(const Field&) {
-    return true;
+SolveCache<Field>* SolverApp::getCache() {
+    // Кэшируются только поля R и C: в ключах остальных типов бывают
+    // незначащие байты (например, у long double), а сравнение побитовое
+    return nullptr;
 }
 
-static bool isValid(double x) {
-    return x == x; // check if x is NaN
-}
-
-template <class Field>
-std::vector<Field> SolverApp::squareRoot(const Field& x) const {
-    std::vector<Field> result;
-    if (isZero(x)) {
-        result.push_back(0);
-    } else {
-        Field sqrt = std::sqrt(x);
-        if (isValid(sqrt)) {
-            result.push_back(sqrt);
-            result.push_back(-sqrt);
-        }
-    }
-    return result;
+template <>
+SolveCache<double>* SolverApp::getCache<double>() {
+    return &realCache_;
 }
 
-template <class Field>
-std::vector<Field> SolverApp::solveLinear(const Field& k, const Field& b, bool* isDegenerateEquation) const {
-    std::vector<Field> result;
-    if (isZero(k)) {
-        *isDegenerateEquation = isZero(b);
-    } else {
-        result.push_back(-b / k);
-    }
-    return result;
+template <>
+SolveCache<std::complex<double>>* SolverApp::getCache<std::complex<double>>() {
+    return &complexCache_;
 }
 
 template <class Field>
-std::vector<Field> SolverApp::solveSquare(const std::array<Field, 3>& coefficients, bool* isDegenerateEquation) const {
-    if (isZero(coefficients[0])) {
-        return solveLinear(coefficients[1], coefficients[2], isDegenerateEquation);
-    }
-    Field discriminant = coefficients[1] * coefficients[1] - 4. * coefficients[0] * coefficients[2];
-    std::vector<Field> result = squareRoot(discriminant);
-    for (unsigned int i = 0; i < result.size(); ++i) {
-        result[i] -= coefficients[1];
-        result[i] /= coefficients[0];
-        result[i] /= 2.;
-    }
-
-    return result;
-}
-
-inline std::ostream& operator <<(std::ostream& out, const std::complex<double>& val) {
-    if (isZero(val)) {
-        return out << '0';
-    }
-
-    if (!isZero(val.real())) {
-        out << val.real();
-    }
-
-    if (!isZero(val.imag())) {
-        if (!isZero(val.real()) && val.imag() > 0) {
-            out << '+';
+int SolverApp::parseSolveAndPrint(ArgList input) {
+    std::array<Field, 3> coefficients;
+    {
+        TraceSpan span("solve", "parse");
+        for (int i = 0; i < 3; ++i) {
+            bool ok = true;
+            coefficients[i] = parse<Field>(input[1 + i], &ok);
+            if (!ok) {
+                return STATUS_PARSE_ERROR;
+            }
         }
-        out << val.imag();
-        out << 'j';
     }
-    return out;
-}
 
-template <class Field>
-int SolverApp::parseSolveAndPrint(const std::vector<std::string>& input) const {
-    std::array<Field, 3> coefficients;
-    for (int i = 0; i < 3; ++i) {
-        bool ok = true;
-        coefficients[i] = parse<Field>(input[1 + i], &ok);
-        if (!ok) {
-            return STATUS_PARSE_ERROR;
+    Roots<Field> solution;
+    {
+        TraceSpan span("solve", "solve");
+        SolveCache<Field>* cache = getCache<Field>();
+        if (cache != nullptr && cache->limit() != parent_->getCacheSize()) {
+            cache->resize(parent_->getCacheSize());
+        }
+        if (cache == nullptr || cache->capacity() == 0) {
+            solution = solveSquare(coefficients);
+        } else if (const Roots<Field>* cached = cache->find(coefficients)) {
+            solution = *cached;
+        } else {
+            solution = solveSquare(coefficients);
+            cache->insert(coefficients, solution);
         }
     }
 
-    bool isDegenerateEquation = false;
-    auto solution = solveSquare(coefficients, &isDegenerateEquation);
-
-    if (isDegenerateEquation) {
-        parent_->info() << "Equation is degenerate: every value is its solution\n";
+    TraceSpan span("solve", "print");
+    if (solution.isDegenerate()) {
+        LOG_INFO(parent_) << "Equation is degenerate: every value is its solution\n";
     } else {
-        parent_->info() << "Equation has " << solution.size() << " solution" << (solution.size() == 1 ? "" : "s") << ":\n";
-        bool first = true;
-        for (auto iter = solution.begin(); iter != solution.end(); ++iter) {
-            if (!first) {
-                parent_->output() << ' ';
+        LOG_INFO(parent_) << "Equation has " << solution.size() << " solution" << (solution.size() == 1 ? "" : "s") << ":\n";
+        ResultWriter writer(parent_->output(), parent_->getPrecision());
+        for (std::size_t i = 0; i < solution.size(); ++i) {
+            if (i > 0) {
+                writer << ' ';
             }
-            first = false;
-            parent_->output() << *iter;
+            writer << solution[i];
         }
-        parent_->output() << std::endl;
+        writer << '\n';
     }
     return STATUS_OK;
 }
 
-int SolverApp::exec(const std::vector<std::string>& args) {
+int SolverApp::exec(ArgList args) {
     if (args.size() != 4) {
         return STATUS_BAD_ARGUMENTS;
     }
 
-    std::string fieldCode = parent_->getVariable("field", "R");
-    if (fieldCode == "R") {
-        return parseSolveAndPrint<double>(args);
-    } else if (fieldCode == "C") {
-        return parseSolveAndPrint<std::complex<double>>(args);
+    switch (parent_->getField()) {
+        case FIELD_REAL:
+            return parseSolveAndPrint<double>(args);
+        case FIELD_COMPLEX:
+            return parseSolveAndPrint<std::complex<double>>(args);
+        case FIELD_FLOAT:
+            return parseSolveAndPrint<float>(args);
+        case FIELD_COMPLEX_FLOAT:
+            return parseSolveAndPrint<std::complex<float>>(args);
+        case FIELD_LONG_DOUBLE:
+            return parseSolveAndPrint<long double>(args);
+        case FIELD_COMPLEX_LONG_DOUBLE:
+            return parseSolveAndPrint<std::complex<long double>>(args);
+#ifdef HAVE_QUADMATH
+        case FIELD_FLOAT128:
+            return parseSolveAndPrint<Float128>(args);
+        case FIELD_COMPLEX_FLOAT128:
+            return parseSolveAndPrint<std::complex<Float128>>(args);
+#endif
+        default:
+            return STATUS_BAD_FIELD;
     }
-
-    return STATUS_BAD_FIELD;
 }
 
 const char* SolverApp::getStatusCodeDescription(int statusCode) {
@@ -200,7 +141,18 @@ const char* SolverApp::getHelp() {
             "You can select a field where the coefficients are from.\n"
             "To do it, you should set variable \"field\" to one of the \n"
             "following values (type 'set field <one-of-these-values>'):\n"
-            " R - Real numbers ('double' in C++)\n"
-            " C - Complex numbers ('std::complex<double>' in C++; it's just a pair of doubles)\n"
-            "If variable \"field\" is not set, real numbers are used by default.";
+            " R     - Real numbers ('double' in C++)\n"
+            " C     - Complex numbers ('std::complex<double>' in C++; it's just a pair of doubles)\n"
+            " F, CF - Real and complex numbers of single precision ('float')\n"
+            " LD, CLD - Real and complex numbers of extended precision ('long double')\n"
+#ifdef HAVE_QUADMATH
+            " Q128, CQ128 - Real and complex numbers of quadruple precision ('__float128')\n"
+#endif
+            "If variable \"field\" is not set, real numbers are used by default.\n"
+            "Roots are printed in the shortest form that reads back to the same number.\n"
+            "To print a fixed number of significant digits instead, set variable\n"
+            "\"precision\" to that number (e.g. 'set precision 6').\n"
+            "To remember solutions of repeated equations, set variable \"cache_size\"\n"
+            "to the maximal number of remembered equations (see 'help cache');\n"
+            "only fields R and C are cached.";
 }
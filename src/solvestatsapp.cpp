@@ -0,0 +1,256 @@
+#include <solvestatsapp.h>
+#include <batchkernel.h>
+#include <binaryformat.h>
+#include <mappedfile.h>
+#include <numparse.h>
+#include <resultwriter.h>
+#include <threadpool.h>
+#include <tokenizer.h>
+#include <trace.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+    /// Итоги части уравнений
+    struct Summary {
+        BatchRootHistogram histogram;
+        /** Число найденных корней и их минимум, максимум и сумма */
+        std::uint64_t roots = 0;
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        double sum = 0;
+
+        void addRoot(double x) {
+            ++roots;
+            min = std::min(min, x);
+            max = std::max(max, x);
+            sum += x;
+        }
+
+        void merge(const Summary& other) {
+            histogram.degenerate += other.histogram.degenerate;
+            for (int n = 0; n < 3; ++n) {
+                histogram.roots[n] += other.histogram.roots[n];
+            }
+            roots += other.roots;
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+            sum += other.sum;
+        }
+    };
+
+    /// Накопление итогов по блокам уравнений
+    class Aggregator {
+        public:
+            Aggregator(ThreadPool& pool, BatchKernel kernel, bool withRoots) :
+                    pool_(pool), kernel_(kernel), withRoots_(withRoots) {}
+
+            /** Добавляет уравнения блока (столбцы a, b, c) */
+            void add(const BinaryBlock& block) {
+                TraceSpan span("solvestats", "block");
+                const double* a = block.columns[0].data();
+                const double* b = block.columns[1].data();
+                const double* c = block.columns[2].data();
+                std::size_t size = block.size;
+                if (withRoots_) {
+                    x1_.resize(size);
+                    x2_.resize(size);
+                    count_.resize(size);
+                }
+                // Несколько частей на поток, чтобы перехват работы сглаживал неравномерность
+                std::size_t chunkSize = std::max<std::size_t>(4096, size / (pool_.size() * 4));
+                std::size_t chunks = (size + chunkSize - 1) / chunkSize;
+                partial_.assign(chunks, Summary());
+                pool_.parallelFor(chunks, [&](std::size_t k) {
+                    std::size_t begin = k * chunkSize;
+                    std::size_t end = std::min(size, begin + chunkSize);
+                    Summary& summary = partial_[k];
+                    if (!withRoots_) {
+                        countRealRoots(a, b, c, begin, end, &summary.histogram, kernel_);
+                        return;
+                    }
+                    solveRealBatch(a, b, c, x1_.data(), x2_.data(), count_.data(), begin, end, kernel_);
+                    for (std::size_t i = begin; i < end; ++i) {
+                        if (count_[i] == BATCH_DEGENERATE) {
+                            ++summary.histogram.degenerate;
+                            continue;
+                        }
+                        ++summary.histogram.roots[count_[i]];
+                        if (count_[i] >= 1) {
+                            summary.addRoot(x1_[i]);
+                        }
+                        if (count_[i] == 2) {
+                            summary.addRoot(x2_[i]);
+                        }
+                    }
+                });
+                // Итоги складываются в порядке частей, поэтому сумма корней не зависит от числа потоков
+                for (const auto& summary : partial_) {
+                    total_.merge(summary);
+                }
+            }
+
+            const Summary& getTotal() const { return total_; }
+
+        private:
+            ThreadPool& pool_;
+            BatchKernel kernel_;
+            bool withRoots_;
+            Summary total_;
+            std::vector<Summary> partial_;
+            std::vector<double> x1_, x2_;
+            std::vector<signed char> count_;
+    };
+}
+
+// Разбирает текстовый файл коэффициентов (как для convert) и передаёт его блоками
+static int aggregateText(const MappedFile& input, Aggregator* aggregator, const Console& console) {
+    const std::size_t blockSize = BinaryFormat::DEFAULT_BLOCK_SIZE;
+    BinaryBlock block;
+    block.resize(blockSize, 3, false);
+
+    std::vector<std::string_view> tokens;
+    std::uint64_t index = 0;
+    const char* pos = input.data();
+    const char* end = pos + input.size();
+    while (pos != end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        lineEnd = (lineEnd == nullptr) ? end : lineEnd;
+        std::string_view line(pos, lineEnd - pos);
+        pos = (lineEnd == end) ? end : lineEnd + 1;
+        if (isComment(line)) {
+            continue;
+        }
+        tokenize(line, &tokens);
+        for (std::size_t t = (tokens[0] == "solve") ? 1 : 0; t < tokens.size(); ++t) {
+            bool ok = true;
+            double value = parseDouble(tokens[t], &ok);
+            if (!ok) {
+                LOG_ERROR(&console) << "Cannot parse coefficient #" << (index + 1) << ": " << tokens[t] << '\n';
+                return SolveStatsApp::STATUS_PARSE_ERROR;
+            }
+            block.columns[index % 3][(index / 3) % blockSize] = value;
+            ++index;
+            if (index % (3 * blockSize) == 0) {
+                aggregator->add(block);
+            }
+        }
+    }
+    if (index % 3 != 0) {
+        LOG_ERROR(&console) << "Number of coefficients is not a multiple of 3\n";
+        return SolveStatsApp::STATUS_PARSE_ERROR;
+    }
+    block.resize((index / 3) % blockSize, 3, false);
+    aggregator->add(block);
+    return SolveStatsApp::STATUS_OK;
+}
+
+static int aggregateBinary(const std::string& fileName, Aggregator* aggregator, const Console& console) {
+    BinaryReader reader;
+    if (!reader.open(fileName)) {
+        LOG_ERROR(&console) << reader.getError() << '\n';
+        return SolveStatsApp::STATUS_FORMAT_ERROR;
+    }
+    if (reader.getKind() != BINARY_EQUATIONS) {
+        LOG_ERROR(&console) << "File " << fileName << " contains results, not equations\n";
+        return SolveStatsApp::STATUS_FORMAT_ERROR;
+    }
+    if (reader.isComplex()) {
+        return SolveStatsApp::STATUS_BAD_FIELD;
+    }
+    BinaryBlock block;
+    while (reader.readBlock(&block)) {
+        aggregator->add(block);
+    }
+    if (!reader.getError().empty()) {
+        LOG_ERROR(&console) << reader.getError() << '\n';
+        return SolveStatsApp::STATUS_FORMAT_ERROR;
+    }
+    return SolveStatsApp::STATUS_OK;
+}
+
+int SolveStatsApp::exec(ArgList args) {
+    bool withRoots = (args.size() == 3 && args[1] == "-r");
+    if (args.size() != (withRoots ? 3 : 2)) {
+        return STATUS_BAD_ARGUMENTS;
+    }
+    BatchKernel kernel;
+    if (!parseBatchKernel(parent_->getVariable("kernel", "auto"), &kernel)) {
+        return STATUS_BAD_KERNEL;
+    }
+
+    std::string fileName(args[args.size() - 1]);
+    Aggregator aggregator(parent_->getThreadPool(), kernel, withRoots);
+    int status;
+    if (BinaryFormat::isBinaryFile(fileName)) {
+        status = aggregateBinary(fileName, &aggregator, *parent_);
+    } else {
+        if (parent_->getField() != FIELD_REAL) {
+            return STATUS_BAD_FIELD;
+        }
+        MappedFile input;
+        if (!input.open(fileName.c_str())) {
+            return STATUS_FILE_ERROR;
+        }
+        status = aggregateText(input, &aggregator, *parent_);
+    }
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    TraceSpan span("solvestats", "print");
+    const Summary& total = aggregator.getTotal();
+    const BatchRootHistogram& histogram = total.histogram;
+    ResultWriter out(parent_->output(), parent_->getPrecision());
+    out << "roots       equations\n";
+    out << "degenerate  " << static_cast<long>(histogram.degenerate) << '\n';
+    for (int n = 0; n < 3; ++n) {
+        out << n << "           " << static_cast<long>(histogram.roots[n]) << '\n';
+    }
+    out << "total       " << static_cast<long>(histogram.degenerate + histogram.roots[0] +
+                                              histogram.roots[1] + histogram.roots[2]) << '\n';
+    if (withRoots) {
+        if (total.roots == 0) {
+            out << "min         -\nmax         -\nmean        -\n";
+        } else {
+            out << "min         " << total.min << '\n';
+            out << "max         " << total.max << '\n';
+            out << "mean        " << total.sum / total.roots << '\n';
+        }
+    }
+    return STATUS_OK;
+}
+
+const char* SolveStatsApp::getStatusCodeDescription(int statusCode) {
+    switch (statusCode) {
+        case STATUS_OK:
+            return "OK";
+        case STATUS_BAD_ARGUMENTS:
+            return "Usage: solvestats [-r] <file>";
+        case STATUS_BAD_FIELD:
+            return "Statistics are computed only over field R";
+        case STATUS_PARSE_ERROR:
+            return "Error while parsing coefficients";
+        case STATUS_FILE_ERROR:
+            return "Cannot open file";
+        case STATUS_FORMAT_ERROR:
+            return "Input is not a valid binary equations file";
+        case STATUS_BAD_KERNEL:
+            return "'kernel' value is invalid";
+        default:
+            return "Invalid status code";
+    }
+}
+
+const char* SolveStatsApp::getHelp() {
+    return  "Usage: solvestats [-r] <file>\n"
+            "Prints how many equations of <file> are degenerate and how many have 0, 1\n"
+            "or 2 real roots, without printing the roots. With -r also prints minimum,\n"
+            "maximum and mean of all roots. <file> is a binary equations file (see\n"
+            "'help convert') or a text file of coefficients as for 'convert'.\n"
+            "Works over field R only. Root counts are the same as 'solvebatch' finds;\n"
+            "without -r roots are not computed at all. Variables \"kernel\" and\n"
+            "\"threads\" are used as by 'solvebatch'.";
+}
@@ -0,0 +1,111 @@
+#include <statsapp.h>
+#include <iomanip>
+#include <iostream>
+
+static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+static const char* const QUANTILE_NAMES[] = {"p50", "p90", "p99", "p999"};
+
+void StatsApp::printTable(std::ostream& out) const {
+    out << std::left << std::setw(16) << "command" << std::right
+        << std::setw(10) << "calls" << std::setw(8) << "errors" << std::setw(12) << "mean, ns";
+    for (const char* name : QUANTILE_NAMES) {
+        out << std::setw(12) << name;
+    }
+    out << std::setw(12) << "max" << '\n';
+
+    for (int i = 0; i < parent_->getAppCount(); ++i) {
+        const CommandStats& stats = parent_->getCommandStats(i);
+        if (stats.calls == 0) {
+            continue;
+        }
+        std::uint64_t errors = 0;
+        for (const auto& error : stats.errors) {
+            errors += error.second;
+        }
+        out << std::left << std::setw(16) << parent_->getAppName(i) << std::right
+            << std::setw(10) << stats.calls << std::setw(8) << errors
+            << std::setw(12) << static_cast<std::uint64_t>(stats.latency.mean());
+        for (double quantile : QUANTILES) {
+            out << std::setw(12) << stats.latency.percentile(quantile);
+        }
+        out << std::setw(12) << stats.latency.max() << '\n';
+        for (const auto& error : stats.errors) {
+            out << "  status " << error.first << ": " << error.second << '\n';
+        }
+    }
+    if (!parent_->isStatsEnabled()) {
+        out << "(collection is off: variable \"stats\" is \"off\")\n";
+    }
+}
+
+void StatsApp::printJson(std::ostream& out) const {
+    out << "{\"enabled\": " << (parent_->isStatsEnabled() ? "true" : "false") << ", \"commands\": [";
+    bool first = true;
+    for (int i = 0; i < parent_->getAppCount(); ++i) {
+        const CommandStats& stats = parent_->getCommandStats(i);
+        if (stats.calls == 0) {
+            continue;
+        }
+        out << (first ? "" : ",") << "\n  {\"name\": \"" << parent_->getAppName(i) << "\", \"calls\": " << stats.calls
+            << ", \"errors\": {";
+        bool firstError = true;
+        for (const auto& error : stats.errors) {
+            out << (firstError ? "" : ", ") << '"' << error.first << "\": " << error.second;
+            firstError = false;
+        }
+        const LatencyHistogram& latency = stats.latency;
+        out << "}, \"latency_ns\": {\"min\": " << latency.min() << ", \"mean\": " << latency.mean();
+        for (std::size_t q = 0; q < sizeof(QUANTILES) / sizeof(QUANTILES[0]); ++q) {
+            out << ", \"" << QUANTILE_NAMES[q] << "\": " << latency.percentile(QUANTILES[q]);
+        }
+        out << ", \"max\": " << latency.max() << ", \"sum\": " << latency.sum() << ", \"buckets\": [";
+        // Непустые корзины: [нижняя граница, верхняя граница, число значений]
+        bool firstBucket = true;
+        for (std::size_t b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+            if (latency.bucketCount(b) == 0) {
+                continue;
+            }
+            out << (firstBucket ? "" : ", ") << '[' << LatencyHistogram::lowerBound(b) << ", "
+                << LatencyHistogram::upperBound(b) << ", " << latency.bucketCount(b) << ']';
+            firstBucket = false;
+        }
+        out << "]}}";
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+int StatsApp::exec(ArgList args) {
+    if (args.size() == 1) {
+        printTable(parent_->output());
+    } else if (args.size() == 2 && args[1] == "json") {
+        printJson(parent_->output());
+    } else if (args.size() == 2 && args[1] == "reset") {
+        parent_->resetStats();
+    } else {
+        return STATUS_BAD_ARGUMENTS;
+    }
+    return STATUS_OK;
+}
+
+const char* StatsApp::getStatusCodeDescription(int statusCode) {
+    switch (statusCode) {
+        case STATUS_OK:
+            return "OK";
+        case STATUS_BAD_ARGUMENTS:
+            return "Usage: stats [json | reset]";
+        default:
+            return "Invalid status code";
+    }
+}
+
+const char* StatsApp::getHelp() {
+    return  "Usage: stats [json | reset]\n"
+            "Every command run from the input or from a script is counted and timed.\n"
+            "Without arguments, prints for each command the number of calls and errors\n"
+            "and the execution time in nanoseconds: mean, percentiles and maximum\n"
+            "(percentiles are accurate to 1/16), followed by error counts per status code.\n"
+            " json  - print the same data and the whole latency histograms as JSON\n"
+            " reset - set all counters to zero\n"
+            "To stop collecting, set variable \"stats\" to \"off\".";
+}
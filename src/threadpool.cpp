@@ -0,0 +1,119 @@
+#include <threadpool.h>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = hardwareThreads();
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.emplace_back(new Queue);
+    }
+    for (unsigned i = 1; i < threads; ++i) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+unsigned ThreadPool::size() const {
+    return queues_.size();
+}
+
+unsigned ThreadPool::hardwareThreads() {
+    unsigned threads = std::thread::hardware_concurrency();
+    return (threads == 0) ? 1 : threads;
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    if (threads_.empty() || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < count; ++i) {
+            Queue& queue = *queues_[i % queues_.size()];
+            std::lock_guard<std::mutex> queueLock(queue.mutex);
+            queue.tasks.push_back(i);
+        }
+        task_ = &task;
+        pending_ = count;
+        busyWorkers_ = threads_.size();
+        ++generation_;
+    }
+    wakeUp_.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_ == 0 && busyWorkers_ == 0; });
+    task_ = nullptr;
+}
+
+bool ThreadPool::takeTask(unsigned worker, std::size_t* task) {
+    {
+        Queue& own = *queues_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            *task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (unsigned shift = 1; shift < queues_.size(); ++shift) {
+        Queue& victim = *queues_[(worker + shift) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            *task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTasks(unsigned worker) {
+    std::size_t task;
+    while (takeTask(worker, &task)) {
+        (*task_)(task);
+        if (--pending_ == 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    unsigned long seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeUp_.wait(lock, [&]() { return stopping_ || generation_ != seenGeneration; });
+            if (stopping_) {
+                return;
+            }
+            seenGeneration = generation_;
+        }
+
+        runTasks(worker);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busyWorkers_ == 0) {
+            done_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#include <tokenizer.h>
+#include <cctype>
+
+static inline bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c));
+}
+
+void tokenize(std::string_view input, std::vector<std::string_view>* tokens) {
+    tokens->clear();
+    const char* begin = input.data();
+    const char* end = begin + input.size();
+    while (true) {
+        while (begin != end && isSpace(*begin)) {
+            ++begin;
+        }
+        if (begin == end) {
+            return;
+        }
+        const char* tokenEnd = begin;
+        while (tokenEnd != end && !isSpace(*tokenEnd)) {
+            ++tokenEnd;
+        }
+        tokens->emplace_back(begin, tokenEnd - begin);
+        begin = tokenEnd;
+    }
+}
+
+bool isComment(std::string_view input) {
+    auto begin = input.begin();
+    auto end = input.end();
+    while (begin != end && isSpace(*begin)) {
+        ++begin;
+    }
+    return begin == end || *begin == '#';
+}
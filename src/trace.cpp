@@ -0,0 +1,122 @@
+#include <trace.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+bool Tracer::enabled_ = false;
+
+namespace {
+    struct Event {
+        const char* category;
+        char name[Tracer::MAX_NAME_LENGTH + 1];
+        std::uint64_t start;
+        std::uint64_t duration;
+    };
+
+    /// Буфер событий одного потока; пишет в него только сам поток
+    struct ThreadBuffer {
+        static constexpr std::size_t CHUNK_SIZE = 4096;
+
+        unsigned id;
+        std::vector<std::unique_ptr<Event[]>> chunks;
+        std::size_t used = CHUNK_SIZE;
+
+        Event& append() {
+            if (used == CHUNK_SIZE) {
+                chunks.emplace_back(new Event[CHUNK_SIZE]);
+                used = 0;
+            }
+            return chunks.back()[used++];
+        }
+    };
+
+    std::chrono::steady_clock::time_point origin;
+
+    // Буферы живут до конца программы, даже если их потоки уже завершились
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+    thread_local ThreadBuffer* localBuffer = nullptr;
+
+    ThreadBuffer* threadBuffer() {
+        if (localBuffer == nullptr) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry.emplace_back(new ThreadBuffer);
+            registry.back()->id = registry.size();
+            localBuffer = registry.back().get();
+        }
+        return localBuffer;
+    }
+
+    void writeString(std::ostream& out, const char* str) {
+        out << '"';
+        for (; *str != '\0'; ++str) {
+            if (*str == '"' || *str == '\\') {
+                out << '\\';
+            }
+            if (static_cast<unsigned char>(*str) >= 0x20) {
+                out << *str;
+            }
+        }
+        out << '"';
+    }
+}
+
+void Tracer::enable() {
+    origin = std::chrono::steady_clock::now();
+    // Поток, включивший трассировку, получает первую дорожку
+    threadBuffer();
+    enabled_ = true;
+}
+
+void Tracer::disable() {
+    enabled_ = false;
+}
+
+std::uint64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Tracer::record(const char* category, std::string_view name, std::uint64_t start, std::uint64_t finish) {
+    Event& event = threadBuffer()->append();
+    event.category = category;
+    std::size_t length = std::min(name.size(), MAX_NAME_LENGTH);
+    std::memcpy(event.name, name.data(), length);
+    event.name[length] = '\0';
+    event.start = start;
+    event.duration = finish - start;
+}
+
+bool Tracer::write(const char* fileName) {
+    std::ofstream out(fileName);
+    if (!out) {
+        return false;
+    }
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"solver\"}}";
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& buffer : registry) {
+        out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->id
+            << ", \"args\": {\"name\": \"" << (buffer->id == 1 ? "main" : "worker") << ' ' << buffer->id << "\"}}";
+        for (std::size_t c = 0; c < buffer->chunks.size(); ++c) {
+            std::size_t count = (c + 1 == buffer->chunks.size()) ? buffer->used : ThreadBuffer::CHUNK_SIZE;
+            for (std::size_t i = 0; i < count; ++i) {
+                const Event& event = buffer->chunks[c][i];
+                // Время в формате Trace Event --- в микросекундах
+                out << ",\n{\"name\": ";
+                writeString(out, event.name);
+                out << ", \"cat\": \"" << event.category << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->id
+                    << ", \"ts\": " << event.start / 1000.0 << ", \"dur\": " << event.duration / 1000.0 << '}';
+            }
+        }
+    }
+    out << "\n]}\n";
+    return bool(out);
+}
@@ -1,8 +1,78 @@
 #include <testing.h>
 #include <iostream>
 #include <solverapp.h>
+#include <batchsolverapp.h>
+#include <setterapp.h>
+#include <getterapp.h>
+#include <statsapp.h>
+#include <cacheapp.h>
+#include <solvecache.h>
+#include <polysolverapp.h>
+#include <polysolver.h>
+#include <binarysolverapp.h>
+#include <convertapp.h>
+#include <solvestatsapp.h>
+#include <binaryformat.h>
+#include <solver.h>
+#include <batchkernel.h>
+#include <numparse.h>
+#include <resultwriter.h>
+#include <script.h>
+#include <trace.h>
+#include <server.h>
+#include <spscring.h>
+#include <logsink.h>
+#include <mappedfile.h>
 #include <sstream>
+#include <fstream>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
 #include <set>
+#include <map>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <type_traits>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static std::atomic<std::size_t> allocationCount(0);
+
+// noinline у operator new и обоих operator delete: иначе в сборке с оптимизацией GCC
+// встраивает их (например, в new набора тестов из TEST_SET), видит malloc() и free()
+// вместо пары new/delete и ошибочно предупреждает о несоответствии (-Wmismatched-new-delete)
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    ++allocationCount;
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+// Имя временного файла, своё у каждого вызова: тесты выполняются параллельно,
+// в том числе в нескольких процессах (см. Tester::runAll)
+static std::string tempFileName(const char* name) {
+    static std::atomic<unsigned> counter(0);
+    std::string fileName(name);
+    return fileName.insert(fileName.rfind('.'), '_' + std::to_string(getpid()) + '_' + std::to_string(counter++));
+}
 
 TEST_SET(SimpleTestSet) {
     TEST(HelloWorld) {
@@ -30,8 +100,1545 @@ TEST_SET(SolverAppSet) {
     };
 }
 
-int main() {
-    test_autogen::SimpleTestSet().runTests();
-    test_autogen::SolverAppSet().runTests();
-    return 0;
+namespace {
+    class LegacyEchoApp : public LegacyApp {
+        public:
+            LegacyEchoApp(Console* parent) : parent_(parent) {}
+            using LegacyApp::exec;
+            int exec(const std::vector<std::string>& args) {
+                for (const auto& arg : args) {
+                    parent_->output() << '[' << arg << ']';
+                }
+                parent_->output() << '\n';
+                return STATUS_OK;
+            }
+            const char* getStatusCodeDescription(int) { return "OK"; }
+            const char* getHelp() { return ""; }
+        private:
+            Console* parent_;
+    };
+
+    // Приложение без exec нельзя создать: перегрузка с ArgList чисто виртуальная
+    class NoExecApp : public IApp {
+        public:
+            const char* getStatusCodeDescription(int) { return "OK"; }
+            const char* getHelp() { return ""; }
+    };
+    static_assert(std::is_abstract<NoExecApp>::value, "IApp::exec(ArgList) must be pure virtual");
+}
+
+TEST_SET(ConsoleSet) {
+    TEST(LegacyAppAdapter) {
+        std::stringstream input("echo a  bb\t ccc\n  # comment\n\necho\n");
+        std::stringstream output;
+        Console console(input, output);
+        console.setVariable("verbosity", "ERROR");
+        console.emplaceApp<LegacyEchoApp>("echo");
+        console.exec(0, nullptr);
+        return output.str() == "[echo][a][bb][ccc]\n[echo]\n";
+    };
+
+    TEST(AppRegistry) {
+        std::stringstream input("solve 1 0 -1\n? solve\necho x\nalias y\n");
+        std::stringstream output;
+        Console console(input, output);
+        console.setVariable("verbosity", "ERROR");
+        bool ok = console.installApps<SetterApp, SolverApp>();
+        ok = !console.installApps<SolverApp>() && ok;
+        ok = console.emplaceApp<LegacyEchoApp>("echo") && ok;
+        ok = !console.emplaceApp<LegacyEchoApp>("set") && ok;
+        console.addAlias("alias", "echo");
+        for (int i = 0; i < 100; ++i) {
+            ok = console.emplaceApp<LegacyEchoApp>("echo" + std::to_string(i)) && ok;
+        }
+        for (int i = 0; i < 100; ++i) {
+            ok = console.findApp("echo" + std::to_string(i)) >= 0 && ok;
+        }
+        console.exec(0, nullptr);
+        return ok && console.findApp("?") < 0 && console.getApps().size() == 104
+               && output.str() == "1 -1\n# [ERROR] No such app: ?\n[echo][x]\n[alias][y]\n";
+    };
+
+    TEST(CachedVariables) {
+        std::stringstream output;
+        Console console(std::cin, output);
+        std::string watched;
+        console.watchVariable("x", [&](const std::string& value) { watched = value; });
+        console.setVariable("x", "42");
+        console.setVariable("field", "C");
+        console.setVariable("verbosity", "INFO");
+        console.setVariable("threads", "3");
+        bool ok = watched == "42" && console.getField() == FIELD_COMPLEX
+                  && console.getVerbosity() == VERB_INFO && console.getThreads() == 3;
+        console.setVariable("field", "Z");
+        return ok && console.getField() == FIELD_INVALID && console.getAllVariables().size() == 4;
+    };
+
+    TEST(MappedInputBuffer) {
+        const char script[] = "set x 1\nsolve 1 0 -4";
+        std::stringstream output;
+        Console console(std::cin, output);
+        console.setVariable("verbosity", "ERROR");
+        console.emplaceApp<SetterApp>("set");
+        console.emplaceApp<SolverApp>("solve");
+        console.setInputBuffer(script, sizeof(script) - 1);
+        console.exec(0, nullptr);
+        return output.str() == "2 -2\n" && console.getVariable("x") == "1";
+    };
+
+    TEST(MappedFileSameAsStream) {
+        // Строки с CRLF, пустая строка и комментарий, последняя строка без перевода строки
+        const std::string script = "set x 1\r\n# comment\r\n\r\nget x\r\nsolve 1 0 -4\r\nsolve 1 2 1";
+        std::string fileName = tempFileName("mapped_test.txt");
+        std::ofstream(fileName, std::ios::binary) << script;
+        std::string outputs[2];
+        bool ok = true;
+        for (int mapped = 0; mapped < 2; ++mapped) {
+            MappedFile file;
+            std::ifstream stream(fileName, std::ios::binary);
+            std::stringstream output;
+            Console console(stream, output);
+            console.setVariable("verbosity", "ERROR");
+            console.installApps<SetterApp, GetterApp, SolverApp>();
+            if (mapped != 0) {
+                ok = file.open(fileName.c_str()) && file.size() == script.size() &&
+                     std::string(file.data(), file.size()) == script && ok;
+                console.setInputBuffer(file.data(), file.size());
+            }
+            console.exec(0, nullptr);
+            outputs[mapped] = output.str();
+        }
+        std::remove(fileName.c_str());
+
+        // Пустой файл открывается; канал (как stdin) и несуществующий файл --- нет,
+        // и тогда solver -m читает ввод через поток
+        std::string emptyName = tempFileName("mapped_empty.txt");
+        std::ofstream(emptyName).close();
+        MappedFile empty;
+        ok = empty.open(emptyName.c_str()) && empty.size() == 0 && ok;
+        std::remove(emptyName.c_str());
+        int fds[2];
+        if (pipe(fds) != 0) {
+            return false;
+        }
+        MappedFile pipeFile;
+        ok = !pipeFile.open(("/proc/self/fd/" + std::to_string(fds[0])).c_str()) && pipeFile.data() == nullptr && ok;
+        close(fds[0]);
+        close(fds[1]);
+        MappedFile missing;
+        ok = !missing.open(fileName.c_str()) && ok;
+
+        if (outputs[0] != outputs[1] || outputs[1] != "1\n2 -2\n-1\n") {
+            std::cerr << "Stream: " << outputs[0] << "Mapped: " << outputs[1];
+            ok = false;
+        }
+        return ok;
+    };
+
+    TEST(LatencyHistogramPercentiles) {
+        LatencyHistogram histogram;
+        for (std::uint64_t value = 1; value <= 100000; ++value) {
+            histogram.record(value);
+        }
+        // Квантили --- верхние границы корзин, погрешность не больше 1/16
+        bool ok = histogram.count() == 100000 && histogram.min() == 1 && histogram.max() == 100000;
+        for (double quantile : {0.5, 0.9, 0.99}) {
+            double value = double(histogram.percentile(quantile));
+            ok = ok && value >= quantile * 100000 && value <= quantile * 100000 * (1 + 1.0 / 16);
+        }
+        for (std::uint64_t value : {0ULL, 15ULL, 16ULL, 1000ULL, 123456789ULL, 1ULL << 50}) {
+            std::size_t bucket = LatencyHistogram::bucketOf(value);
+            ok = ok && bucket < LatencyHistogram::BUCKETS && LatencyHistogram::lowerBound(bucket) <= value &&
+                 (bucket == LatencyHistogram::BUCKETS - 1 || value <= LatencyHistogram::upperBound(bucket));
+        }
+        histogram.reset();
+        return ok && histogram.count() == 0 && histogram.percentile(0.5) == 0;
+    };
+
+    TEST_SERIAL(TraceEvents) {
+        std::stringstream input("solve 1 0 -1\nsolve 1 2 1\n");
+        std::stringstream output;
+        Console console(input, output);
+        console.setVariable("verbosity", "ERROR");
+        console.installApps<SolverApp>();
+        Tracer::enable();
+        console.exec(0, nullptr);
+        Tracer::disable();
+        std::string fileName = tempFileName("trace_test.json");
+        bool ok = Tracer::write(fileName.c_str());
+        std::ifstream file(fileName);
+        std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::remove(fileName.c_str());
+
+        auto count = [&trace](const std::string& event) {
+            std::size_t n = 0;
+            for (std::size_t pos = trace.find(event); pos != std::string::npos; pos = trace.find(event, pos + 1)) {
+                ++n;
+            }
+            return n;
+        };
+        return ok && count("{\"name\": \"solve\", \"cat\": \"command\", \"ph\": \"X\"") == 2 &&
+               count("\"name\": \"tokenize\"") == 2 && count("\"name\": \"parse\", \"cat\": \"solve\"") == 2 &&
+               count("\"name\": \"print\", \"cat\": \"solve\"") == 2 && count("\"thread_name\"") >= 1;
+    };
+
+    TEST(RingKeepsOrder) {
+        SpscRing<std::size_t> ring(8);
+        const std::size_t count = 100000;
+        std::thread producer([&ring] {
+            for (std::size_t i = 0; i < count; ++i) {
+                ring.push(std::size_t(i));
+            }
+            ring.close();
+        });
+        std::size_t expected = 0;
+        std::size_t value;
+        bool ok = true;
+        while (ring.pop(&value)) {
+            ok = ok && value == expected++;
+        }
+        producer.join();
+        return ok && expected == count;
+    };
+
+    TEST(PipelinedSameAsSequential) {
+        std::string script = "# comment\nsolve 1 0 -1\n\nset precision 3\nrepeat 2\nsolve 1 0 -2\nend\n"
+                             "solve 1 x 1\nnosuchapp\nfor i 1 3\nsolve 1 0 -$i\n";
+        for (int i = 0; i < 1000; ++i) {
+            script += "solve 1 " + std::to_string(i) + " -1\n";
+        }
+        script += "end\nexit\nsolve 1 0 -4\n";
+        std::string outputs[2];
+        for (int pipelined = 0; pipelined < 2; ++pipelined) {
+            std::stringstream input(script);
+            std::stringstream output;
+            Console console(input, output);
+            console.installApps<SetterApp, SolverApp>();
+            console.setPipelined(pipelined != 0);
+            console.exec(0, nullptr);
+            outputs[pipelined] = output.str();
+        }
+        return outputs[0] == outputs[1] && outputs[0].find("Equation has 2 solutions") != std::string::npos;
+    };
+
+    TEST(PipelinedExitDoesNotWaitForInput) {
+        // Ввод, который после данных не кончается, пока его не отпустят (как открытый канал)
+        class HeldInput : public std::streambuf {
+            public:
+                explicit HeldInput(const std::string& data) : data_(data) {}
+                void release() {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    released_ = true;
+                    wakeUp_.notify_all();
+                }
+            protected:
+                virtual int underflow() {
+                    if (!given_) {
+                        given_ = true;
+                        setg(&data_[0], &data_[0], &data_[0] + data_.size());
+                        return traits_type::to_int_type(data_[0]);
+                    }
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wakeUp_.wait(lock, [this] { return released_; });
+                    return traits_type::eof();
+                }
+            private:
+                std::string data_;
+                bool given_ = false;
+                bool released_ = false;
+                std::mutex mutex_;
+                std::condition_variable wakeUp_;
+        };
+
+        // exit на верхнем уровне; exit в цикле, который выполняется; exit в цикле, который не выполняется
+        const char* scripts[] = {"solve 1 2 1\nexit\n",
+                                 "solve 1 2 1\nrepeat 2\nsolve 1 0 -1\nexit\nend\n",
+                                 "repeat 0\nexit\nend\nsolve 1 2 1\nexit\n"};
+        const char* expected[] = {"-1\n", "-1\n1 -1\n", "-1\n"};
+        bool ok = true;
+        for (int k = 0; k < 3; ++k) {
+            HeldInput held(scripts[k]);
+            std::istream input(&held);
+            std::stringstream output;
+            Console console(input, output);
+            console.setVariable("verbosity", "ERROR");
+            console.installApps<SolverApp>();
+            console.setPipelined(true);
+            std::mutex mutex;
+            std::condition_variable done;
+            bool finished = false;
+            std::thread run([&] {
+                console.exec(0, nullptr);
+                std::lock_guard<std::mutex> lock(mutex);
+                finished = true;
+                done.notify_all();
+            });
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait_for(lock, std::chrono::seconds(5), [&finished] { return finished; });
+                ok = ok && finished;
+            }
+            held.release();
+            run.join();
+            if (output.str() != expected[k]) {
+                std::cerr << "Script " << k << ": " << output.str();
+                ok = false;
+            }
+        }
+        return ok;
+    };
+
+    TEST_SERIAL(NoAllocationsPerCommand) {
+        // После прогрева построчные команды не обращаются к куче: временные массивы
+        // берутся из распределителя команды, который между командами только сбрасывается
+        const char* lines[] = {"solve 1 -3 2", "solve 1 x 2", "set precision 5", "get precision",
+                               "solvepoly 1 0 0 -1", "solvepoly 1 2 3 4 5", "nosuch 1"};
+        std::ostream devNull(nullptr);
+        Console console(std::cin, devNull);
+        console.setVariable("verbosity", "ERROR");
+        console.setVariable("threads", "1");
+        console.installApps<SetterApp, GetterApp, SolverApp, PolySolverApp>();
+        for (int i = 0; i < 10; ++i) {
+            for (const char* line : lines) {
+                console.execLine(line);
+            }
+        }
+        std::size_t capacity = console.getArena().getCapacity();
+        std::size_t before = allocationCount;
+        for (int i = 0; i < 100; ++i) {
+            for (const char* line : lines) {
+                console.execLine(line);
+            }
+        }
+        std::size_t allocations = allocationCount - before;
+        if (allocations != 0) {
+            std::cerr << allocations << " allocations" << std::endl;
+        }
+        return allocations == 0 && console.getArena().getUsed() == 0
+               && console.getArena().getCapacity() == capacity;
+    };
+
+    TEST_SERIAL(MappedInputNoAllocationsPerLine) {
+        // Строки отображённого ввода не копируются: число выделений памяти за весь
+        // запуск не зависит от числа строк
+        std::size_t allocations[2];
+        for (int k = 0; k < 2; ++k) {
+            std::string script;
+            for (int i = 0; i < (k + 1) * 500; ++i) {
+                script += "solve 1 -3 2\r\n# comment\nset precision 5\n";
+            }
+            std::ostream devNull(nullptr);
+            Console console(std::cin, devNull);
+            console.setVariable("verbosity", "ERROR");
+            console.installApps<SetterApp, SolverApp>();
+            console.setInputBuffer(script.data(), script.size());
+            std::size_t before = allocationCount;
+            console.exec(0, nullptr);
+            allocations[k] = allocationCount - before;
+        }
+        if (allocations[0] != allocations[1]) {
+            std::cerr << allocations[0] << " and " << allocations[1] << " allocations" << std::endl;
+        }
+        return allocations[0] == allocations[1];
+    };
+
+    TEST(ArenaCoalescesBlocks) {
+        Arena arena(64);
+        void* first = arena.allocate(48, 16);
+        void* second = arena.allocate(100, 8);
+        bool ok = first != second && reinterpret_cast<std::uintptr_t>(first) % 16 == 0
+                  && arena.getBlockAllocations() == 2 && arena.getUsed() >= 148;
+        std::size_t capacity = arena.getCapacity();
+        arena.reset();
+        ok = ok && arena.getUsed() == 0 && arena.getCapacity() == capacity && arena.getBlockAllocations() == 3;
+        first = arena.allocate(48, 16);
+        second = arena.allocate(100, 8);
+        return ok && first != second && arena.getBlockAllocations() == 3;
+    };
+
+    TEST(LogMacrosSkipDisabledLevels) {
+        std::stringstream output;
+        Console console(std::cin, output);
+        int evaluated = 0;
+        auto argument = [&evaluated]() { return ++evaluated; };
+        console.setVariable("verbosity", "ERROR");
+        LOG_DEBUG(&console) << argument();
+        LOG_INFO(&console) << argument();
+        LOG_ERROR(&console) << argument() << '\n';
+        return evaluated == 1 && output.str() == std::string(Console::PROMPT_ERROR) + "1\n";
+    };
+
+    TEST(LogSinkSeparatesMessages) {
+        std::stringstream input("solve 1 0 -1\nsolve 1 x 1\nnosuch\nsolve 1 2 1\n");
+        std::stringstream output;
+        std::stringstream messages;
+        {
+            LogSink sink(messages);
+            Console console(input, output);
+            console.setVariable("PS1", "");
+            console.setLogSink(&sink);
+            console.installApps<SolverApp>();
+            console.exec(0, nullptr);
+        }
+        // Результаты и сообщения не перемешиваются, порядок внутри каждого потока сохранён
+        const std::string& log = messages.str();
+        std::size_t parse = log.find("Status code 3");
+        std::size_t noApp = log.find("No such app: nosuch");
+        return output.str() == "1 -1\n-1\n" && log.find(std::string(Console::PROMPT_INFO) + "Square equation solver") == 0 &&
+               parse != std::string::npos && noApp > parse && log.find("Bye!", noApp) != std::string::npos &&
+               log.find("Equation has 2 solutions") < parse;
+    };
+
+    TEST(LogSinkTakesBatchHeaders) {
+        // Заголовки solvebatch и solvepoly, как и у solve, уходят в приёмник сообщений,
+        // а без него остаются в выводе перед решениями
+        std::string fileName = tempFileName("log_sink_batch.txt");
+        std::ofstream(fileName) << "1 0 -1\n0 0 0\n1 0 1\n";
+        std::string script = "solvebatch " + fileName + "\nsolvepoly 1 0 0 -1\nsolvepoly 0 0 0\n";
+        std::string results = "1 -1\n\n1\n";
+        std::string headers = std::string(Console::PROMPT_INFO) + "Equation has 2 solutions:\n" +
+                              Console::PROMPT_INFO + "Equation is degenerate: every value is its solution\n" +
+                              Console::PROMPT_INFO + "Equation has 0 solutions:\n" +
+                              Console::PROMPT_INFO + "Equation has 1 solution:\n" +
+                              Console::PROMPT_INFO + "Equation is degenerate: every value is its solution\n";
+        std::stringstream output, messages;
+        {
+            std::stringstream input(script);
+            LogSink sink(messages);
+            Console console(input, output);
+            console.setVariable("PS1", "");
+            console.setLogSink(&sink);
+            console.installApps<BatchSolverApp, PolySolverApp>();
+            console.exec(0, nullptr);
+        }
+        bool ok = output.str() == results && messages.str().find(headers) != std::string::npos;
+
+        std::stringstream input(script);
+        std::stringstream mixed;
+        Console console(input, mixed);
+        console.setVariable("PS1", "");
+        console.installApps<BatchSolverApp, PolySolverApp>();
+        console.exec(0, nullptr);
+        std::remove(fileName.c_str());
+        return ok && mixed.str().find(std::string(Console::PROMPT_INFO) + "Equation has 2 solutions:\n1 -1\n" +
+                                      Console::PROMPT_INFO + "Equation is degenerate") != std::string::npos;
+    };
+
+    TEST(CommandStatistics) {
+        std::stringstream input("solve 1 0 -1\nsolve 1 x 1\nrepeat 3\nsolve 1 2 1\nend\n"
+                                "set stats off\nsolve 1 0 -1\nset stats on\nstats json\n");
+        std::stringstream output;
+        Console console(input, output);
+        console.setVariable("verbosity", "ERROR");
+        console.installApps<SetterApp, SolverApp, StatsApp>();
+        console.exec(0, nullptr);
+
+        const CommandStats& solve = console.getCommandStats(console.findApp("solve"));
+        bool ok = solve.calls == 5 && solve.latency.count() == 5 && solve.errors.size() == 1 &&
+                  solve.errors.at(SolverApp::STATUS_PARSE_ERROR) == 1 &&
+                  output.str().find("{\"name\": \"solve\", \"calls\": 5, \"errors\": {\"3\": 1}") != std::string::npos;
+        console.resetStats();
+        return ok && solve.calls == 0 && solve.errors.empty();
+    };
+}
+
+TEST_SET(NumParseSet) {
+    TEST(SameAsStrtod) {
+        std::vector<std::string> tokens = {
+            "0", "-0", "+1", "1e", "1e+", "1e-5x", ".5", "5.", ".", "-", "+", "+-1", "-+1", "0x1p4",
+            "-0x10", "inf", "-Infinity", "nan", "1e400", "-1e400", "1e-400", "4.9e-324", "2.2250738585072011e-308",
+            "1,5", "abc", "9007199254740993", "0.1000000000000000055511151231257827", "123456789012345678901234567890"
+        };
+        std::mt19937_64 gen(2018);
+        std::uniform_int_distribution<uint64_t> bits;
+        char buffer[64];
+        for (int i = 0; i < 100000; ++i) {
+            uint64_t x = bits(gen);
+            double value;
+            std::memcpy(&value, &x, sizeof(value));
+            std::snprintf(buffer, sizeof(buffer), (i % 2) ? "%.17g" : "%.6e", value);
+            tokens.push_back(buffer);
+        }
+
+        for (const auto& token : tokens) {
+            char* end;
+            double expected = std::strtod(token.c_str(), &end);
+            bool ok = false;
+            double actual = parseDouble(token, &ok);
+            bool same = (expected == actual && std::signbit(expected) == std::signbit(actual))
+                        || (expected != expected && actual != actual);
+            if (ok != (end != token.c_str()) || (ok && !same)) {
+                std::cerr << "Mismatch for " << token << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+
+    TEST(Complex) {
+        bool ok = true;
+        bool result = parseComplex("1+2j", &ok) == std::complex<double>(1, 2) && ok;
+        result = result && parseComplex("-2.5j", &ok) == std::complex<double>(0, -2.5) && ok;
+        result = result && parseComplex("3", &ok) == std::complex<double>(3, 0) && ok;
+        parseComplex("3k", &ok);
+        result = result && !ok;
+        parseComplex("j", &ok);
+        return result && !ok;
+    };
+}
+
+TEST_SET(ResultWriterSet) {
+    TEST(FixedPrecisionSameAsOstream) {
+        std::mt19937_64 gen(2018);
+        std::uniform_int_distribution<uint64_t> bits;
+        std::string text;
+        std::stringstream expected;
+        {
+            ResultWriter writer(text, 6);
+            for (int i = 0; i < 10000; ++i) {
+                uint64_t x = bits(gen);
+                double value;
+                std::memcpy(&value, &x, sizeof(value));
+                if (value != value || std::abs(value) < 1) {
+                    continue;
+                }
+                writer << value << ' ' << std::complex<double>(value, -value) << '\n';
+                expected << value << ' ';
+                expected << value << (value > 0 ? "" : "+") << -value << "j\n";
+            }
+        }
+        return text == expected.str();
+    };
+
+    TEST(ShortestRoundTrips) {
+        std::mt19937_64 gen(2018);
+        std::uniform_int_distribution<uint64_t> bits;
+        for (int i = 0; i < 10000; ++i) {
+            uint64_t x = bits(gen);
+            double value;
+            std::memcpy(&value, &x, sizeof(value));
+            std::string text;
+            {
+                ResultWriter writer(text);
+                writer << value;
+            }
+            bool ok;
+            double parsed = parseDouble(text, &ok);
+            if (value == value && parsed != value) {
+                std::cerr << "Bad representation " << text << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+}
+
+static std::string runSolver(const char* field, const std::vector<std::array<std::string, 3>>& equations) {
+    std::stringstream output;
+    Console console(std::cin, output);
+    console.setVariable("field", field);
+    SolverApp app(&console);
+    for (const auto& eq : equations) {
+        app.exec({"solve", eq[0], eq[1], eq[2]});
+    }
+    return output.str();
+}
+
+static std::string runBatchSolver(const char* field, const char* kernel,
+                                  const std::vector<std::array<std::string, 3>>& equations,
+                                  const std::map<std::string, std::string>& variables = {}) {
+    std::string fileName = tempFileName("batch_solver_test.txt");
+    {
+        std::ofstream file(fileName);
+        for (const auto& eq : equations) {
+            file << eq[0] << ' ' << eq[1] << ' ' << eq[2] << '\n';
+        }
+    }
+
+    std::stringstream output;
+    Console console(std::cin, output);
+    console.setVariable("field", field);
+    console.setVariable("kernel", kernel);
+    for (const auto& variable : variables) {
+        console.setVariable(variable.first, variable.second);
+    }
+    BatchSolverApp app(&console);
+    if (app.exec({"solvebatch", fileName}) != IApp::STATUS_OK) {
+        output << "FAILED";
+    }
+    std::remove(fileName.c_str());
+    return output.str();
+}
+
+static std::string toString(double x) {
+    std::stringstream stream;
+    stream.precision(17);
+    stream << x;
+    return stream.str();
+}
+
+TEST_SET(BatchSolverAppSet) {
+    TEST(RealSameAsScalar) {
+        std::vector<std::array<std::string, 3>> equations = {
+            {"1", "0", "-1"}, {"1", "2", "1"}, {"1", "0", "1"}, {"0", "0", "0"}, {"0", "1", "0"},
+            {"0", "0", "1"}, {"2", "-3", "1"}, {"1e-20", "1", "2"}, {"-1", "0", "0"},
+            {"3", "1e10", "1"}, {"1", "1", "1"}
+        };
+        std::mt19937 gen(2018);
+        std::uniform_real_distribution<double> dist(-100, 100);
+        for (int i = 0; i < 1000; ++i) {
+            equations.push_back({toString(dist(gen)), toString(dist(gen)), toString(dist(gen))});
+        }
+
+        std::string expected = runSolver("R", equations);
+        bool ok = true;
+        for (const char* kernel : {"scalar", "avx2", "auto"}) {
+            if (runBatchSolver("R", kernel, equations) != expected) {
+                std::cerr << "Kernel " << kernel << " differs from scalar solver" << std::endl;
+                ok = false;
+            }
+        }
+        return ok;
+    };
+
+    TEST(ComplexSameAsScalar) {
+        // Нулевые коэффициенты и вывод --- как у solve; на этих уравнениях совпадают и разряды
+        std::vector<std::array<std::string, 3>> equations = {
+            {"1", "0", "1"}, {"1", "0", "-1"}, {"1", "2j", "-1"}, {"0", "0", "0"}, {"0", "0", "1j"},
+            {"0", "1j", "1"}, {"1", "-3", "2"}, {"1j", "0", "1j"}, {"2", "0", "8"}, {"1", "-2", "5"},
+            {"-1", "0", "4j"}
+        };
+        std::string expected = runSolver("C", equations);
+        bool ok = true;
+        for (const char* kernel : {"scalar", "avx2"}) {
+            if (runBatchSolver("C", kernel, equations) != expected) {
+                std::cerr << "Kernel " << kernel << " differs from scalar solver" << std::endl;
+                ok = false;
+            }
+        }
+        return ok;
+    };
+
+    TEST(ComplexCloseToSolve) {
+        // Корень и деление векторизованы, поэтому корни отличаются от solve в младших
+        // разрядах: погрешность --- несколько ulp от наибольшего слагаемого формулы
+        // (-b +- sqrt(D)) / 2a, в том числе при очень больших и очень малых модулях
+        typedef std::complex<double> Complex;
+        std::vector<std::array<Complex, 3>> equations = {
+            {Complex(1e-200, 1e-200), 1e-150, Complex(0, 1e-100)}, {1e150, Complex(0, 1e150), -1e150}
+        };
+        std::mt19937 gen(2018);
+        std::uniform_real_distribution<double> dist(-100, 100);
+        std::uniform_int_distribution<int> exponent(-150, 150);
+        for (int i = 0; i < 2000; ++i) {
+            std::array<Complex, 3> eq;
+            for (auto& coefficient : eq) {
+                double scale = (i % 4 == 0) ? std::pow(10., exponent(gen)) : 1.;
+                coefficient = Complex(dist(gen) * scale, dist(gen) * scale);
+            }
+            equations.push_back(eq);
+        }
+        std::size_t size = equations.size();
+        std::vector<double> columns[10];
+        for (auto& column : columns) {
+            column.resize(size);
+        }
+        std::vector<signed char> count(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                columns[2 * k][i] = equations[i][k].real();
+                columns[2 * k + 1][i] = equations[i][k].imag();
+            }
+        }
+        ComplexBatchView view = {
+            columns[0].data(), columns[1].data(), columns[2].data(), columns[3].data(), columns[4].data(),
+            columns[5].data(), columns[6].data(), columns[7].data(), columns[8].data(), columns[9].data(),
+            count.data()
+        };
+        const double tolerance = 8 * std::numeric_limits<double>::epsilon();
+        for (BatchKernel kernel : {KERNEL_SCALAR, KERNEL_AVX2}) {
+            solveComplexBatch(view, 0, size, kernel);
+            for (std::size_t i = 0; i < size; ++i) {
+                const std::array<Complex, 3>& eq = equations[i];
+                Roots<Complex> roots = solveSquare(eq);
+                bool ok = roots.isDegenerate() ? count[i] == BATCH_DEGENERATE
+                                               : count[i] == static_cast<signed char>(roots.size());
+                double scale = 0;
+                if (count[i] == 2) {
+                    scale = std::abs(eq[1]) + std::abs(std::sqrt(eq[1] * eq[1] - 4. * eq[0] * eq[2]));
+                    scale /= 2 * std::abs(eq[0]);
+                }
+                for (std::size_t j = 0; ok && !roots.isDegenerate() && j < roots.size(); ++j) {
+                    Complex root(columns[6 + 2 * j][i], columns[7 + 2 * j][i]);
+                    ok = std::abs(root - roots[j]) <= tolerance * std::max(scale, std::abs(roots[j]));
+                }
+                if (!ok) {
+                    std::cerr << "Kernel " << kernel << ", equation " << eq[0] << ' ' << eq[1] << ' ' << eq[2]
+                              << ": " << Complex(columns[6][i], columns[7][i]) << ' '
+                              << Complex(columns[8][i], columns[9][i]) << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    TEST(ComplexKernelsAgree) {
+        std::vector<std::array<std::string, 3>> equations;
+        std::mt19937 gen(2018);
+        std::uniform_real_distribution<double> dist(-100, 100);
+        for (int i = 0; i < 1000; ++i) {
+            std::array<std::string, 3> eq;
+            for (auto& coefficient : eq) {
+                coefficient = toString(dist(gen)) + (dist(gen) < 0 ? "" : "+") + toString(dist(gen)) + "j";
+            }
+            equations.push_back(eq);
+        }
+        return runBatchSolver("C", "scalar", equations) == runBatchSolver("C", "avx2", equations);
+    };
+
+    TEST(ParallelKeepsOrder) {
+        std::vector<std::array<std::string, 3>> equations;
+        std::mt19937 gen(2018);
+        std::uniform_int_distribution<int> dist(-10, 10);
+        for (int i = 0; i < 10000; ++i) {
+            equations.push_back({std::to_string(dist(gen)), std::to_string(dist(gen)), std::to_string(dist(gen))});
+        }
+        std::string expected = runBatchSolver("R", "auto", equations, {{"threads", "1"}});
+        for (const char* threads : {"2", "7", "16"}) {
+            for (const char* chunk : {"1", "13", "auto"}) {
+                if (runBatchSolver("R", "auto", equations, {{"threads", threads}, {"batch_chunk", chunk}}) != expected) {
+                    std::cerr << "Output differs for threads=" << threads << ", batch_chunk=" << chunk << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    TEST(AdaptiveKernelsAgree) {
+        std::vector<std::array<std::string, 3>> equations = {
+            {"1", "1e8", "1"}, {"1", "-1e8", "1"}, {"1", "2", "1"}, {"1", "0", "1"}, {"0", "0", "0"},
+            {"0", "2", "1"}, {"1e-30", "1", "1"}, {"1e70", "1", "-1"}, {"1", "2.0000001", "1"}
+        };
+        std::mt19937 gen(2018);
+        std::uniform_real_distribution<double> dist(-100, 100);
+        for (int i = 0; i < 1000; ++i) {
+            equations.push_back({toString(dist(gen)), toString(dist(gen)), toString(dist(gen))});
+        }
+        std::map<std::string, std::string> variables = {{"mode", "adaptive"}, {"batch_chunk", "5"}};
+        std::string expected = runBatchSolver("R", "scalar", equations, variables);
+        return expected.find("FAILED") == std::string::npos &&
+               runBatchSolver("R", "avx2", equations, variables) == expected;
+    };
+
+    TEST(AdaptiveEscalation) {
+        std::string fileName = tempFileName("batch_adaptive_test.txt");
+        {
+            std::ofstream file(fileName);
+            file << "1 1e8 1\n1 -3 2\n1 2.0000001 1\n";
+        }
+        std::stringstream output;
+        Console console(std::cin, output);
+        console.setVariable("verbosity", "ERROR");
+        console.setVariable("mode", "adaptive");
+        BatchSolverApp app(&console);
+        bool ok = app.exec({"solvebatch", fileName}) == IApp::STATUS_OK;
+        ok = ok && app.exec({"solvebatch", fileName}) == IApp::STATUS_OK;
+        console.setVariable("field", "C");
+        ok = ok && app.exec({"solvebatch", fileName}) == BatchSolverApp::STATUS_BAD_MODE;
+        console.setVariable("field", "R");
+        console.setVariable("tolerance", "-1");
+        ok = ok && app.exec({"solvebatch", fileName}) == BatchSolverApp::STATUS_BAD_TOLERANCE;
+        std::remove(fileName.c_str());
+
+        // Малый корень x^2 + 1e8 x + 1 = 0 равен -1e-8 с относительной точностью 1e-16;
+        // классическая формула теряет в нём половину знаков
+        double x1 = 0, x2 = 0;
+        output >> x1 >> x2;
+        ok = ok && std::abs(x1 / -1e-8 - 1) < 1e-15 && std::abs(x2 / -1e8 - 1) < 1e-15;
+        // Каждый запуск решает 3 уравнения; почти кратный корень требует повышения точности
+        int solvedFloat = std::stoi(console.getVariable("adaptive_float"));
+        int escalated = std::stoi(console.getVariable("adaptive_double")) +
+                        std::stoi(console.getVariable("adaptive_long_double"));
+        ok = ok && solvedFloat >= 2 && escalated >= 2 && solvedFloat + escalated == 6;
+        return ok;
+    };
+}
+
+TEST_SET(SolverSet) {
+    TEST(Classification) {
+        constexpr Roots<double> degenerate = solveLinear(0., 0.);
+        constexpr Roots<double> none = solveLinear(0., 1.);
+        static_assert(degenerate.isDegenerate() && degenerate.empty(), "0 = 0 holds for every x");
+        static_assert(none.kind() == Roots<double>::ROOTS_NONE, "1 = 0 has no solutions");
+        Roots<double> two = solveSquare<double>({1, 0, -4});
+        Roots<double> complexNone = solveSquare<double>({1, 0, 4});
+        Roots<std::complex<double>> complexTwo = solveSquare<std::complex<double>>({1, 0, 4});
+        return two.kind() == Roots<double>::ROOTS_FINITE && two.size() == 2 && two[0] == 2 && two[1] == -2
+               && complexNone.kind() == Roots<double>::ROOTS_NONE
+               && complexTwo.size() == 2 && complexTwo[0] == std::complex<double>(0, 2);
+    };
+
+    TEST_SERIAL(NoAllocations) {
+        std::mt19937 gen(2018);
+        std::uniform_real_distribution<double> dist(-10, 10);
+        const std::size_t count = 1000;
+        std::vector<double> coefficients(6 * count);
+        for (double& x : coefficients) {
+            x = dist(gen);
+        }
+        std::vector<double> roots(4 * count);
+        std::vector<signed char> counts(count);
+        ComplexBatchView view = {&coefficients[0], &coefficients[count], &coefficients[2 * count],
+                                 &coefficients[3 * count], &coefficients[4 * count], &coefficients[5 * count],
+                                 &roots[0], &roots[count], &roots[2 * count], &roots[3 * count], counts.data()};
+
+        std::ostream devNull(nullptr);
+        Console console(std::cin, devNull);
+        console.setVariable("verbosity", "ERROR");
+        console.installApps<SolverApp>();
+        int solve = console.findApp("solve");
+        std::string_view args[4] = {"solve", "1", "-3", "2"};
+
+        std::size_t before = allocationCount;
+        double sum = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            Roots<double> real = solveSquare<double>({coefficients[i], coefficients[count + i], coefficients[2 * count + i]});
+            Roots<std::complex<double>> complex = solveSquare<std::complex<double>>(
+                {std::complex<double>(coefficients[i], coefficients[count + i]),
+                 std::complex<double>(coefficients[2 * count + i], coefficients[3 * count + i]),
+                 std::complex<double>(coefficients[4 * count + i], coefficients[5 * count + i])});
+            sum += real.size() + complex.size();
+            console.execApp(solve, ArgList(args, 4));
+        }
+        solveRealBatch(&coefficients[0], &coefficients[count], &coefficients[2 * count],
+                       &roots[0], &roots[count], counts.data(), 0, count);
+        solveComplexBatch(view, 0, count);
+        std::size_t allocations = allocationCount - before;
+        if (allocations != 0) {
+            std::cerr << allocations << " allocations" << std::endl;
+        }
+        return allocations == 0 && sum > 0;
+    };
+
+    TEST_BENCH(RealBatchKernel, 10) {
+        // Коэффициенты готовятся при первом запуске, замеряется только решение
+        constexpr std::size_t count = 100000;
+        static const std::vector<double> coefficients = [] {
+            std::mt19937 gen(2018);
+            std::uniform_real_distribution<double> dist(-10, 10);
+            std::vector<double> values(3 * count);
+            for (double& x : values) {
+                x = dist(gen);
+            }
+            return values;
+        }();
+        static std::vector<double> roots(2 * count);
+        static std::vector<signed char> counts(count);
+        solveRealBatch(&coefficients[0], &coefficients[count], &coefficients[2 * count],
+                       &roots[0], &roots[count], counts.data(), 0, count);
+        return std::count(counts.begin(), counts.end(), 2) > 0;
+    };
+}
+
+TEST_SET(FieldSet) {
+    TEST(EpsilonPerType) {
+        return isZero(1e-8f) && !isZero(1e-8) && !isZero(1e-18L) && isZero(1e-20L)
+               && isZero(std::complex<float>(1e-8f, -1e-8f)) && !isZero(std::complex<double>(1e-8, 0))
+#ifdef HAVE_QUADMATH
+               && !isZero(Float128(1e-20)) && isZero(Float128(1e-35))
+#endif
+               && isValid(1.f) && !isValid(std::nanl(""));
+    };
+
+    TEST(AllFieldsSolve) {
+        std::vector<std::array<std::string, 3>> equations = {{"1", "0", "-2"}, {"1", "0", "2"}, {"0", "0", "0"},
+                                                              {"2", "-3", "1"}, {"+1", "2", "1"}};
+        std::map<std::string, std::string> expected = {
+            {"F", "1.4142135 -1.4142135\n\n1 0.5\n-1\n"},
+            {"CF", "1.4142135 -1.4142135\n1.4142135j -1.4142135j\n1 0.5\n-1\n"},
+            {"LD", "1.4142135623730950488 -1.4142135623730950488\n\n1 0.5\n-1\n"},
+            {"CLD", "1.4142135623730950488 -1.4142135623730950488\n"
+                    "1.4142135623730950488j -1.4142135623730950488j\n1 0.5\n-1\n"},
+#ifdef HAVE_QUADMATH
+            {"Q128", "1.4142135623730950488016887242096982 -1.4142135623730950488016887242096982\n\n1 0.5\n-1\n"},
+            {"CQ128", "1.4142135623730950488016887242096982 -1.4142135623730950488016887242096982\n"
+                      "1.4142135623730950488016887242096982j -1.4142135623730950488016887242096982j\n1 0.5\n-1\n"},
+#endif
+        };
+        bool ok = true;
+        for (const auto& field : expected) {
+            std::string output = runSolver(field.first.c_str(), equations);
+            if (output.find("[ERROR]") != std::string::npos || output.find("[DEBUG]") != std::string::npos) {
+                std::cerr << output;
+                return false;
+            }
+            // Информационные сообщения не сравниваем
+            std::string roots;
+            std::stringstream lines(output);
+            std::string line;
+            while (std::getline(lines, line)) {
+                if (line.compare(0, 1, "#") != 0) {
+                    roots += line + "\n";
+                }
+            }
+            if (roots != field.second) {
+                std::cerr << field.first << ": " << roots;
+                ok = false;
+            }
+        }
+        return ok;
+    };
+}
+
+TEST_SET(SolveCacheSet) {
+    TEST(SameOutputAsUncached) {
+        std::string script;
+        std::mt19937 gen(2018);
+        std::uniform_int_distribution<int> dist(-5, 5);
+        for (const char* field : {"R", "C"}) {
+            script += std::string("set field ") + field + "\n";
+            for (int i = 0; i < 3000; ++i) {
+                script += "solve " + std::to_string(dist(gen)) + " " + std::to_string(dist(gen)) + " "
+                          + std::to_string(dist(gen)) + "\n";
+            }
+        }
+        std::string outputs[2];
+        for (int cached = 0; cached < 2; ++cached) {
+            std::stringstream input(script);
+            std::stringstream output;
+            Console console(input, output);
+            console.setVariable("verbosity", "ERROR");
+            console.setVariable("cache_size", cached ? "100" : "0");
+            console.installApps<SetterApp, SolverApp>();
+            console.exec(0, nullptr);
+            outputs[cached] = output.str();
+        }
+        return outputs[0] == outputs[1];
+    };
+
+    TEST(EvictionAndCounters) {
+        SolveCache<double> cache;
+        cache.resize(20);
+        bool ok = cache.capacity() == 16;
+        for (int i = 0; i < 1000; ++i) {
+            Roots<double> value;
+            value.push_back(i);
+            cache.insert({1, 0, static_cast<double>(i)}, value);
+        }
+        ok = cache.size() == 16 && ok;
+        const Roots<double>* last = cache.find({1, 0, 999});
+        ok = last != nullptr && (*last)[0] == 999 && cache.find({1, 0, 0}) == nullptr && ok;
+        return ok && cache.hits() == 1 && cache.misses() == 1;
+    };
+
+    TEST(CacheCommand) {
+        std::stringstream input("set cache_size 64\nsolve 1 0 -1\nsolve 1 0 -1\nsolve 1 0 -4\ncache\n"
+                                "cache clear\ncache reset\ncache\n");
+        std::stringstream output;
+        Console console(input, output);
+        console.setVariable("verbosity", "ERROR");
+        console.installApps<SetterApp, SolverApp, CacheApp>();
+        console.exec(0, nullptr);
+        return output.str() == "1 -1\n1 -1\n2 -2\n"
+                               "R: hits 1, misses 2, entries 2/64\nC: hits 0, misses 0, entries 0/0\n"
+                               "R: hits 0, misses 0, entries 0/64\nC: hits 0, misses 0, entries 0/0\n";
+    };
+}
+
+static bool compileScript(const std::string& script, Program* program) {
+    ScriptCompiler compiler;
+    std::stringstream lines(script);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!compiler.addLine(line)) {
+            return false;
+        }
+    }
+    return compiler.finish(program);
+}
+
+TEST_SET(ScriptSet) {
+    TEST(InteractiveLoops) {
+        std::stringstream input("for i 1 3\n  echo $i\n  repeat 2\n    echo x $undefined\n  end\nend\n"
+                                "for i 5 1 -2\necho $i\nend\nrepeat 0\necho never\nend\necho after\n");
+        std::stringstream output;
+        Console console(input, output);
+        console.setVariable("verbosity", "ERROR");
+        console.emplaceApp<LegacyEchoApp>("echo");
+        console.exec(0, nullptr);
+        return output.str() == "[echo][1]\n[echo][x][]\n[echo][x][]\n"
+                               "[echo][2]\n[echo][x][]\n[echo][x][]\n"
+                               "[echo][3]\n[echo][x][]\n[echo][x][]\n"
+                               "[echo][5]\n[echo][3]\n[echo][1]\n[echo][after]\n";
+    };
+
+    TEST(SubstitutionSameInAllModes) {
+        // Кэш компиляции не меняет смысла сценария: $name подставляется и вне циклов
+        std::string script = "set a 5\nset b $a\nget b\necho $a $undefined $ x$a\nrepeat 1\necho $b\nend\n";
+        std::string expected = "5\n[echo][5][][$][x$a]\n[echo][5]\n";
+        std::string outputs[3];
+        for (int mode = 0; mode < 3; ++mode) {
+            std::stringstream input(script);
+            std::stringstream output;
+            Console console(input, output);
+            console.setVariable("verbosity", "ERROR");
+            console.installApps<SetterApp, GetterApp>();
+            console.emplaceApp<LegacyEchoApp>("echo");
+            console.setPipelined(mode == 1);
+            if (mode == 2) {
+                Program program;
+                if (!compileScript(script, &program)) {
+                    return false;
+                }
+                console.exec(0, nullptr, program);
+            } else {
+                console.exec(0, nullptr);
+            }
+            outputs[mode] = output.str();
+            if (outputs[mode] != expected) {
+                std::cerr << "Mode " << mode << ": " << outputs[mode];
+            }
+        }
+        return outputs[0] == expected && outputs[1] == expected && outputs[2] == expected;
+    };
+
+    TEST(UnclosedLoopAtEndOfInput) {
+        std::stringstream input("for i 1 3\nsolve 1 0 -$i\n");
+        std::stringstream output;
+        Console console(input, output);
+        console.setVariable("verbosity", "ERROR");
+        console.installApps<SolverApp>();
+        console.exec(0, nullptr);
+        return output.str() == "# [ERROR] Script error: unexpected end of input, loop is not closed with 'end'\n";
+    };
+
+    TEST(CompileErrors) {
+        Program program;
+        return !compileScript("end\n", &program) && !compileScript("for i 1\nend\n", &program)
+               && !compileScript("repeat x\nend\n", &program) && !compileScript("repeat 2\n", &program)
+               && !compileScript("$cmd 1\n", &program) && compileScript("set n 2\nrepeat $n\nend\n", &program);
+    };
+
+    TEST(CacheRoundTrip) {
+        std::string script = "set n 3\nfor k 1 $n\nsolve -1 0 $k\nend\nexit\nsolve 1 1 1\n";
+        std::uint64_t hash = Program::hash(script);
+        Program compiled;
+        Program loaded;
+        bool ok = compileScript(script, &compiled);
+        ok = compiled.save("script_cache_test.sqbc", hash) && ok;
+        ok = !loaded.load("script_cache_test.sqbc", hash + 1) && ok;
+        ok = loaded.load("script_cache_test.sqbc", hash) && ok;
+        std::remove("script_cache_test.sqbc");
+
+        std::stringstream output;
+        Console console(std::cin, output);
+        console.setVariable("verbosity", "ERROR");
+        console.installApps<SetterApp, SolverApp>();
+        console.exec(0, nullptr, loaded);
+        return ok && output.str() == "-1 1\n-1.4142135623730951 1.4142135623730951\n"
+                                     "-1.7320508075688772 1.7320508075688772\n";
+    };
+}
+
+static std::string runPolySolver(const char* field, const std::vector<std::vector<std::string>>& equations,
+                                 const std::map<std::string, std::string>& variables = {}) {
+    std::stringstream output;
+    Console console(std::cin, output);
+    console.setVariable("field", field);
+    for (const auto& variable : variables) {
+        console.setVariable(variable.first, variable.second);
+    }
+    PolySolverApp app(&console);
+    for (const auto& eq : equations) {
+        std::vector<std::string> args = {"solvepoly"};
+        args.insert(args.end(), eq.begin(), eq.end());
+        if (app.exec(args) != IApp::STATUS_OK) {
+            output << "FAILED";
+        }
+    }
+    return output.str();
+}
+
+TEST_SET(PolySolverSet) {
+    TEST(LowDegreeSameAsSolve) {
+        std::vector<std::array<std::string, 3>> equations = {
+            {"1", "0", "-1"}, {"1", "2", "1"}, {"1", "0", "1"}, {"0", "0", "0"}, {"0", "1", "0"},
+            {"0", "0", "1"}, {"2", "-3", "1"}, {"3", "1e10", "1"}
+        };
+        std::vector<std::vector<std::string>> polynomials;
+        for (const auto& eq : equations) {
+            polynomials.push_back({"0", "0", eq[0], eq[1], eq[2]});
+        }
+        return runPolySolver("R", polynomials) == runSolver("R", equations) &&
+               runPolySolver("C", polynomials) == runSolver("C", equations);
+    };
+
+    TEST(KnownRoots) {
+        // Многочлены с известными различными корнями, в том числе комплексными
+        std::mt19937 gen(2018);
+        std::uniform_real_distribution<double> dist(-5, 5);
+        for (int degree = 3; degree <= 9; ++degree) {
+            const std::size_t size = 50;
+            PolynomialBatch<double> batch(degree, size);
+            std::vector<std::vector<std::complex<double>>> expected(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                std::vector<std::complex<double>> poly = {1};
+                for (int j = 0; j < degree; ++j) {
+                    std::complex<double> root(dist(gen), (i % 2 == 0) ? 0 : dist(gen));
+                    expected[i].push_back(root);
+                    poly.push_back(0);
+                    for (std::size_t k = poly.size() - 1; k > 0; --k) {
+                        poly[k] -= root * poly[k - 1];
+                    }
+                }
+                for (int power = 0; power <= degree; ++power) {
+                    batch.setCoefficient(i, power, poly[degree - power]);
+                }
+            }
+            batch.solve(0, size);
+            for (std::size_t i = 0; i < size; ++i) {
+                for (const auto& root : expected[i]) {
+                    double best = 1e300;
+                    for (int j = 0; j < degree; ++j) {
+                        best = std::min(best, std::abs(batch.getRoot(i, j) - root));
+                    }
+                    if (best > 1e-6) {
+                        std::cerr << "Degree " << degree << ": root " << root << " not found" << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
+
+        // Кратные корни: приближения кратного корня разбросаны на eps^(1/m), но объединяются
+        // в одно решение, которое после уточнения точнее отдельных приближений
+        typedef std::vector<std::pair<std::complex<double>, int>> Multiple;
+        std::vector<Multiple> multiple = {
+            {{1, 5}},
+            {{2, 4}, {-1, 1}},
+            {{-0.5, 4}, {3, 1}, {{0, 1}, 1}, {{0, -1}, 1}},
+            {{{0, 1}, 4}, {{0, -1}, 4}},
+            {{1, 5}, {-2, 4}},
+            {{{1, 2}, 4}, {{1, -2}, 4}, {0.5, 1}}
+        };
+        for (const auto& roots : multiple) {
+            std::vector<std::complex<double>> poly = {1};
+            for (const auto& root : roots) {
+                for (int m = 0; m < root.second; ++m) {
+                    poly.push_back(0);
+                    for (std::size_t k = poly.size() - 1; k > 0; --k) {
+                        poly[k] -= root.first * poly[k - 1];
+                    }
+                }
+            }
+            int degree = static_cast<int>(poly.size()) - 1;
+            PolynomialBatch<double> batch(degree, 1);
+            for (int power = 0; power <= degree; ++power) {
+                batch.setCoefficient(0, power, poly[degree - power]);
+            }
+            batch.solve(0, 1);
+            std::vector<std::complex<double>> solutions(degree);
+            std::vector<double> radii(degree);
+            for (int j = 0; j < degree; ++j) {
+                solutions[j] = batch.getRoot(0, j);
+                radii[j] = batch.getRadius(0, j);
+            }
+            std::size_t merged = mergeRoots(solutions.data(), radii.data(), degree,
+                                            [&batch](std::complex<double>* root, double* radius, int multiplicity) {
+                                                batch.refineMultiple(0, multiplicity, root, radius);
+                                            });
+            bool ok = (merged == roots.size());
+            for (const auto& root : roots) {
+                bool found = false;
+                for (std::size_t j = 0; j < merged; ++j) {
+                    if (std::abs(solutions[j] - root.first) < 1e-6 && std::abs(solutions[j] - root.first) <= radii[j] &&
+                        isRealRoot(solutions[j], radii[j]) == (root.first.imag() == 0)) {
+                        found = true;
+                    }
+                }
+                ok = ok && found;
+            }
+            if (!ok) {
+                std::cerr << "Degree " << degree << ": " << merged << " solutions";
+                for (std::size_t j = 0; j < merged; ++j) {
+                    std::cerr << ' ' << solutions[j] << " (" << radii[j] << ')';
+                }
+                std::cerr << std::endl;
+                return false;
+            }
+        }
+        return true;
+    };
+
+    TEST(RealField) {
+        std::string expected =
+            "1 2 3\n"
+            "1\n"
+            "-1 1\n"
+            "1\n"
+            "1\n"
+            "-1 2\n";
+        std::vector<std::vector<std::string>> equations = {
+            {"1", "-6", "11", "-6"}, {"1", "-3", "3", "-1"}, {"1", "0", "-2", "0", "1"},
+            {"1", "0", "0", "0", "0", "-1"}, {"1", "-5", "10", "-10", "5", "-1"},
+            {"1", "-6", "9", "8", "-24", "0", "16"}
+        };
+        return runPolySolver("R", equations, {{"verbosity", "ERROR"}}) == expected &&
+               runPolySolver("LD", equations, {{"verbosity", "ERROR"}}) == expected &&
+               // Над C кратный корень тоже выводится одним решением
+               runPolySolver("C", {{"1", "-5", "10", "-10", "5", "-1"}, {"1", "-6", "9", "8", "-24", "0", "16"}},
+                             {{"verbosity", "ERROR"}}) == "1\n-1 2\n";
+    };
+
+    TEST(FileSameAsArguments) {
+        std::vector<std::vector<std::string>> equations;
+        std::mt19937 gen(2018);
+        std::uniform_int_distribution<int> dist(-10, 10);
+        for (int i = 0; i < 2000; ++i) {
+            equations.emplace_back(1 + i % 7);
+            for (auto& coefficient : equations.back()) {
+                coefficient = std::to_string(dist(gen));
+            }
+        }
+        std::string fileName = tempFileName("poly_solver_test.txt");
+        {
+            std::ofstream file(fileName);
+            file << "# comment\n\n";
+            for (const auto& eq : equations) {
+                for (const auto& coefficient : eq) {
+                    file << coefficient << ' ';
+                }
+                file << '\n';
+            }
+        }
+        std::string expected = runPolySolver("C", equations);
+        bool ok = true;
+        for (const char* threads : {"1", "4"}) {
+            if (runPolySolver("C", {{"-f", fileName}}, {{"threads", threads}}) != expected) {
+                std::cerr << "Output differs for threads=" << threads << std::endl;
+                ok = false;
+            }
+        }
+        std::remove(fileName.c_str());
+        return ok;
+    };
+}
+
+static std::string readWholeFile(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+TEST_SET(BinaryFormatSet) {
+    TEST(BlocksRoundTrip) {
+        std::string fileName = tempFileName("binary_test.sqrs");
+        BinaryBlock block;
+        BinaryWriter writer;
+        bool ok = writer.open(fileName, BINARY_RESULTS, true, 4);
+        std::vector<signed char> counts = {2, 1, 0, BATCH_DEGENERATE, 2, 2, 1, 0, 1, 2};
+        for (std::size_t begin = 0; begin < counts.size(); begin += 4) {
+            std::size_t size = std::min<std::size_t>(4, counts.size() - begin);
+            block.resize(size, 4, true);
+            for (std::size_t i = 0; i < size; ++i) {
+                block.count[i] = counts[begin + i];
+                for (std::size_t k = 0; k < 4; ++k) {
+                    block.columns[k][i] = double(10 * (begin + i) + k + 1);
+                }
+            }
+            ok = ok && writer.writeBlock(block);
+        }
+        ok = ok && writer.close();
+
+        BinaryReader reader;
+        ok = ok && reader.open(fileName) && reader.getKind() == BINARY_RESULTS && reader.isComplex() &&
+             reader.getBlockSize() == 4 && reader.getCount() == counts.size();
+        std::size_t index = 0;
+        while (ok && reader.readBlock(&block)) {
+            for (std::size_t i = 0; i < block.size; ++i, ++index) {
+                ok = ok && block.count[i] == counts[index];
+                // Отсутствующие корни записываются нулями
+                for (std::size_t k = 0; k < 4; ++k) {
+                    double expected = (int(k / 2) < counts[index]) ? double(10 * index + k + 1) : 0;
+                    ok = ok && block.columns[k][i] == expected;
+                }
+            }
+        }
+        std::size_t fileSize = readWholeFile(fileName).size();
+        std::remove(fileName.c_str());
+        // Заголовок и три блока: байты счётчиков с выравниванием и по 4 столбца double
+        return ok && reader.getError().empty() && index == counts.size() &&
+               fileSize == BinaryFormat::HEADER_SIZE + 2 * (8 + 4 * 4 * 8) + (8 + 2 * 4 * 8);
+    };
+
+    TEST(DamagedCountRejected) {
+        std::string fileName = tempFileName("binary_damaged.sqrs");
+        std::string textName = tempFileName("binary_damaged.txt");
+        BinaryBlock block;
+        block.resize(3, 2, true);
+        block.count = {2, 1, 0};
+        BinaryWriter writer;
+        bool ok = writer.open(fileName, BINARY_RESULTS, false, 4) && writer.writeBlock(block) && writer.close();
+        std::string bytes = readWholeFile(fileName);
+        // Байт числа корней второго уравнения, затем байт вырожденности третьего
+        for (std::size_t offset : {BinaryFormat::HEADER_SIZE + 1, BinaryFormat::HEADER_SIZE + 3 + 2}) {
+            std::string damaged = bytes;
+            damaged[offset] = (offset == BinaryFormat::HEADER_SIZE + 1) ? 120 : 2;
+            std::ofstream(fileName, std::ios::binary) << damaged;
+            BinaryReader reader;
+            ok = ok && reader.open(fileName) && !reader.readBlock(&block) &&
+                    reader.getError().find("Damaged file") == 0;
+
+            std::stringstream output;
+            Console console(std::cin, output);
+            console.setVariable("verbosity", "ERROR");
+            ConvertApp app(&console);
+            ok = ok && app.exec({"convert", fileName, textName}) == ConvertApp::STATUS_FORMAT_ERROR;
+        }
+        std::remove(fileName.c_str());
+        std::remove(textName.c_str());
+        return ok;
+    };
+
+    TEST(SameAsSolveBatch) {
+        bool ok = true;
+        for (const char* field : {"R", "C"}) {
+            std::string text = tempFileName("binary_test.txt");
+            std::string equations = tempFileName("binary_test.sqeq");
+            std::string results = tempFileName("binary_test.sqrs");
+            std::string roots = tempFileName("binary_test_roots.txt");
+            std::string back = tempFileName("binary_test_back.txt");
+            std::mt19937 gen(2018);
+            std::uniform_int_distribution<int> dist(-5, 5);
+            {
+                std::ofstream file(text);
+                file << "# comment\n0 0 0\nsolve 1 2 1\n";
+                for (int i = 0; i < 3 * 100000; ++i) {
+                    file << dist(gen);
+                    if (field[0] == 'C') {
+                        int imag = dist(gen);
+                        file << (imag < 0 ? "" : "+") << imag << 'j';
+                    }
+                    file << ((i % 3 == 2) ? '\n' : ' ');
+                }
+                file << "1 1\n-1\n";
+            }
+            std::stringstream input(std::string("set field ") + field + "\nset precision 10\n"
+                                    "convert " + text + ' ' + equations + "\n"
+                                    "solvebin " + equations + ' ' + results + "\n"
+                                    "convert " + results + ' ' + roots + "\n"
+                                    "convert " + equations + ' ' + back + "\n"
+                                    "solvebatch " + back + "\n");
+            std::stringstream output;
+            Console console(input, output);
+            console.setVariable("verbosity", "ERROR");
+            console.installApps<SetterApp, BatchSolverApp, BinarySolverApp, ConvertApp>();
+            console.exec(0, nullptr);
+            ok = ok && !output.str().empty() && readWholeFile(roots) == output.str();
+            for (const std::string& fileName : {text, equations, results, roots, back}) {
+                std::remove(fileName.c_str());
+            }
+        }
+        return ok;
+    };
+}
+
+TEST_SET(SolveStatsSet) {
+    TEST(RootCountsSameAsSolver) {
+        // Малые целые коэффициенты дают много линейных, вырожденных и кратных случаев
+        std::mt19937 gen(2018);
+        std::uniform_int_distribution<int> dist(-3, 3);
+        const std::size_t count = 10003;
+        std::vector<double> a(count), b(count), c(count), x1(count), x2(count);
+        std::vector<signed char> roots(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            a[i] = dist(gen);
+            b[i] = dist(gen);
+            c[i] = (i % 5 == 0) ? std::nan("") : dist(gen);
+        }
+        solveRealBatch(a.data(), b.data(), c.data(), x1.data(), x2.data(), roots.data(), 0, count);
+        BatchRootHistogram expected;
+        for (signed char n : roots) {
+            ++(n == BATCH_DEGENERATE ? expected.degenerate : expected.roots[n]);
+        }
+        bool ok = true;
+        for (BatchKernel kernel : {KERNEL_SCALAR, KERNEL_AVX2}) {
+            BatchRootHistogram histogram;
+            countRealRoots(a.data(), b.data(), c.data(), 0, count, &histogram, kernel);
+            ok = ok && histogram.degenerate == expected.degenerate && histogram.roots[0] == expected.roots[0] &&
+                 histogram.roots[1] == expected.roots[1] && histogram.roots[2] == expected.roots[2];
+        }
+        return ok && expected.degenerate > 0 && expected.roots[0] > 0 && expected.roots[1] > 0;
+    };
+
+    TEST(SummaryOfTextAndBinary) {
+        std::string text = tempFileName("stats_test.txt");
+        std::string binary = tempFileName("stats_test.sqeq");
+        std::mt19937 gen(2018);
+        std::uniform_int_distribution<int> dist(-5, 5);
+        std::vector<std::array<std::string, 3>> equations(200000);
+        {
+            std::ofstream file(text);
+            file << "# comment\n";
+            for (auto& eq : equations) {
+                for (auto& coefficient : eq) {
+                    coefficient = std::to_string(dist(gen));
+                }
+                file << eq[0] << ' ' << eq[1] << ' ' << eq[2] << '\n';
+            }
+        }
+
+        std::uint64_t counts[4] = {0, 0, 0, 0};
+        std::uint64_t rootCount = 0;
+        double min = 1e300, max = -1e300, sum = 0;
+        for (const auto& eq : equations) {
+            Roots<double> roots = solveSquare<double>({std::stod(eq[0]), std::stod(eq[1]), std::stod(eq[2])});
+            if (roots.isDegenerate()) {
+                ++counts[0];
+                continue;
+            }
+            ++counts[roots.size() + 1];
+            for (double x : roots) {
+                ++rootCount;
+                min = std::min(min, x);
+                max = std::max(max, x);
+                sum += x;
+            }
+        }
+        std::ostringstream expected;
+        expected.precision(6);
+        expected << "roots       equations\ndegenerate  " << counts[0] << "\n0           " << counts[1]
+                 << "\n1           " << counts[2] << "\n2           " << counts[3]
+                 << "\ntotal       " << equations.size() << "\nmin         " << min
+                 << "\nmax         " << max << "\nmean        " << sum / rootCount << '\n';
+
+        bool ok = true;
+        for (const char* threads : {"1", "3"}) {
+            std::stringstream input(std::string("set threads ") + threads + "\nset precision 6\n"
+                                    "solvestats -r " + text + "\nconvert " + text + ' ' + binary + "\n"
+                                    "solvestats -r " + binary + "\nsolvestats " + binary + "\n");
+            std::stringstream output;
+            Console console(input, output);
+            console.setVariable("verbosity", "ERROR");
+            console.installApps<SetterApp, ConvertApp, SolveStatsApp>();
+            console.exec(0, nullptr);
+            std::string countsOnly = expected.str().substr(0, expected.str().find("min"));
+            if (output.str() != expected.str() + expected.str() + countsOnly) {
+                std::cerr << "threads=" << threads << ":\n" << output.str() << "expected:\n" << expected.str();
+                ok = false;
+            }
+        }
+        std::remove(text.c_str());
+        std::remove(binary.c_str());
+        return ok;
+    };
+}
+
+// Отправляет сценарий серверу одним куском и читает ответ до закрытия соединения
+static std::string runOnServer(const std::string& address, const std::string& script) {
+    std::string error;
+    int fd = Server::connect(address, &error);
+    if (fd < 0) {
+        return error;
+    }
+    // Зависший сервер не должен вешать тесты: recv завершится ошибкой по тайм-ауту
+    timeval timeout = {10, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ssize_t sent = send(fd, script.data(), script.size(), MSG_NOSIGNAL);
+    shutdown(fd, SHUT_WR);
+    std::string output;
+    char buffer[4096];
+    ssize_t size;
+    while ((size = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        output.append(buffer, size);
+    }
+    close(fd);
+    return sent == ssize_t(script.size()) ? output : "send failed";
+}
+
+TEST_SET(ServerSet) {
+    TEST(SessionsAreIsolated) {
+        auto setup = [](Console& console) {
+            console.setVariable("verbosity", "ERROR");
+            console.installApps<SetterApp, SolverApp>();
+        };
+        Server server(setup, 4);
+        std::string address = "unix:server_test_" + std::to_string(getpid()) + ".sock";
+        if (!server.listen(address)) {
+            return false;
+        }
+        std::thread loop([&server] { server.run(); });
+
+        // Команды одного клиента идут подряд без ожидания ответов; переменные клиентов независимы
+        std::string script;
+        for (int i = 1; i <= 200; ++i) {
+            script += "solve 1 0 -" + std::to_string(i) + "\n";
+            if (i == 100) {
+                script += "set precision 3\n";
+            }
+        }
+        std::string plain = "solve 1 0 -2\nsolve 1 0 -3\n";
+        std::string expected[2];
+        for (int k = 0; k < 2; ++k) {
+            std::stringstream input(k == 0 ? script : plain);
+            std::stringstream output;
+            Console console(input, output);
+            setup(console);
+            console.exec(0, nullptr);
+            expected[k] = output.str();
+        }
+
+        std::string results[4];
+        std::vector<std::thread> clients;
+        for (int k = 0; k < 4; ++k) {
+            clients.emplace_back([&, k] { results[k] = runOnServer(address, k % 2 == 0 ? script : plain); });
+        }
+        for (auto& client : clients) {
+            client.join();
+        }
+        std::string exited = runOnServer(address, "solve 1 0 -1\nexit\nsolve 1 0 -4\n");
+        server.stop();
+        loop.join();
+
+        return results[0] == expected[0] && results[2] == expected[0] && results[1] == expected[1] &&
+               results[3] == expected[1] && expected[0] != expected[1] && exited == "1 -1\n";
+    };
+
+    TEST(HalfClosedClientGetsLargeOutput) {
+        auto setup = [](Console& console) {
+            console.setVariable("verbosity", "ERROR");
+            console.installApps<SolverApp>();
+        };
+        Server server(setup, 2);
+        std::string address = "unix:server_half_" + std::to_string(getpid()) + ".sock";
+        if (!server.listen(address)) {
+            return false;
+        }
+        std::thread loop([&server] { server.run(); });
+
+        // Клиент закрывает запись, пока команды выполняются; вывод больше буфера сокета
+        // и больше Server::OUTPUT_LIMIT, поэтому его приходится отправлять по EPOLLOUT
+        std::string script;
+        for (int i = 1; i <= 60000; ++i) {
+            script += "solve 1 0 -" + std::to_string(i) + "\n";
+        }
+        std::stringstream input(script);
+        std::stringstream expected;
+        Console console(input, expected);
+        setup(console);
+        console.exec(0, nullptr);
+
+        std::string result = runOnServer(address, script);
+        server.stop();
+        loop.join();
+        if (result != expected.str()) {
+            std::cerr << "Received " << result.size() << " of " << expected.str().size() << " bytes" << std::endl;
+        }
+        return expected.str().size() > Server::OUTPUT_LIMIT && result == expected.str();
+    };
+}
+
+int main(int argc, char* argv[]) {
+    return Tester::runAll(argc, argv);
 }
@@ -1,5 +1,16 @@
 #include <testing.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
 
 class ANSIMod {
     private:
@@ -19,39 +30,279 @@ class ANSIMod {
 #define RED     "\e[31;1m"
 #define BLUE    "\e[34;1m"
 
+typedef std::chrono::steady_clock Clock;
+
+// Перехват вывода: пока потоку назначена строка, всё, что он пишет в поток
+// вывода, попадает в неё; вывод остальных потоков идёт в исходный буфер
+class CaptureBuffer : public std::streambuf {
+    public:
+        explicit CaptureBuffer(std::streambuf* original) : original_(original) {}
+
+        static thread_local std::string* target;
+
+    protected:
+        virtual int overflow(int c) {
+            if (c == traits_type::eof()) {
+                return traits_type::not_eof(c);
+            }
+            char ch = traits_type::to_char_type(c);
+            return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+        }
+
+        virtual std::streamsize xsputn(const char* data, std::streamsize size) {
+            if (target != nullptr) {
+                target->append(data, size);
+                return size;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            return original_->sputn(data, size);
+        }
+
+        virtual int sync() {
+            if (target != nullptr) {
+                return 0;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            return original_->pubsync();
+        }
+
+    private:
+        std::streambuf* original_;
+        std::mutex mutex_;
+};
+
+thread_local std::string* CaptureBuffer::target = nullptr;
+
+struct TestResult {
+    bool ok = false;
+    std::string output;
+    /** Время каждого запуска в секундах */
+    std::vector<double> seconds;
+};
+
+static std::vector<Tester::Factory>& getFactories() {
+    static std::vector<Tester::Factory> factories;
+    return factories;
+}
+
+void Tester::registerSet(Factory factory) {
+    getFactories().push_back(factory);
+}
+
 void Tester::registerTest(const Test& test) {
     tests_.push_back(test);
 }
 
-void Tester::runTests() {
-    {
-        ANSIMod m(YELLOW);
-        std::cerr << "Test set " << getName() << std::endl;
-        std::cerr << "Running tests" << std::endl;
+static void runTest(const Tester::Test& test, TestResult* result) {
+    CaptureBuffer::target = &result->output;
+    result->ok = true;
+    for (unsigned run = 0; run < test.runs && result->ok; ++run) {
+        Clock::time_point start = Clock::now();
+        try {
+            result->ok = test.test();
+        } catch (const std::exception& e) {
+            result->output += std::string("Exception: ") + e.what() + '\n';
+            result->ok = false;
+        } catch (...) {
+            result->output += "Unknown exception\n";
+            result->ok = false;
+        }
+        result->seconds.push_back(std::chrono::duration<double>(Clock::now() - start).count());
     }
+    CaptureBuffer::target = nullptr;
+}
+
+static std::string formatTime(double seconds) {
+    char buffer[32];
+    if (seconds < 1e-3) {
+        std::snprintf(buffer, sizeof(buffer), "%.1f us", seconds * 1e6);
+    } else if (seconds < 1) {
+        std::snprintf(buffer, sizeof(buffer), "%.2f ms", seconds * 1e3);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.2f s", seconds);
+    }
+    return buffer;
+}
+
+static std::string formatBench(std::vector<double> seconds) {
+    std::sort(seconds.begin(), seconds.end());
+    double mean = 0;
+    for (double x : seconds) {
+        mean += x;
+    }
+    mean /= seconds.size();
+    double variance = 0;
+    for (double x : seconds) {
+        variance += (x - mean) * (x - mean);
+    }
+    variance /= seconds.size();
+    return std::to_string(seconds.size()) + " runs: min " + formatTime(seconds.front()) +
+           ", median " + formatTime(seconds[seconds.size() / 2]) + ", mean " + formatTime(mean) +
+           " +- " + formatTime(std::sqrt(variance)) + ", max " + formatTime(seconds.back());
+}
+
+// Подстрока, или шаблон со * (любая последовательность символов), если она в нём есть
+static bool matchesFilter(const std::string& name, const char* pattern) {
+    if (std::strchr(pattern, '*') == nullptr) {
+        return name.find(pattern) != std::string::npos;
+    }
+    const char* s = name.c_str();
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*s != '\0') {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = s;
+        } else if (*pattern == *s) {
+            ++pattern;
+            ++s;
+        } else if (star != nullptr) {
+            pattern = star + 1;
+            s = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        ++pattern;
+    }
+    return *pattern == '\0';
+}
+
+int Tester::runAll(int argc, char* argv[]) {
+    const char* filter = nullptr;
+    unsigned shard = 0;
+    unsigned shards = 1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc &&
+                   std::sscanf(argv[++i], "%u/%u", &shard, &shards) == 2 && shard < shards) {
+            continue;
+        } else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc && std::atoi(argv[i + 1]) > 0) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "-l") == 0) {
+            list = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [-f pattern] [-s index/count] [-j threads] [-l]" << std::endl;
+            return 2;
+        }
+    }
+
+    // Выбор тестов: номер в части считается среди прошедших фильтр, чтобы части были равными
+    struct Selected {
+        const Test* test;
+        std::size_t set;
+        TestResult result;
+    };
+    std::vector<std::unique_ptr<Tester>> sets;
+    std::vector<Selected> selected;
+    std::size_t matched = 0;
+    for (Factory factory : getFactories()) {
+        sets.push_back(factory());
+        for (const auto& test : sets.back()->getTests()) {
+            std::string name = std::string(sets.back()->getName()) + '.' + test.name;
+            if (filter != nullptr && !matchesFilter(name, filter)) {
+                continue;
+            }
+            if (matched++ % shards == shard) {
+                selected.push_back({&test, sets.size() - 1, TestResult()});
+            }
+        }
+    }
+    if (list) {
+        for (const auto& entry : selected) {
+            std::cout << sets[entry.set]->getName() << '.' << entry.test->name << '\n';
+        }
+        return 0;
+    }
+
+    std::streambuf* coutBuffer = std::cout.rdbuf();
+    std::streambuf* cerrBuffer = std::cerr.rdbuf();
+    CaptureBuffer coutCapture(coutBuffer);
+    CaptureBuffer cerrCapture(cerrBuffer);
+    std::cout.rdbuf(&coutCapture);
+    std::cerr.rdbuf(&cerrCapture);
+    Clock::time_point start = Clock::now();
+
+    std::vector<Selected*> parallel;
+    std::vector<Selected*> serial;
+    for (auto& entry : selected) {
+        (entry.test->kind == KIND_PARALLEL ? parallel : serial).push_back(&entry);
+    }
+    std::atomic<std::size_t> next(0);
+    auto worker = [&parallel, &next]() {
+        for (std::size_t i; (i = next++) < parallel.size(); ) {
+            runTest(*parallel[i]->test, &parallel[i]->result);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < std::min<std::size_t>(threads, parallel.size()); ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    for (Selected* entry : serial) {
+        runTest(*entry->test, &entry->result);
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
 
     int failed = 0;
     int succeded = 0;
-
-    for (const auto& test : tests_) {
+    for (std::size_t i = 0; i < selected.size(); ) {
+        std::size_t set = selected[i].set;
         {
-            ANSIMod m(BLUE);
-            std::cerr << "Running test " << test.name << std::endl;
-        }
-        bool ok = test.test();
-        if (ok) {
-            ANSIMod m(GREEN);
-            std::cerr << "TEST OK" << std::endl;
-            ++succeded;
-        } else {
-            ANSIMod m(RED);
-            std::cerr << "TEST FAILED" << std::endl;
-            ++failed;
+            ANSIMod m(YELLOW);
+            std::cerr << "Test set " << sets[set]->getName() << std::endl;
+            std::cerr << "Running tests" << std::endl;
+        }
+        int setFailed = 0;
+        int setSucceded = 0;
+        for (; i < selected.size() && selected[i].set == set; ++i) {
+            const Test& test = *selected[i].test;
+            const TestResult& result = selected[i].result;
+            {
+                ANSIMod m(BLUE);
+                std::cerr << "Running test " << test.name << std::endl;
+            }
+            std::cerr << result.output;
+            if (test.kind == KIND_BENCH && result.ok) {
+                std::cerr << formatBench(result.seconds) << std::endl;
+            }
+            if (result.ok) {
+                ANSIMod m(GREEN);
+                double total = 0;
+                for (double x : result.seconds) {
+                    total += x;
+                }
+                std::cerr << "TEST OK (" << formatTime(total) << ')' << std::endl;
+                ++setSucceded;
+            } else {
+                ANSIMod m(RED);
+                std::cerr << "TEST FAILED" << std::endl;
+                ++setFailed;
+            }
+        }
+        {
+            ANSIMod m(YELLOW);
+            std::cerr << "========== Done! ==========" << std::endl;
         }
+        std::cerr << "Total: " << (setFailed + setSucceded) << ", Succeeded: " << setSucceded
+                  << ", Failed: " << setFailed << std::endl;
+        failed += setFailed;
+        succeded += setSucceded;
     }
     {
-        ANSIMod m(YELLOW);
-        std::cerr << "========== Done! ==========" << std::endl;
+        ANSIMod m(failed == 0 ? GREEN : RED);
+        std::cerr << "All sets: " << (failed + succeded) << " tests, Succeeded: " << succeded
+                  << ", Failed: " << failed << ", " << formatTime(seconds) << std::endl;
     }
-    std::cerr << "Total: " << (failed + succeded) << ", Succeeded: " << succeded << ", Failed: " << failed << std::endl;
+    return failed == 0 ? 0 : 1;
 }